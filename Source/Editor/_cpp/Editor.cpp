@@ -5,16 +5,21 @@
 #include "MemoryTracker.h"
 #include "GpuMemoryTracker.h"
 #include "EditorFileManager.h"
+#include "StartupGraph.h"
 
 
 void Editor::StartUp()
 {
 	TIMER_LOG("Editor::StartUp()")
+	MEMORY_TAG_SCOPE(MT_EDITOR)
 
-    // Set Working directory, for project files, and core directory, for editor resources
-    EditorFileManager::SetupWorkingAndCoreDirectories();
-    // Register the .layer file extension with the OS to open up the editor
-    EditorFileManager::RegisterFileExtension();
+    // Set Working directory, for project files, and core directory, for editor resources. The logger needs it before it starts.
+    {
+        STARTUP_STAGE("File System Setup")
+        EditorFileManager::SetupWorkingAndCoreDirectories();
+    }
+    // Register the .layer file extension with the OS to open up the editor, on a worker while the engine starts
+    StartupGraph::AddStage("Register File Extension", []() { EditorFileManager::RegisterFileExtension(); });
     
     // Start the engine with a default window name and size
 	Engine::StartUp("Layer Editor", 1280, 720);
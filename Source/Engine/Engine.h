@@ -4,7 +4,10 @@
 
 namespace Engine
 {
-	void StartUp(const char* appName, u32 winWidth, u32 winHeight);
+	// bHeadless renders winWidth x winHeight frames offscreen without a window, for servers/CI/benchmarks (see RenderManager::ReadbackFrame)
+	void StartUp(const char* appName, u32 winWidth, u32 winHeight, bool bHeadless = false);
 	void Run();
+	// One iteration of Run()'s loop, for hosts that drive frames themselves (LayerBench)
+	void RunFrame();
 	void Shutdown();
 }
\ No newline at end of file
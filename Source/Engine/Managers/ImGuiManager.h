@@ -1,10 +1,7 @@
 #pragma once
 #include "ThirdParty.h"
 #include "Broadcaster.h"
-
-// Forward Declares
-struct VkRef;
-struct SwapChainImage;
+#include "VkTypes.h"
 
 namespace ImGuiManager
 {
@@ -16,12 +13,22 @@ namespace ImGuiManager
     // Path to imgui config file (Path/to/imguiConfig.ini). Set by Editor/Game FileManager
     inline T_string imguiConfigFilePath = {};
 
+	// Context, style and font atlas rasterization. CPU only, so startup runs it on a worker alongside device creation.
+	void CreateImguiContext();
+	// Vulkan/GLFW back ends and the font upload, needs CreateImguiContext() done and the main thread (GLFW callbacks)
 	void SetupImgui(const VkRef& vkRef);
 	void StartImguiFrame();
 	void SubmitImGuiVulkanCommands(VkCommandBuffer cmdBuffer, u32 frameIndex);
+
+	// SubmitImGuiVulkanCommands() in pieces, for passes whose contents are recorded into secondary buffers.
+	// RecordImGuiDrawData() can run on any thread once StartImguiFrame() has returned.
+	void BeginImGuiRenderPass(VkCommandBuffer cmdBuffer, u32 frameIndex, VkSubpassContents contents);
+	void RecordImGuiDrawData(VkCommandBuffer cmdBuffer);
+	VkRenderPass GetImGuiRenderPass();
+	VkFramebuffer GetImGuiFrameBuffer(u32 frameIndex);
 	void EndImguiFrame();
 	void ShutdownImgui(const VkRef& vkRef);
-	void CreateImGuiFrameBuffer(const VkRef& vkRef, const T_vector<SwapChainImage, MT_GRAPHICS>& swapChainImages, VkExtent2D swapChainExtent);
+	void CreateImGuiFrameBuffer(const VkRef& vkRef, const SwapChainImageList& swapChainImages, VkExtent2D swapChainExtent);
  
  
 	// Temp TODO: DELETE ME
@@ -1,12 +1,33 @@
 #pragma once
 #include "ThirdParty.h"
+#include "LayerContainers.h"
+#include "ParallelRecorder.h"
 
 
 namespace RenderManager
 {
-	void Initialize(const char* appName, u32 winWidth, u32 winHeight);
+	// bHeadless skips the window, surface and swap chain (and ImGui) and renders winWidth x winHeight frames into offscreen images instead
+	void Initialize(const char* appName, u32 winWidth, u32 winHeight, bool bHeadless = false);
 	void Shutdown();
 	bool WindowsShouldClose();
 	void DrawFrame();
-}
 
+	// Queues a draw for the next DrawFrame(), main thread only. pUserData has to stay valid until that DrawFrame() returns.
+	// Draws run in submission order but are recorded in parallel once there are enough of them (see ParallelRecorder.h).
+	void SubmitDraw(ParallelRecorder::RecordDrawFn pRecord, const void* pUserData = nullptr);
+
+	// Makes WindowsShouldClose() return true, the only way out of the main loop when headless
+	void RequestClose();
+	bool IsHeadless();
+
+	// Frames the CPU records ahead of the GPU, 1 to VkConfig::maxFramesInFlight. Independent of the swap chain's image count,
+	// fewer cuts input latency and more absorbs frame time spikes. Only takes effect before Engine::StartUp().
+	void SetFramesInFlight(u32 numFrames);
+	u32 GetFramesInFlight();
+
+	// Headless only. Waits for the last drawn frame and copies it into outPixels as RGBA/BGRA 8 bit rows (see GetRenderFormat()).
+	// Returns false if not headless or nothing has been drawn yet.
+	bool ReadbackFrame(T_vector<u8, MT_GRAPHICS>& outPixels);
+	VkExtent2D GetRenderExtent();
+	VkFormat GetRenderFormat();
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "ThirdParty.h"
+#include "LayerContainers.h"
+#include "GpuMemoryTracker.h"
+#include "VkConfig.h"
+
+// Forward Declares
+struct VkRef;
+
+// Headless stand in for the swap chain. Frames render into VMA allocated color images (one per frame in flight) that are left
+// in TRANSFER_SRC layout so they can be copied back to host memory instead of being presented.
+class OffscreenTarget
+{
+public:
+	OffscreenTarget() = default;
+	~OffscreenTarget() = default;
+
+	void CreateOffscreenTarget(const VkRef& vkRef, VkExtent2D extent);
+	void DestroyOffscreenTarget(const VkRef& vkRef);
+
+	// Begins the render pass that clears image imageIndex, commands recorded until EndRenderPass draw into it.
+	// With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS those commands can only be vkCmdExecuteCommands.
+	void BeginRenderPass(VkCommandBuffer cmdBuffer, u32 imageIndex, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const;
+	void EndRenderPass(VkCommandBuffer cmdBuffer) const;
+
+	// Copies image imageIndex into outPixels as tightly packed rows of Format(), bytesPerPixel each. Blocks until the copy is done,
+	// the GPU must already be finished rendering the image.
+	void ReadbackImage(const VkRef& vkRef, u32 imageIndex, T_vector<u8, MT_GRAPHICS>& outPixels);
+
+	//Getters
+	[[nodiscard]] VkRenderPass GetRenderPass() const { return m_RenderPass; }
+	[[nodiscard]] VkFramebuffer GetFrameBuffer(u32 imageIndex) const { return m_FrameBuffers[imageIndex]; }
+	[[nodiscard]] VkFormat Format() const { return m_Format; }
+	[[nodiscard]] VkExtent2D Extent() const { return m_Extent; }
+	[[nodiscard]] u64 Size() const { return m_Images.size(); }
+
+	void SetClearColor(const VkClearColorValue& clearColor) { m_ClearColor = clearColor; }
+
+public:
+	// Every 32 bit pack color attachment format is 4 bytes a pixel
+	static constexpr u32 bytesPerPixel = 4;
+
+private:
+	void CreateReadbackBuffer(const VkRef& vkRef);
+
+private:
+	VkRenderPass m_RenderPass = VK_NULL_HANDLE;
+	VkFormat m_Format = VK_FORMAT_UNDEFINED;
+	VkExtent2D m_Extent = {};
+	VkClearColorValue m_ClearColor = { { 0.301f, 0.341f, 0.411f, 1.0f } };
+
+	T_small_vector<GpuImage, VkConfig::inlineSwapChainImages, MT_GRAPHICS> m_Images;
+	T_small_vector<VkFramebuffer, VkConfig::inlineSwapChainImages, MT_GRAPHICS> m_FrameBuffers;
+
+	// Host visible copy target, created on the first ReadbackImage so render only runs don't pay for it
+	VkBuffer m_ReadbackBuffer = VK_NULL_HANDLE;
+	VmaAllocation m_ReadbackAllocation = VK_NULL_HANDLE;
+	void* m_pReadbackData = nullptr;
+	VkCommandBuffer m_ReadbackCmdBuffer = VK_NULL_HANDLE;
+	VkFence m_ReadbackFence = VK_NULL_HANDLE;
+};
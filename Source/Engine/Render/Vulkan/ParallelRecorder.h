@@ -0,0 +1,44 @@
+#pragma once
+#include "ThirdParty.h"
+#include "LayerContainers.h"
+#include "VkTypes.h"
+#include <span>
+
+
+// --PARALLEL RECORDER--
+// Records a frame's draw list across threads. The list is cut into contiguous slices and each slice is recorded into a SECONDARY
+// command buffer by one thread (the caller takes the first slice, persistent "Render Worker" threads the rest), from that thread's
+// own pool in the frame's FrameContext. The primary buffer then runs the slices in draw order with vkCmdExecuteCommands.
+// Lists too short to be worth splitting are recorded by the caller alone.
+namespace ParallelRecorder
+{
+	// Records one draw into cmdBuffer, which is already inside the pass being drawn. Runs on any recording thread, so it may only
+	// read shared state.
+	using RecordDrawFn = void(*)(VkCommandBuffer cmdBuffer, const void* pUserData);
+
+	struct DrawItem
+	{
+		RecordDrawFn pRecord = nullptr;
+		const void* pUserData = nullptr;
+	};
+
+	// Recording threads (caller included) are capped here, and a slice is never shorter than minDrawsPerSlice draws
+	constexpr u32 maxRecordingThreads = 32;
+	constexpr u32 minDrawsPerSlice = 64;
+
+	// Caps the recording threads, 0 picks one per core. Only takes effect before InitializeParallelRecorder().
+	void SetThreadCount(u32 numThreads);
+
+	// Starts the workers and creates each frame context's per thread pools, needs the frame contexts
+	void InitializeParallelRecorder(VkRef& vkRef);
+
+	// Device must be idle
+	void ShutdownParallelRecorder(VkRef& vkRef);
+
+	// Recording threads, caller included
+	u32 GetThreadCount();
+
+	// Records draws for subpass 0 of renderPass/frameBuffer and returns the secondary buffers to execute, in order. The frame's fence
+	// must have been waited on and its secondary pools reset. Blocks until every slice is recorded.
+	std::span<const VkCommandBuffer> RecordDraws(const FrameContext& frame, VkRenderPass renderPass, VkFramebuffer frameBuffer, std::span<const DrawItem> draws);
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "ThirdParty.h"
+
+// Forward Declares
+struct VkRef;
+
+// Engine wide VkPipelineCache (VkRef::pipelineCache) persisted to Cache/PipelineCache.bin. The file is only used when it was written
+// on the same GPU (vendor/device id, driver version and pipeline cache UUID) and its data hashes the same as when it was saved, drivers
+// aren't required to survive corrupt cache data. Every pipeline creation should pass VkRef::pipelineCache.
+namespace PipelineCache
+{
+	// Reads the cache file into memory, doesn't need the device so startup runs it alongside instance/device creation
+	void LoadPipelineCacheFile();
+
+	// Creates VkRef::pipelineCache, seeded with the loaded file if it matches this device, and frees the file data
+	void CreatePipelineCache(VkRef& vkRef);
+
+	// Merges in whatever another instance saved since we loaded, writes the result over the file and destroys the cache
+	void SaveAndDestroyPipelineCache(VkRef& vkRef);
+
+	// True if CreatePipelineCache() was seeded from disk, pipelines created this run should mostly be cache hits
+	bool IsWarm();
+}
@@ -2,6 +2,7 @@
 #include "ThirdParty.h"
 #include "LayerContainers.h"
 #include "GpuMemoryTracker.h"
+#include "VkConfig.h"
 
 // Forward Declares
 struct VkRef;
@@ -29,10 +30,10 @@ private:
 private:
 	VkRenderPass m_RenderPass = {};
  
-	T_vector<GpuImage, MT_GRAPHICS> m_ColorImages;
+	T_small_vector<GpuImage, VkConfig::inlineSwapChainImages, MT_GRAPHICS> m_ColorImages;
 
-	T_vector<GpuImage, MT_GRAPHICS> m_DepthImages;
+	T_small_vector<GpuImage, VkConfig::inlineSwapChainImages, MT_GRAPHICS> m_DepthImages;
 
-	T_vector<VkFramebuffer, MT_GRAPHICS> m_FrameBuffers;
+	T_small_vector<VkFramebuffer, VkConfig::inlineSwapChainImages, MT_GRAPHICS> m_FrameBuffers;
 };
 
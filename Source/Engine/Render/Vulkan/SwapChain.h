@@ -1,10 +1,10 @@
 #pragma once
 #include "ThirdParty.h"
 #include "LayerContainers.h"
+#include "VkTypes.h"
 
 // Forward Declares
 struct VkRef;
-struct SwapChainImage;
 
 class SwapChain
 {
@@ -21,7 +21,7 @@ public:
 	VkSwapchainKHR GetHandle() { return m_SwapChain; }
 	VkSwapchainKHR* GetPtr() { return &m_SwapChain; }
 	[[nodiscard]] u64 Size() const;
-	[[nodiscard]] T_vector<SwapChainImage, MT_GRAPHICS> GetImages() const;
+	[[nodiscard]] const SwapChainImageList& GetImages() const { return m_SwapChainImages; }
 	[[nodiscard]] VkExtent2D Extent() const { return m_SwapChainExtent; }
 	[[nodiscard]] bool WindowIsMinimized() const { return m_bWindowMinimized; }
 
@@ -34,7 +34,7 @@ private:
 	VkFormat m_SwapChainFormat = {};
 	VkExtent2D m_SwapChainExtent = {};
 
-	T_vector<SwapChainImage, MT_GRAPHICS> m_SwapChainImages = {};
+	SwapChainImageList m_SwapChainImages = {};
 
 	bool m_bWindowMinimized = false;
 };
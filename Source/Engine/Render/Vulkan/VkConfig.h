@@ -3,6 +3,12 @@
  
 namespace VkConfig
 {
+	// -INLINE CONTAINER SIZES-
+	// Inline capacity of per swap chain image/per frame in flight lists (T_small_vector), going past these just spills to the heap
+	constexpr u32 inlineSwapChainImages = 4;
+	constexpr u32 inlineFramesInFlight = 4;
+	constexpr u32 inlineRecordingThreads = 8;
+
 	// -PHYSICAL DEVICE CONFIG-
 	constexpr VkPhysicalDeviceFeatures desiredDeviceFeatures = {
 		.robustBufferAccess							= VK_FALSE,
@@ -62,11 +68,21 @@ namespace VkConfig
 		.inheritedQueries							= VK_FALSE
 	};
 
-	constexpr std::array<const char*, 2> desiredDeviceExtensions = {
-		VK_KHR_SWAPCHAIN_EXTENSION_NAME,
+	constexpr std::array<const char*, 1> desiredDeviceExtensions = {
 		VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME
 	};
 
+	// Only required when presenting to a window, headless devices don't need them
+	constexpr std::array<const char*, 1> presentDeviceExtensions = {
+		VK_KHR_SWAPCHAIN_EXTENSION_NAME
+	};
+
+	// -FRAMES IN FLIGHT-
+	// Frames the CPU can record ahead of the GPU, independent of the swap chain's image count (see RenderManager::SetFramesInFlight()).
+	// More absorbs CPU/GPU spikes for throughput, fewer cuts input latency.
+	constexpr u32 defaultFramesInFlight = 2;
+	constexpr u32 maxFramesInFlight = 8;		// Frame arena block count
+
 	// -SURFACE FORMATS-
 	constexpr std::array<VkFormat, 4> desiredSurfaceFormats = {
 		VK_FORMAT_R8G8B8A8_UNORM,
@@ -11,7 +11,10 @@ namespace VkSetup
 	void CreateLogicalDevice(VkRef& vkRef);
 	void CreateVmaAllocator(VkRef& vkRef);
 	void CreateCommandPools(VkRef& vkRef);
-	void AllocateCommandBuffers(VkRef& vkRef);
+
+	// Creates vkRef.numInFlightFrames FrameContexts (command pools/buffers, semaphore and fence) into vkRef.frames
+	void CreateFrameContexts(VkRef& vkRef);
+	void DestroyFrameContexts(VkRef& vkRef);
 }
 
 
@@ -1,7 +1,10 @@
 #pragma once
 #include "Logger.h"
 #include "MemoryTracker.h"
+#include "AllocationSampler.h"
+#include "MemoryTimeline.h"
 #include "GpuMemoryTracker.h"
+#include "Profiler.h"
 
 
 namespace EngineUtilities
@@ -10,12 +13,18 @@ namespace EngineUtilities
 	{
 		// ImGuiManger Gets setup in the Render Manager since it require Vulkan prerequisites
         Logger::InitializeLogging();
+        Profiler::InitializeProfiler();
         MemoryTracker::InitializeMemoryTracker();
+        AllocationSampler::InitializeAllocationSampler();
+        MemoryTimeline::InitializeMemoryTimeline();
         GpuMemoryTracker::InitializeGpuMemoryTracker();
 	}
 
 	inline void ShutdownEngineUtilities()
 	{
+		AllocationSampler::ShutdownAllocationSampler();
+		MemoryTimeline::ShutdownMemoryTimeline();
+		Profiler::ShutdownProfiler();
 		Logger::ShutdownLogging();
 	}
 }
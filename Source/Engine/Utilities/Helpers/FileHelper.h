@@ -10,6 +10,9 @@ namespace FileHelper
     // If Game: It should be the root directory of the game.
 	inline T_string currentWorkingDirectory = {};
 
+	// Folder, relative to the current working directory, for data the engine can always rebuild (pipeline/device caches)
+	constexpr const char* cacheFolderPath = "Cache\\";
+
 	// Create a folder, if it doesn't exist, with an absolute path or a path relative to the current working directory (FileHelper::currentWorkingDirectory), does nothing if it does exist.
 	void CreateFolderIfAbsent(const char* folderPath, bool bFromCurrentWorkingDirectory = true);
 
@@ -19,5 +22,11 @@ namespace FileHelper
 	// Writes string buffer to given file either with an absolute path or a path relative to the current working directory (FileHelper::currentWorkingDirectory)
 	void WriteStringToFile(const T_string& str, const char* filePath, bool bFromCurrentWorkingDirectory = true);
 
+	// Reads a whole file into outBytes (any T_vector<u8>), false if it doesn't exist or couldn't be read
+	bool ReadBinaryFile(const char* filePath, std::vector<u8, LayerAllocator<u8>>& outBytes, bool bFromCurrentWorkingDirectory = true);
+
+	// Writes to filePath.tmp then renames it over filePath, so a crash mid write never leaves a truncated file behind. False on failure.
+	bool WriteBinaryFileAtomic(const void* pData, u64 size, const char* filePath, bool bFromCurrentWorkingDirectory = true);
+
 } // namespace FileHelper
 
@@ -0,0 +1,56 @@
+#pragma once
+#include "ThirdParty.h"
+#include "LayerContainers.h"
+#include "Profiler.h"
+
+
+// --STARTUP GRAPH--
+// Startup split into named stages with dependencies. Run() executes every stage whose dependencies are done at the same time,
+// worker stages on a short lived pool of threads and main thread stages (anything touching GLFW windows/callbacks) on the caller.
+// Stages added before Engine::StartUp() run in the engine's graph, so hosts can overlap their own setup with the renderer's.
+// Every stage, in a graph or timed in place with STARTUP_STAGE(), goes into the breakdown LogBreakdown() writes to the session log.
+// Graph stages are also profiler zones, on a "Startup Worker" track when they ran on a worker.
+namespace StartupGraph
+{
+	using StageHandle = u32;
+
+	// Dependency that's ignored, for stages that only exist in some configurations (e.g. the window when headless)
+	constexpr StageHandle noStage = U32_MAX;
+
+	// Upper bound on the worker pool, startup doesn't have more independent work than this
+	constexpr u32 maxWorkerThreads = 4;
+
+	// Adds a stage that runs on a worker once every stage in dependencies has finished. name must be a string literal.
+	// The stage runs under the memory tag that's current on the calling thread.
+	StageHandle AddStage(const char* name, std::function<void()> work, std::initializer_list<StageHandle> dependencies = {});
+
+	// Same as AddStage(), but always runs on the thread that calls Run()
+	StageHandle AddMainThreadStage(const char* name, std::function<void()> work, std::initializer_list<StageHandle> dependencies = {});
+
+	// Runs every added stage and returns once they're all done. The graph is empty again afterward.
+	void Run();
+
+	// Times a stage that ran outside a graph, used by STARTUP_STAGE()
+	void RecordStage(const char* name, u64 begin, u64 end);
+
+	// Writes every recorded stage (start, duration, thread) and the total startup time to the session log and clears the records
+	void LogBreakdown();
+
+	class ScopedStage
+	{
+	public:
+		explicit ScopedStage(const char* name) : m_Name(name), m_Begin(Profiler::Now()) {}
+		~ScopedStage() { RecordStage(m_Name, m_Begin, Profiler::Now()); }
+
+		ScopedStage(const ScopedStage&) = delete;
+		ScopedStage& operator=(const ScopedStage&) = delete;
+
+	private:
+		const char* m_Name;
+		u64 m_Begin;
+	};
+}
+
+// Times the rest of the scope as a sequential startup stage named name (a string literal). Unlike graph stages it isn't a profiler
+// zone, these can run before the profiler is initialized.
+#define STARTUP_STAGE(name) StartupGraph::ScopedStage _MACRO_CONCAT( startupStage, __LINE__ )(name);
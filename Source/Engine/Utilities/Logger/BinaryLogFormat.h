@@ -0,0 +1,298 @@
+#pragma once
+// Only include std headers, LayerLogDecoder builds this without the engine
+#include "ConstantsAndAliases.h"
+#include <array>
+#include <charconv>
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+
+// --BINARY LOG FORMAT--
+// With LAYER_USE_BINARY_LOG the structured loggers (LOG_*_FMT) skip formatting and write Logs/SessionLog.bin instead. A call site's
+// severity/file/line/function/format/argument types are constexpr and go in the file once, every message after that is only the
+// site id, a timestamp and the raw argument bytes. LayerLogDecoder turns the file back into text.
+//
+// File: BinaryLogFileHeader, then records that each start with a BinaryLogRecordType byte
+//	BLOG_RECORD_SITE:		u32 siteId, u32 severity, u32 line, u8 numArgs, u8 argTypes[numArgs], then file, function and format as u16 length + chars
+//	BLOG_RECORD_MESSAGE:	u32 siteId, u64 timestamp (steady clock ns), then each argument (see EncodeBinaryLogArg())
+// Everything is little endian and unaligned.
+
+constexpr char binaryLogMagic[8] = { 'L', 'A', 'Y', 'E', 'R', 'L', 'O', 'G' };
+constexpr u32 binaryLogVersion = 1;
+
+struct BinaryLogFileHeader
+{
+	char magic[8];
+	u32 version;
+	u32 reserved;
+	u64 startTimestamp;		// Steady clock ns when logging started, the decoder prints message times relative to it
+};
+
+enum BinaryLogRecordType : u8
+{
+	BLOG_RECORD_SITE,
+	BLOG_RECORD_MESSAGE
+};
+
+enum BinaryLogArgType : u8
+{
+	BLOG_ARG_I32,
+	BLOG_ARG_U32,
+	BLOG_ARG_I64,
+	BLOG_ARG_U64,
+	BLOG_ARG_F64,		// f32 is widened
+	BLOG_ARG_BOOL,
+	BLOG_ARG_CHAR,
+	BLOG_ARG_STRING,	// u16 length + chars, no terminator
+	BLOG_ARG_POINTER,
+	BLOG_ARG_MAX		// Do not use except for limit checks
+};
+
+// Longer string arguments are truncated
+constexpr u64 maxBinaryLogStringArg = 512;
+
+// Bytes before a message's arguments: type, site id and timestamp
+constexpr u64 binaryLogMessageHeaderSize = sizeof(u8) + sizeof(u32) + sizeof(u64);
+
+// Everything the log needs to know about a structured log call site, built at compile time by the LOG_*_FMT macros
+struct BinaryLogSite
+{
+	u32 severity;			// LogSeverityLevel
+	u32 line;
+	const char* file;
+	const char* function;
+	const char* format;		// Each "{}" is replaced by the next argument
+	const u8* argTypes;		// BinaryLogArgType per argument
+	u8 numArgs;
+};
+
+// Anything with data()/size() of chars (T_string, std::string_view etc.)
+template <typename T>
+concept BinaryLogStringLike = requires(const T& string)
+{
+	{ string.data() } -> std::convertible_to<const char*>;
+	{ string.size() } -> std::convertible_to<u64>;
+};
+
+template <typename T>
+consteval BinaryLogArgType BinaryLogArgTypeOf()
+{
+	if constexpr (std::is_same_v<T, bool>)					{ return BLOG_ARG_BOOL; }
+	else if constexpr (std::is_same_v<T, char>)				{ return BLOG_ARG_CHAR; }
+	else if constexpr (std::is_enum_v<T>)					{ return BinaryLogArgTypeOf<std::underlying_type_t<T>>(); }
+	else if constexpr (std::is_integral_v<T>)
+	{
+		if constexpr (std::is_signed_v<T>)					{ return sizeof(T) <= sizeof(i32) ? BLOG_ARG_I32 : BLOG_ARG_I64; }
+		else												{ return sizeof(T) <= sizeof(u32) ? BLOG_ARG_U32 : BLOG_ARG_U64; }
+	}
+	else if constexpr (std::is_floating_point_v<T>)			{ return BLOG_ARG_F64; }
+	else if constexpr (std::is_same_v<T, const char*> || std::is_same_v<T, char*> || BinaryLogStringLike<T>) { return BLOG_ARG_STRING; }
+	else if constexpr (std::is_pointer_v<T>)				{ return BLOG_ARG_POINTER; }
+	else
+	{
+		static_assert(std::is_pointer_v<T>, "Structured log arguments must be arithmetic, enums, strings or pointers");
+		return BLOG_ARG_MAX;
+	}
+}
+
+template <typename... ARGS>
+struct BinaryLogArgList
+{
+	static constexpr std::array<u8, sizeof...(ARGS)> types = { BinaryLogArgTypeOf<std::decay_t<ARGS>>()... };
+
+	// Room for a whole message, every string argument at the max length
+	static constexpr u64 maxRecordSize = binaryLogMessageHeaderSize + sizeof...(ARGS) * (sizeof(u16) + maxBinaryLogStringArg);
+};
+
+// Never called, the LOG_*_FMT macros use it in decltype() to get a call's BinaryLogArgList
+template <typename... ARGS>
+BinaryLogArgList<ARGS...> _BinaryLogArgListOf(const ARGS&...);
+
+#define _BINARY_LOG_ARG_TYPES(...)														\
+		decltype(_BinaryLogArgListOf(__VA_ARGS__))::types.data(),						\
+		static_cast<u8>(decltype(_BinaryLogArgListOf(__VA_ARGS__))::types.size())
+
+// Writes arg at pOut and returns the end of it. pOut needs sizeof(u16) + maxBinaryLogStringArg bytes of room.
+template <typename T>
+u8* EncodeBinaryLogArg(u8* pOut, const T& arg)
+{
+	using ARG = std::decay_t<T>;
+	constexpr BinaryLogArgType argType = BinaryLogArgTypeOf<ARG>();
+
+	const auto write = [&pOut](const auto value)
+	{
+		memcpy(pOut, &value, sizeof(value));
+		pOut += sizeof(value);
+	};
+
+	if constexpr (argType == BLOG_ARG_STRING)
+	{
+		const char* pString = nullptr;
+		u64 length = 0;
+		if constexpr (BinaryLogStringLike<ARG>)
+		{
+			pString = arg.data();
+			length = arg.size();
+		}
+		else if (arg != nullptr)
+		{
+			pString = arg;
+			length = strlen(arg);
+		}
+
+		length = length < maxBinaryLogStringArg ? length : maxBinaryLogStringArg;
+		write(static_cast<u16>(length));
+		memcpy(pOut, pString, length);
+		pOut += length;
+	}
+	else if constexpr (argType == BLOG_ARG_POINTER)	{ write(reinterpret_cast<u64>(arg)); }
+	else if constexpr (argType == BLOG_ARG_BOOL)	{ write(static_cast<u8>(arg)); }
+	else if constexpr (argType == BLOG_ARG_CHAR)	{ write(arg); }
+	else if constexpr (argType == BLOG_ARG_I32)		{ write(static_cast<i32>(arg)); }
+	else if constexpr (argType == BLOG_ARG_U32)		{ write(static_cast<u32>(arg)); }
+	else if constexpr (argType == BLOG_ARG_I64)		{ write(static_cast<i64>(arg)); }
+	else if constexpr (argType == BLOG_ARG_U64)		{ write(static_cast<u64>(arg)); }
+	else if constexpr (argType == BLOG_ARG_F64)		{ write(static_cast<f64>(arg)); }
+
+	return pOut;
+}
+
+// Builds a whole BLOG_RECORD_MESSAGE in pOut (BinaryLogArgList<ARGS...>::maxRecordSize bytes), returns its size
+template <typename... ARGS>
+u64 EncodeBinaryLogMessage(u8* pOut, u32 siteId, u64 timestamp, const ARGS&... args)
+{
+	u8* pArg = pOut;
+	*pArg++ = BLOG_RECORD_MESSAGE;
+	memcpy(pArg, &siteId, sizeof(siteId));
+	pArg += sizeof(siteId);
+	memcpy(pArg, &timestamp, sizeof(timestamp));
+	pArg += sizeof(timestamp);
+
+	((pArg = EncodeBinaryLogArg(pArg, args)), ...);
+	return static_cast<u64>(pArg - pOut);
+}
+
+// Appends site's BLOG_RECORD_SITE to out (T_string or std::string)
+template <typename STRING>
+void AppendBinaryLogSiteRecord(STRING& out, u32 siteId, const BinaryLogSite& site)
+{
+	const auto append = [&out](const auto value) { out.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+	const auto appendString = [&out, &append](const char* pString)
+	{
+		const u16 length = static_cast<u16>(pString != nullptr ? strnlen(pString, U16_MAX) : 0);
+		append(length);
+		out.append(pString != nullptr ? pString : "", length);
+	};
+
+	append(static_cast<u8>(BLOG_RECORD_SITE));
+	append(siteId);
+	append(site.severity);
+	append(site.line);
+	append(site.numArgs);
+	out.append(reinterpret_cast<const char*>(site.argTypes), site.numArgs);
+	appendString(site.file);
+	appendString(site.function);
+	appendString(site.format);
+}
+
+// Returns the end of the argument of argType at pArg, nullptr if the record ends first
+inline const u8* SkipBinaryLogArg(u8 argType, const u8* pArg, const u8* pEnd)
+{
+	u64 size = 0;
+	switch (argType)
+	{
+		case BLOG_ARG_I32: case BLOG_ARG_U32:							size = sizeof(u32); break;
+		case BLOG_ARG_I64: case BLOG_ARG_U64: case BLOG_ARG_F64:		size = sizeof(u64); break;
+		case BLOG_ARG_POINTER:											size = sizeof(u64); break;
+		case BLOG_ARG_BOOL: case BLOG_ARG_CHAR:							size = sizeof(u8); break;
+		case BLOG_ARG_STRING:
+		{
+			u16 length;
+			if (pEnd - pArg < static_cast<i64>(sizeof(length))) { return nullptr; }
+			memcpy(&length, pArg, sizeof(length));
+			size = sizeof(length) + length;
+			break;
+		}
+		default: return nullptr;
+	}
+
+	return pEnd - pArg < static_cast<i64>(size) ? nullptr : pArg + size;
+}
+
+// Reads one argument of argType at pArg and appends it as text, returns the end of it or nullptr if the record ends first
+template <typename STRING>
+const u8* AppendBinaryLogArgText(STRING& out, u8 argType, const u8* pArg, const u8* pEnd)
+{
+	const auto read = [&pArg, pEnd](auto& value)
+	{
+		if (pArg == nullptr || pEnd - pArg < static_cast<i64>(sizeof(value))) { pArg = nullptr; return false; }
+		memcpy(&value, pArg, sizeof(value));
+		pArg += sizeof(value);
+		return true;
+	};
+
+	char text[32];
+	const auto appendNumber = [&out, &text](const auto value)
+	{
+		const std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+		out.append(text, result.ptr - text);
+	};
+
+	switch (argType)
+	{
+		case BLOG_ARG_I32:		{ i32 value; if (read(value)) { appendNumber(value); } break; }
+		case BLOG_ARG_U32:		{ u32 value; if (read(value)) { appendNumber(value); } break; }
+		case BLOG_ARG_I64:		{ i64 value; if (read(value)) { appendNumber(value); } break; }
+		case BLOG_ARG_U64:		{ u64 value; if (read(value)) { appendNumber(value); } break; }
+		case BLOG_ARG_F64:		{ f64 value; if (read(value)) { out.append(text, snprintf(text, sizeof(text), "%g", value)); } break; }
+		case BLOG_ARG_BOOL:		{ u8 value; if (read(value)) { out.append(value != 0 ? "true" : "false"); } break; }
+		case BLOG_ARG_CHAR:		{ char value; if (read(value)) { out.append(1, value); } break; }
+		case BLOG_ARG_POINTER:	{ u64 value; if (read(value)) { out.append(text, snprintf(text, sizeof(text), "0x%llx", static_cast<unsigned long long>(value))); } break; }
+		case BLOG_ARG_STRING:
+		{
+			u16 length;
+			if (!read(length)) { break; }
+			if (pEnd - pArg < length) { return nullptr; }
+			out.append(reinterpret_cast<const char*>(pArg), length);
+			pArg += length;
+			break;
+		}
+		default: return nullptr;
+	}
+
+	return pArg;
+}
+
+// Appends format with each "{}" replaced by the next encoded argument in [pArgs, pEnd), returns the end of the arguments or nullptr if
+// the record is cut short. Placeholders without an argument are left as is.
+template <typename STRING>
+const u8* AppendBinaryLogMessageText(STRING& out, const char* format, const u8* argTypes, u8 numArgs, const u8* pArgs, const u8* pEnd)
+{
+	u8 argIndex = 0;
+	const char* pText = format;
+
+	while (const char* pPlaceholder = strstr(pText, "{}"))
+	{
+		out.append(pText, pPlaceholder - pText);
+		pText = pPlaceholder + 2;
+
+		if (argIndex == numArgs || pArgs == nullptr)
+		{
+			out.append("{}");
+			continue;
+		}
+		pArgs = AppendBinaryLogArgText(out, argTypes[argIndex++], pArgs, pEnd);
+	}
+	out.append(pText);
+
+	// Skip arguments the format had no placeholder for
+	for (; argIndex < numArgs && pArgs != nullptr; argIndex++)
+	{
+		pArgs = SkipBinaryLogArg(argTypes[argIndex], pArgs, pEnd);
+	}
+
+	return pArgs;
+}
@@ -2,6 +2,7 @@
 #include "ThirdParty.h"
 #include "LayerContainers.h"
 #include "Broadcaster.h"
+#include "BinaryLogFormat.h"
 #include "vk_enum_string_helper.h"
 
 
@@ -26,26 +27,97 @@ namespace Logger
 	{
 		ImVec4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
 		T_string text;
+		LogSeverityLevel severity = LOG_SEVERITY_INFO;
 	};
 
+	// Path relative to the current working directory to place the session log
+	constexpr const char* sessionLogPath = "Logs\\SessionLog.txt";
+
 	// Keeps track of any shutdown functions needed for exit so we can call them in case of a fatal error log
 	inline Broadcaster<void()> fatalShutdownBroadcaster;
 
-	// Used to initialize Layer logging
+	// Used to initialize Layer logging, opens the session log and starts the log writer thread
 	void InitializeLogging();
 
-	// Called when logging window is called, does final write to log file.
+	// Stops the log writer thread and flushes everything queued. Logs after this are drained to disk by the thread logging them.
 	void ShutdownLogging();
 
+	// Blocks until every queued log line has been formatted, written to the session log and handed to the live logger.
+	// Called on FATAL before exiting, and by producers when the ring is full.
+	void FlushLogging();
+
 	// Updates session log file.
 	void AddToSessionLogFile(const char* message);
 	void AddToSessionLogFile(const T_string& message);
 
-	// Prints to log and adds to buffer that will be added to log file.
+	// Queues the message for the log writer thread. Copies into a preallocated lock free ring, never allocates.
 	void PrintLog(LogSeverityLevel severityLevel, const char* message);
 
 	// PrintLog that can take a T_string. Just passes message.c_str() to main PrintLog()
 	void PrintLog(LogSeverityLevel severityLevel, const T_string& message);
+
+	// PrintLog with location info. file/function must be string literals (__FILE__ etc.), only their pointers are queued.
+	void PrintLog(LogSeverityLevel severityLevel, const char* message, const char* file, u32 line, const char* function);
+	void PrintLog(LogSeverityLevel severityLevel, const T_string& message, const char* file, u32 line, const char* function);
+
+	// Rate limiting for messages that can repeat every frame (validation layers, LOG_*_LIMITED). Each key gets a small burst of messages
+	// per second, the rest are dropped before any formatting and summarized as "Repeated N more times: <message>" once the second is up.
+	// Returns false if this occurrence of key should be dropped. Thread safe.
+	bool PassRateLimit(LogSeverityLevel severityLevel, u64 key);
+
+	// PrintLog for a message that passed PassRateLimit(), remembers the key's first message for its summary lines and the Log window
+	void PrintRateLimitedLog(LogSeverityLevel severityLevel, u64 key, const char* message, const char* file, u32 line, const char* function);
+	void PrintRateLimitedLog(LogSeverityLevel severityLevel, u64 key, const T_string& message, const char* file, u32 line, const char* function);
+
+	// Rate limit key for a log call site
+	inline u64 SiteRateLimitKey(const char* file, u32 line) { return reinterpret_cast<u64>(file) ^ (static_cast<u64>(line) << 48); }
+
+	// Gives a structured log site its id in the binary log. Called once per site by the LOG_*_FMT macros, thread safe.
+	u32 RegisterBinaryLogSite(const BinaryLogSite& site);
+
+	// Queues an encoded BLOG_RECORD_MESSAGE for Logs/SessionLog.bin, the writer thread only formats it for the live logger
+	void PrintBinaryRecord(LogSeverityLevel severityLevel, const u8* record, u64 size);
+
+	// Formats a structured log site's message now and prints it like any other log
+	template <typename... ARGS>
+	void PrintFormattedLog(const BinaryLogSite& site, const ARGS&... args)
+	{
+		u8 record[BinaryLogArgList<ARGS...>::maxRecordSize];
+		const u64 size = EncodeBinaryLogMessage(record, 0, 0, args...);
+
+		T_string message;
+		AppendBinaryLogMessageText(message, site.format, site.argTypes, site.numArgs, record + binaryLogMessageHeaderSize, record + size);
+
+		// Same as the plain loggers, WARNING and up get location info
+		const LogSeverityLevel severityLevel = static_cast<LogSeverityLevel>(site.severity);
+		if (severityLevel <= LOG_SEVERITY_WARNING)
+		{
+			PrintLog(severityLevel, message, site.file, site.line, site.function);
+		}
+		else
+		{
+			PrintLog(severityLevel, message);
+		}
+	}
+
+	// Encodes a structured log site's arguments for the binary log, formatting is left to LayerLogDecoder
+	template <typename... ARGS>
+	void PrintBinaryLog(u32 siteId, const BinaryLogSite& site, const ARGS&... args)
+	{
+		static_assert(sizeof...(ARGS) <= 12, "Structured logs take at most 12 arguments, a record has to fit the log ring");
+
+		// FATAL/ERROR need their text right away for the popup
+		if (site.severity <= LOG_SEVERITY_ERROR) [[unlikely]]
+		{
+			PrintFormattedLog(site, args...);
+			return;
+		}
+
+		const u64 timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		u8 record[BinaryLogArgList<ARGS...>::maxRecordSize];
+		const u64 size = EncodeBinaryLogMessage(record, siteId, timestamp, args...);
+		PrintBinaryRecord(static_cast<LogSeverityLevel>(site.severity), record, size);
+	}
  
 } // namespace Logger
 
@@ -53,10 +125,33 @@ namespace Logger
 
 // -Helper Macros
 #define _PRINT_MESSAGE_INFO(severity, message_in)		\
-		Logger::PrintLog(severity, T_string(message_in, \
-			" >>> Line: ", std::to_string(__LINE__),	\
-			" | File: ", __FILE__,						\
-			" | Function: ", __PRETTY_FUNCTION__));
+		Logger::PrintLog(severity, message_in, __FILE__, __LINE__, __PRETTY_FUNCTION__);
+
+// Structured log site with constexpr metadata. With LAYER_USE_BINARY_LOG only its id and raw arguments are written at runtime.
+#ifdef LAYER_USE_BINARY_LOG
+#define _PRINT_FORMATTED(severity, format, ...)																		\
+	{																												\
+		static constexpr BinaryLogSite _logSite = { severity, __LINE__, __FILE__, __PRETTY_FUNCTION__, format,		\
+			_BINARY_LOG_ARG_TYPES(__VA_ARGS__) };																	\
+		static const u32 _logSiteId = Logger::RegisterBinaryLogSite(_logSite);										\
+		Logger::PrintBinaryLog(_logSiteId, _logSite __VA_OPT__(,) __VA_ARGS__);										\
+	}
+#else
+#define _PRINT_FORMATTED(severity, format, ...)																		\
+	{																												\
+		static constexpr BinaryLogSite _logSite = { severity, __LINE__, __FILE__, __PRETTY_FUNCTION__, format,		\
+			_BINARY_LOG_ARG_TYPES(__VA_ARGS__) };																	\
+		Logger::PrintFormattedLog(_logSite __VA_OPT__(,) __VA_ARGS__);												\
+	}
+#endif // LAYER_USE_BINARY_LOG
+
+// Drops the message (without evaluating it) once its call site passes the rate limit
+#define _PRINT_RATE_LIMITED(severity, message_in)															\
+	if (Logger::PassRateLimit(severity, Logger::SiteRateLimitKey(__FILE__, __LINE__)))						\
+	{																										\
+		Logger::PrintRateLimitedLog(severity, Logger::SiteRateLimitKey(__FILE__, __LINE__), message_in,		\
+			__FILE__, __LINE__, __PRETTY_FUNCTION__);														\
+	}
 
 // -Basic loggers (Log File + Live)
 #define LOG_FATAL(message)						_PRINT_MESSAGE_INFO(LOG_SEVERITY_FATAL, message);	// Send a FATAL log message with location info
@@ -72,6 +167,11 @@ namespace Logger
 #define LOG_ERROR_MIN_IF(condition, message)	if(condition){ Logger::PrintLog(LOG_SEVERITY_ERROR, message); }		// Send a ERROR log message without location info if condition is true
 #define LOG_WARNING_IF(condition, message)		if(condition){ _PRINT_MESSAGE_INFO(LOG_SEVERITY_WARNING, message); }// Send a WARNING log message with location info if condition is true
 #define LOG_WARNING_MIN_IF(condition, message)	if(condition){ Logger::PrintLog(LOG_SEVERITY_WARNING, message); }	// Send a WARNING log message without location info if condition is true
+// -Rate limited loggers (Log File + Live), for call sites that can fire every frame. Repeats past the limit are counted in the Log window.
+#define LOG_ERROR_LIMITED(message)				_PRINT_RATE_LIMITED(LOG_SEVERITY_ERROR, message)	// Send a rate limited ERROR log message with location info
+#define LOG_WARNING_LIMITED(message)			_PRINT_RATE_LIMITED(LOG_SEVERITY_WARNING, message)	// Send a rate limited WARNING log message with location info
+// -Structured loggers (Log File/Binary Log + Live), each "{}" in the format literal is replaced by the next argument
+#define LOG_WARNING_FMT(format, ...)			_PRINT_FORMATTED(LOG_SEVERITY_WARNING, format __VA_OPT__(,) __VA_ARGS__)	// Send a structured WARNING log message with location info
 
 
 // Prints assertion log FATAL if ptr == nullptr (Log File + Live)
@@ -117,6 +217,12 @@ namespace Logger
 #define LOG_INFO_IF(condition, message)			if(condition){ Logger::PrintLog(LOG_SEVERITY_INFO, message); }			// Send a INFO log message if condition is true
 #define LOG_BENCHMARK_IF(condition, message)	if(condition){ Logger::PrintLog(LOG_SEVERITY_BENCHMARK, message); }		// Send a BENCHMARK log message if condition is true
 #define LOG_OTHER_IF(condition, message)		if(condition){ Logger::PrintLog(LOG_SEVERITY_OTHER, message); }			// Send a OTHER log message if condition is true
+// -Structured loggers (Verbose)
+#define LOG_INFO_FMT(format, ...)				_PRINT_FORMATTED(LOG_SEVERITY_INFO, format __VA_OPT__(,) __VA_ARGS__)		// Send a structured INFO log message
+#define LOG_BENCHMARK_FMT(format, ...)			_PRINT_FORMATTED(LOG_SEVERITY_BENCHMARK, format __VA_OPT__(,) __VA_ARGS__)	// Send a structured BENCHMARK log message
+#define LOG_OTHER_FMT(format, ...)				_PRINT_FORMATTED(LOG_SEVERITY_OTHER, format __VA_OPT__(,) __VA_ARGS__)		// Send a structured OTHER log message
+// -Rate limited loggers (Verbose)
+#define LOG_INFO_LIMITED(message)				_PRINT_RATE_LIMITED(LOG_SEVERITY_INFO, message)		// Send a rate limited INFO log message
 
 
 // --NO VERBOSE LOGGER--
@@ -127,6 +233,10 @@ namespace Logger
 #define LOG_INFO_IF(condition, message)	
 #define LOG_BENCHMARK_IF(condition, message)
 #define LOG_OTHER_IF(condition, message)
+#define LOG_INFO_FMT(format, ...)
+#define LOG_BENCHMARK_FMT(format, ...)
+#define LOG_OTHER_FMT(format, ...)
+#define LOG_INFO_LIMITED(message)
 #endif // defined(LAYER_USE_VERBOSE_LOGGER)
 
 
@@ -134,6 +244,7 @@ namespace Logger
 #ifdef LAYER_DEBUG
 #define LOG_DEBUG(message)					Logger::PrintLog(LOG_SEVERITY_DEBUG, message);					// Send a DEBUG log message, disabled in non-debug builds
 #define LOG_DEBUG_IF(condition, message)	if(condition){ Logger::PrintLog(LOG_SEVERITY_DEBUG, message); }	// Send a DEBUG log message if condition is true, disabled in non-debug builds
+#define LOG_DEBUG_FMT(format, ...)			_PRINT_FORMATTED(LOG_SEVERITY_DEBUG, format __VA_OPT__(,) __VA_ARGS__)	// Send a structured DEBUG log message, disabled in non-debug builds
 
 // Prints assertion log DEBUG if condition doesn't evaluate to true, disabled in non-debug builds
 #define ASSERT_TRUE_DEBUG(condition)																			\
@@ -146,6 +257,7 @@ namespace Logger
 #else // Define all Debug logging macros to blank in release mode
 #define LOG_DEBUG(message)	
 #define LOG_DEBUG_IF(condition, message)	
+#define LOG_DEBUG_FMT(format, ...)
 #define ASSERT_TRUE_DEBUG(condition)
 #endif // LAYER_DEBUG
 
@@ -0,0 +1,52 @@
+#pragma once
+#include "ThirdParty.h"
+#include "MemoryTracker.h"
+
+
+// --ALLOCATION SAMPLER--
+// Poisson sampling profiler for host allocations (same idea as tcmalloc's heap sampler). Every tracked allocation counts
+// down a per thread byte budget, when it runs out the call stack is captured and charged to its call site, then a new
+// exponentially distributed budget is drawn. Cost for unsampled allocations is a TLS subtract and compare.
+// Only compiled with LAYER_MEMORY_TRACKING=ON, since it hooks MemoryTracker::AllocatedHostMemory().
+namespace AllocationSampler
+{
+	// Default mean number of bytes between samples. Keeps overhead low enough to leave sampling on in staging builds.
+	constexpr u64 defaultSampleInterval = 512 * KiB;
+
+	// Max frames stored per sample (after skipping the tracker/sampler frames)
+	constexpr u32 maxStackDepth = 32;
+
+	// Register the sampler UI. Sampling starts enabled if the build defines LAYER_USE_ALLOCATION_SAMPLING.
+	void InitializeAllocationSampler();
+
+	// Writes the folded stacks next to the session log if anything was sampled
+	void ShutdownAllocationSampler();
+
+	// Start sampling on average every meanSampleBytes allocated on each thread. 0 disables sampling.
+	void SetSampleInterval(u64 meanSampleBytes);
+
+	// Drop every site gathered so far
+	void ClearSamples();
+
+	// Writes samples in folded stack format ("outer;...;inner <bytes>"), ready for flamegraph.pl / speedscope.
+	// Path is relative to the current working directory. Returns false if there was nothing to write.
+	bool ExportFoldedStacks(const char* filePath);
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+	// Bytes left on this thread before the next sample. Starts at 0 so each thread draws its first budget on first use.
+	inline constinit thread_local i64 bytesUntilNextSample = 0;
+
+	// Slow path, captures the stack and charges the call site. Don't call directly.
+	void _RecordSample(MemoryTrackerTag tag, u64 sizeOfAlloc);
+
+	// Called by MemoryTracker::AllocatedHostMemory() for every tracked allocation
+	inline void SampleAllocation(MemoryTrackerTag tag, u64 sizeOfAlloc)
+	{
+		bytesUntilNextSample -= static_cast<i64>(sizeOfAlloc);
+		if (bytesUntilNextSample <= 0) [[unlikely]]
+		{
+			_RecordSample(tag, sizeOfAlloc);
+		}
+	}
+#endif
+}
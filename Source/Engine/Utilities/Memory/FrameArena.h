@@ -0,0 +1,79 @@
+#pragma once
+#include "ThirdParty.h"
+#include "MemoryTracker.h"
+
+
+// --FRAME ARENA--
+// Linear (bump) allocator with one block per frame in flight. A frame's block is reset wholesale once its draw fence
+// has been waited on, so anything allocated from it stays alive while the GPU could still be reading it.
+namespace FrameArena
+{
+	// Default size of each frame's block. Allocations past this spill over to the tracked heap.
+	constexpr u64 defaultFrameCapacity = 4 * MiB;
+
+	// Allocates one block per frame in flight. Memory is reported to the MemoryTracker under MT_TEMPORARY.
+	void InitializeFrameArena(u32 numInFlightFrames, u64 frameCapacity = defaultFrameCapacity);
+
+	// Frees every frame block. Any frame arena container still alive after this is invalid.
+	void ShutdownFrameArena();
+
+	// Resets the given frame's block and makes it the target of new allocations.
+	// Must only be called after the fence for that frame has signaled and while no other thread is allocating from the arena.
+	void BeginFrame(u32 frameIndex);
+
+	// Bump allocates from the active frame's block. Thread safe. Returns nullptr if the arena isn't initialized or the block is full.
+	void* Allocate(u64 size, u64 alignment);
+
+	// Returns true if the pointer lives inside any frame block.
+	bool Owns(const void* ptr);
+}
+
+// Allocator that Layer frame containers use. Memory comes from the active frame's arena block and is released in bulk
+// when that frame comes around again. Falls back to the tracked heap (MT_TEMPORARY) if the block is full, honoring alignof(TYPE) either way.
+template<typename TYPE>
+struct FrameArenaAllocator
+{
+	using value_type = TYPE;
+
+	FrameArenaAllocator() = default;
+
+	template<typename U>
+	explicit FrameArenaAllocator(const FrameArenaAllocator<U>&) {}
+
+	TYPE* allocate(size_t size)
+	{
+		const size_t bytes = size * sizeof(TYPE);
+		void* memory = FrameArena::Allocate(bytes, alignof(TYPE));
+		if (memory == nullptr) [[unlikely]]
+		{
+			MemoryTracker::AllocatedHostMemory(MT_TEMPORARY, bytes);
+			memory = _bOverAligned ? LayerMemory::AlignedMalloc(bytes, alignof(TYPE)) : LayerMemory::Allocate(bytes);
+		}
+		return static_cast<TYPE*>(memory);
+	}
+	void deallocate(TYPE* memory, size_t size) noexcept
+	{
+		// Arena memory is released when the frame block is reset, only spilled allocations need freeing
+		if (FrameArena::Owns(memory)) [[likely]] { return; }
+
+		MemoryTracker::DeallocatedHostMemory(MT_TEMPORARY, size * sizeof(TYPE));
+		if (_bOverAligned)
+		{
+			LayerMemory::AlignedFree(memory);
+		}
+		else
+		{
+			LayerMemory::Free(memory);
+		}
+	}
+
+private:
+	// The heap only guarantees max_align_t, anything stricter spills through AlignedMalloc
+	static constexpr bool _bOverAligned = alignof(TYPE) > alignof(std::max_align_t);
+};
+
+template<typename TYPE>
+inline bool operator==(FrameArenaAllocator<TYPE> const&, FrameArenaAllocator<TYPE> const&) { return true; }
+
+template<typename TYPE>
+inline bool operator!=(FrameArenaAllocator<TYPE> const&, FrameArenaAllocator<TYPE> const&) { return false; }
@@ -15,6 +15,7 @@ enum GpuMemoryUsageTag : u32
 	GPU_USAGE_SAMPLED_IMAGE,			// Read Only Shader Sampled Texture (0.0~1.0 Range)
 	GPU_USAGE_STORAGE_IMAGE,			// Read/Write Shader Sampled Texture (Pixel Coords i.e. (30,64))
 	GPU_USAGE_ATTACHMENT_IMAGE,			// Framebuffer Image Used By Render Pass (Access to only local fragment)
+	GPU_USAGE_READBACK_BUFFER,			// Host Visible Buffer Frames Get Copied Into To Be Read On The CPU
 	GPU_USAGE_MAX
 };
 
@@ -41,6 +42,9 @@ namespace GpuMemoryTracker
 	// Called anytime GPU memory is deallocated, so we can update the relevant tracking info.
 	void DeallocatedGpuMemory(GpuMemoryUsageTag tag, u64 sizeOfAlloc);
 
+	// Current allocation count/size for the given tag
+	const MemoryUsageInfo& GetGpuMemoryUsage(GpuMemoryUsageTag tag);
+
 	// Add the current GPU memory usage to the log file
 	void LogGpuMemoryUsage();
 }
@@ -5,71 +5,314 @@
 #pragma once
 #include "ThirdParty.h"
 #include "MemoryTracker.h"
+#include "FrameArena.h"
 
 
 // -MEMORY TRACKED CONTAINERS-
 
+// Allocator the Layer containers are built on. Plain std::allocator when LAYER_MEMORY_TRACKING=OFF so the containers
+// carry no tag and pay nothing per call.
+#ifdef LAYER_USE_MEMORY_TRACKING
+template <typename TYPE>
+using LayerAllocator = MemoryTrackerAllocator<TYPE>;
+#define _LAYER_ALLOCATOR(tag, ...) MemoryTrackerAllocator<__VA_ARGS__>{tag}
+#else
+template <typename TYPE>
+using LayerAllocator = std::allocator<TYPE>;
+#define _LAYER_ALLOCATOR(tag, ...) std::allocator<__VA_ARGS__>{}
+#endif
+
 // Memory tracked version of std::vector, template == <typename TYPE, MemoryTrackerTags tag>
 template <typename TYPE, MemoryTrackerTag tag = MT_TEMPORARY>
-struct T_vector : std::vector<TYPE, MemoryTrackerAllocator<TYPE>>
+struct T_vector : std::vector<TYPE, LayerAllocator<TYPE>>
 {
-#define size_type_t typename std::vector<TYPE, MemoryTrackerAllocator<TYPE>>::size_type
-#define vectorCtor std::vector<TYPE, MemoryTrackerAllocator<TYPE>>::vector
+#define size_type_t typename std::vector<TYPE, LayerAllocator<TYPE>>::size_type
+#define vectorCtor std::vector<TYPE, LayerAllocator<TYPE>>::vector
 
 	// Match all the std::vector constructor cases, call them, and add our allocator
-	T_vector() :										vectorCtor(MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(size_type_t count) :						vectorCtor(count, MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(size_type_t count, const TYPE& value) :	vectorCtor(count, value, MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(const auto& vec) :							vectorCtor(vec, MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(auto&& vec) :								vectorCtor(vec, MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(std::initializer_list<TYPE> init) :		vectorCtor(init, MemoryTrackerAllocator<TYPE>{tag}) {}
-	T_vector(auto it1, auto it2) :						vectorCtor(it1, it2, MemoryTrackerAllocator<TYPE>{tag}) {}
+	T_vector() :										vectorCtor(_LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(size_type_t count) :						vectorCtor(count, _LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(size_type_t count, const TYPE& value) :	vectorCtor(count, value, _LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(const auto& vec) :							vectorCtor(vec, _LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(auto&& vec) :								vectorCtor(vec, _LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(std::initializer_list<TYPE> init) :		vectorCtor(init, _LAYER_ALLOCATOR(tag, TYPE)) {}
+	T_vector(auto it1, auto it2) :						vectorCtor(it1, it2, _LAYER_ALLOCATOR(tag, TYPE)) {}
 
 #undef size_type_t // Make compiler happy
 };
 
 // Memory tracked version of std::unordered_map, template == <typename KEY, typename TYPE, MemoryTrackerTags tag>
 template <typename KEY, typename TYPE, MemoryTrackerTag tag = MT_TEMPORARY>
-struct T_unordered_map : std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>>
+struct T_unordered_map : std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, LayerAllocator<std::pair<const KEY, TYPE>>>
 {
-#define size_type_t typename std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>>::size_type
-#define unordered_mapCtor std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>>::unordered_map
+#define size_type_t typename std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, LayerAllocator<std::pair<const KEY, TYPE>>>::size_type
+#define unordered_mapCtor std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, LayerAllocator<std::pair<const KEY, TYPE>>>::unordered_map
 
 	// Match all the std::unordered_map constructor cases, call them, and add our allocator
-	T_unordered_map() :																						unordered_mapCtor(MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
-	T_unordered_map(size_type_t bucket_count) :																unordered_mapCtor(bucket_count, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
-	T_unordered_map(auto it1, auto it2, size_type_t bucket_count) :											unordered_mapCtor(it1, it2, bucket_count, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
-	T_unordered_map(const auto& other) :																	unordered_mapCtor(other, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
-	T_unordered_map(auto&& other) :																			unordered_mapCtor(other, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
-	T_unordered_map(std::initializer_list<std::pair<const KEY, TYPE>> init, size_type_t bucket_count) :		unordered_mapCtor(init, bucket_count, MemoryTrackerAllocator<std::pair<const KEY, TYPE>>{tag}) {}
+	T_unordered_map() :																						unordered_mapCtor(_LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
+	T_unordered_map(size_type_t bucket_count) :																unordered_mapCtor(bucket_count, _LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
+	T_unordered_map(auto it1, auto it2, size_type_t bucket_count) :											unordered_mapCtor(it1, it2, bucket_count, _LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
+	T_unordered_map(const auto& other) :																	unordered_mapCtor(other, _LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
+	T_unordered_map(auto&& other) :																			unordered_mapCtor(other, _LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
+	T_unordered_map(std::initializer_list<std::pair<const KEY, TYPE>> init, size_type_t bucket_count) :		unordered_mapCtor(init, bucket_count, _LAYER_ALLOCATOR(tag, std::pair<const KEY, TYPE>)) {}
 
 #undef size_type_t // Make compiler happy
 };
 
+// Memory tracked vector with inline storage for the first N elements, template == <typename TYPE, u32 N, MemoryTrackerTags tag>
+// Only touches the heap (through the tracked allocator) once it grows past N. Made for the many 1-8 element lists in render
+// setup (create infos, attachments, images, semaphores). Mirrors the T_vector API, moving a spilled vector steals its heap block.
+template <typename TYPE, u32 N, MemoryTrackerTag tag = MT_TEMPORARY>
+class T_small_vector
+{
+	static_assert(N > 0, "T_small_vector needs at least one inline element, use T_vector instead");
+
+public:
+	using value_type = TYPE;
+	using size_type = size_t;
+	using reference = TYPE&;
+	using const_reference = const TYPE&;
+	using iterator = TYPE*;
+	using const_iterator = const TYPE*;
+
+	// Match the T_vector constructor cases
+	T_small_vector() = default;
+	explicit T_small_vector(size_type count)				{ resize(count); }
+	T_small_vector(size_type count, const TYPE& value)		{ resize(count, value); }
+	T_small_vector(std::initializer_list<TYPE> init)		{ assign(init.begin(), init.end()); }
+	template<std::input_iterator IT>
+	T_small_vector(IT it1, IT it2)							{ assign(it1, it2); }
+	T_small_vector(const T_small_vector& other)				{ assign(other.begin(), other.end()); }
+	T_small_vector(T_small_vector&& other) noexcept			{ _TakeFrom(other); }
+
+	~T_small_vector()
+	{
+		clear();
+		_FreeHeapBlock();
+	}
+
+	T_small_vector& operator=(const T_small_vector& other)
+	{
+		if (this != &other)
+		{
+			assign(other.begin(), other.end());
+		}
+		return *this;
+	}
+
+	T_small_vector& operator=(T_small_vector&& other) noexcept
+	{
+		if (this != &other)
+		{
+			clear();
+			_FreeHeapBlock();
+			_TakeFrom(other);
+		}
+		return *this;
+	}
+
+	T_small_vector& operator=(std::initializer_list<TYPE> init)
+	{
+		assign(init.begin(), init.end());
+		return *this;
+	}
+
+	template<std::input_iterator IT>
+	void assign(IT it1, IT it2)
+	{
+		clear();
+		if constexpr (std::forward_iterator<IT>)
+		{
+			reserve(static_cast<size_type>(std::distance(it1, it2)));
+		}
+		for (; it1 != it2; ++it1)
+		{
+			emplace_back(*it1);
+		}
+	}
+
+	// Element access
+	TYPE& operator[](size_type index)						{ return m_pData[index]; }
+	const TYPE& operator[](size_type index) const			{ return m_pData[index]; }
+	TYPE& front()											{ return m_pData[0]; }
+	const TYPE& front() const								{ return m_pData[0]; }
+	TYPE& back()											{ return m_pData[m_Size - 1]; }
+	const TYPE& back() const								{ return m_pData[m_Size - 1]; }
+	TYPE* data()											{ return m_pData; }
+	const TYPE* data() const								{ return m_pData; }
+
+	// Iterators
+	iterator begin()										{ return m_pData; }
+	const_iterator begin() const							{ return m_pData; }
+	const_iterator cbegin() const							{ return m_pData; }
+	iterator end()											{ return m_pData + m_Size; }
+	const_iterator end() const								{ return m_pData + m_Size; }
+	const_iterator cend() const								{ return m_pData + m_Size; }
+
+	// Capacity
+	[[nodiscard]] bool empty() const						{ return m_Size == 0; }
+	[[nodiscard]] size_type size() const					{ return m_Size; }
+	[[nodiscard]] size_type capacity() const				{ return m_Capacity; }
+	// True while the elements still live in the inline buffer
+	[[nodiscard]] bool IsInline() const						{ return m_pData == _InlineData(); }
+
+	void reserve(size_type newCapacity)
+	{
+		if (newCapacity > m_Capacity)
+		{
+			_MoveToBlock(_AllocateBlock(newCapacity), newCapacity);
+		}
+	}
+
+	// Modifiers
+	void clear()
+	{
+		std::destroy(begin(), end());
+		m_Size = 0;
+	}
+
+	void resize(size_type count)
+	{
+		_Resize(count, [](TYPE* pElement) { new (pElement) TYPE(); });
+	}
+
+	void resize(size_type count, const TYPE& value)
+	{
+		_Resize(count, [&value](TYPE* pElement) { new (pElement) TYPE(value); });
+	}
+
+	void push_back(const TYPE& value)						{ emplace_back(value); }
+	void push_back(TYPE&& value)							{ emplace_back(std::move(value)); }
+
+	template<typename... Args>
+	TYPE& emplace_back(Args&&... args)
+	{
+		if (m_Size == m_Capacity) [[unlikely]]
+		{
+			// Construct into the new block before moving the old elements over, args may reference one of them
+			const size_type newCapacity = m_Capacity * 2;
+			TYPE* pNewBlock = _AllocateBlock(newCapacity);
+			new (pNewBlock + m_Size) TYPE(std::forward<Args>(args)...);
+			_MoveToBlock(pNewBlock, newCapacity);
+		}
+		else
+		{
+			new (m_pData + m_Size) TYPE(std::forward<Args>(args)...);
+		}
+		return m_pData[m_Size++];
+	}
+
+	void pop_back()
+	{
+		m_Size--;
+		std::destroy_at(m_pData + m_Size);
+	}
+
+	iterator erase(const_iterator pos)
+	{
+		iterator it = begin() + (pos - cbegin());
+		std::move(it + 1, end(), it);
+		pop_back();
+		return it;
+	}
+
+private:
+	TYPE* _InlineData()										{ return reinterpret_cast<TYPE*>(m_InlineStorage); }
+	const TYPE* _InlineData() const							{ return reinterpret_cast<const TYPE*>(m_InlineStorage); }
+
+	static TYPE* _AllocateBlock(size_type capacity)
+	{
+		return _LAYER_ALLOCATOR(tag, TYPE).allocate(capacity);
+	}
+
+	// Frees the heap block (if spilled) and points back at the inline buffer. Elements must already be destroyed/moved out.
+	void _FreeHeapBlock()
+	{
+		if (!IsInline())
+		{
+			_LAYER_ALLOCATOR(tag, TYPE).deallocate(m_pData, m_Capacity);
+			m_pData = _InlineData();
+			m_Capacity = N;
+		}
+	}
+
+	// Moves the elements into a new heap block, the element at m_Size may already be constructed in it
+	void _MoveToBlock(TYPE* pNewBlock, size_type newCapacity)
+	{
+		std::uninitialized_move(begin(), end(), pNewBlock);
+		std::destroy(begin(), end());
+		_FreeHeapBlock();
+		m_pData = pNewBlock;
+		m_Capacity = newCapacity;
+	}
+
+	void _Resize(size_type count, const auto& constructElement)
+	{
+		if (count < m_Size)
+		{
+			std::destroy(begin() + count, end());
+		}
+		else
+		{
+			reserve(count);
+			for (size_type i = m_Size; i < count; i++)
+			{
+				constructElement(m_pData + i);
+			}
+		}
+		m_Size = count;
+	}
+
+	// Steals other's heap block, or moves its elements if they're inline. Leaves other empty. We must be empty and inline.
+	void _TakeFrom(T_small_vector& other)
+	{
+		if (other.IsInline())
+		{
+			std::uninitialized_move(other.begin(), other.end(), _InlineData());
+			m_Size = other.m_Size;
+			other.clear();
+		}
+		else
+		{
+			m_pData = other.m_pData;
+			m_Size = other.m_Size;
+			m_Capacity = other.m_Capacity;
+			other.m_pData = other._InlineData();
+			other.m_Size = 0;
+			other.m_Capacity = N;
+		}
+	}
+
+	alignas(TYPE) std::byte m_InlineStorage[N * sizeof(TYPE)];
+	TYPE* m_pData = _InlineData();
+	size_type m_Size = 0;
+	size_type m_Capacity = N;
+};
+
 // Memory tracked version of std::basic_string, Always tagged MT_STRING, Use Typedef versions T_string and T_wstring
 template <typename TYPE>
-struct T_basicString : std::basic_string<TYPE, std::char_traits<TYPE>, MemoryTrackerAllocator<TYPE>>
+struct T_basicString : std::basic_string<TYPE, std::char_traits<TYPE>, LayerAllocator<TYPE>>
 {
-#define size_type_t typename std::basic_string<TYPE, std::char_traits<TYPE>, MemoryTrackerAllocator<TYPE>>::size_type
-#define stringCtor std::basic_string<TYPE, std::char_traits<TYPE>, MemoryTrackerAllocator<TYPE>>::basic_string
+#define size_type_t typename std::basic_string<TYPE, std::char_traits<TYPE>, LayerAllocator<TYPE>>::size_type
+#define stringCtor std::basic_string<TYPE, std::char_traits<TYPE>, LayerAllocator<TYPE>>::basic_string
 
 	typedef std::basic_string<TYPE>::iterator iterator;
 	static constexpr auto npos{ static_cast<std::basic_string<TYPE>::size_type>(-1) };
 
 	// Match all the std::string constructor cases, call them, and add our allocator
-	T_basicString() :															stringCtor(MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(const auto& str) :											stringCtor(str, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(const auto& str, size_type_t pos, size_type_t len = npos) :	stringCtor(str, pos, len, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(const TYPE* cstr) :											stringCtor(cstr, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(const TYPE* cstr, size_type_t copyNum) :						stringCtor(cstr, copyNum, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(size_type_t copyNum, TYPE fillChar) :							stringCtor(copyNum, fillChar, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(auto&& str) :													stringCtor(str, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(iterator it1, iterator it2) :									stringCtor(it1, it2, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
-	T_basicString(std::initializer_list<TYPE> init) :							stringCtor(init, MemoryTrackerAllocator<TYPE>{MT_STRING}) {}
+	T_basicString() :															stringCtor(_LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(const auto& str) :											stringCtor(str, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(const auto& str, size_type_t pos, size_type_t len = npos) :	stringCtor(str, pos, len, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(const TYPE* cstr) :											stringCtor(cstr, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(const TYPE* cstr, size_type_t copyNum) :						stringCtor(cstr, copyNum, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(size_type_t copyNum, TYPE fillChar) :							stringCtor(copyNum, fillChar, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(auto&& str) :													stringCtor(str, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(iterator it1, iterator it2) :									stringCtor(it1, it2, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
+	T_basicString(std::initializer_list<TYPE> init) :							stringCtor(init, _LAYER_ALLOCATOR(MT_STRING, TYPE)) {}
 
 	// Custom ctor that takes in any number of c strings/T_strings and appends them together
 	template<typename... Args>
-	T_basicString(const auto& first, const Args&... args) : stringCtor(first, MemoryTrackerAllocator<TYPE>{MT_STRING})
+	T_basicString(const auto& first, const Args&... args) : stringCtor(first, _LAYER_ALLOCATOR(MT_STRING, TYPE))
 	{
 		this->AppendMany(args...);
 	}
@@ -102,6 +345,18 @@ typedef T_basicString<char>		T_string;
 typedef T_basicString<w16>		T_wstring;
 
 
+// -FRAME ARENA CONTAINERS-
+// Only valid for the frame they were created in, memory is reclaimed in bulk when the frame's arena block is reset.
+
+// std::vector backed by the current frame's arena
+template <typename TYPE>
+using T_frame_vector = std::vector<TYPE, FrameArenaAllocator<TYPE>>;
+
+// std::unordered_map backed by the current frame's arena
+template <typename KEY, typename TYPE>
+using T_frame_unordered_map = std::unordered_map<KEY, TYPE, std::hash<KEY>, std::equal_to<KEY>, FrameArenaAllocator<std::pair<const KEY, TYPE>>>;
+
+
 
 #pragma clang diagnostic pop
 #pragma clang diagnostic pop
\ No newline at end of file
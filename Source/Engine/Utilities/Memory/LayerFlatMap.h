@@ -0,0 +1,506 @@
+#pragma once
+#include "ThirdParty.h"
+#include "MemoryTracker.h"
+#include "LayerContainers.h"
+
+
+// --FLAT MAP CONTROL GROUPS--
+// A control byte per slot: 0x80 == empty, else the low 7 bits of the key's hash (H2). There are no deleted markers,
+// erase backward-shifts the rest of the probe run instead. Groups are loaded unaligned so a probe can start at any slot.
+#if defined(__AVX2__)
+struct _FlatMapGroup
+{
+	static constexpr u32 width = 32;
+	static constexpr u32 shift = 0;		// Bitmask bit -> slot offset shift
+
+	explicit _FlatMapGroup(const u8* pCtrl) : m_Ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pCtrl))) {}
+
+	[[nodiscard]] u64 Match(u8 h2) const	{ return static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(m_Ctrl, _mm256_set1_epi8(static_cast<char>(h2))))); }
+	[[nodiscard]] u64 MatchEmpty() const	{ return static_cast<u32>(_mm256_movemask_epi8(m_Ctrl)); } // Only empty has the high bit set
+
+	__m256i m_Ctrl;
+};
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+struct _FlatMapGroup
+{
+	static constexpr u32 width = 16;
+	static constexpr u32 shift = 0;		// Bitmask bit -> slot offset shift
+
+	explicit _FlatMapGroup(const u8* pCtrl) : m_Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pCtrl))) {}
+
+	[[nodiscard]] u64 Match(u8 h2) const	{ return static_cast<u32>(_mm_movemask_epi8(_mm_cmpeq_epi8(m_Ctrl, _mm_set1_epi8(static_cast<char>(h2))))); }
+	[[nodiscard]] u64 MatchEmpty() const	{ return static_cast<u32>(_mm_movemask_epi8(m_Ctrl)); } // Only empty has the high bit set
+
+	__m128i m_Ctrl;
+};
+#else // Portable SWAR fallback (NEON/Android)
+struct _FlatMapGroup
+{
+	static constexpr u32 width = 8;
+	static constexpr u32 shift = 3;		// Matches land on each byte's high bit
+
+	explicit _FlatMapGroup(const u8* pCtrl) { memcpy(&m_Ctrl, pCtrl, sizeof(m_Ctrl)); }
+
+	// Can report a false positive next to a real match, callers always compare keys anyway
+	[[nodiscard]] u64 Match(u8 h2) const
+	{
+		constexpr u64 lsbs = 0x0101010101010101ULL;
+		const u64 x = m_Ctrl ^ (lsbs * h2);
+		return (x - lsbs) & ~x & (lsbs << 7);
+	}
+	[[nodiscard]] u64 MatchEmpty() const	{ return m_Ctrl & 0x8080808080808080ULL; }
+
+	u64 m_Ctrl;
+};
+#endif
+
+// Default hasher for T_flat_map. Strings hash through std::string_view so T_string, std::string_view and C strings can all be
+// used for lookups without building a T_string first.
+template <typename KEY>
+struct FlatMapHash : std::hash<KEY> {};
+
+template <>
+struct FlatMapHash<T_string>
+{
+	using is_transparent = void;
+	size_t operator()(std::string_view str) const { return std::hash<std::string_view>{}(str); }
+};
+
+
+// Memory tracked open addressing hash map, template == <typename KEY, typename TYPE, MemoryTrackerTags tag>
+// Keys and values live inline in one flat slot array (one tracked allocation per rehash, none per insert). Probing is linear,
+// a whole control group at a time (SSE2/AVX2 when available). Max load is 7/8.
+// Iterators and references are invalidated by any insert that rehashes and by erase of any element.
+template <typename KEY, typename TYPE, MemoryTrackerTag tag = MT_TEMPORARY, typename HASH = FlatMapHash<KEY>, typename EQUAL = std::equal_to<>>
+class T_flat_map
+{
+	static constexpr u8 _emptyCtrl = 0x80;
+	static constexpr bool _bTransparent = requires { typename HASH::is_transparent; };
+
+public:
+	using key_type = KEY;
+	using mapped_type = TYPE;
+	using value_type = std::pair<const KEY, TYPE>;
+	using size_type = size_t;
+
+	static_assert(alignof(value_type) <= 16, "T_flat_map slots are only 16 byte aligned");
+
+	// Walks slots starting just past an empty slot, so erasing through an iterator never moves an element it already visited
+	template <bool bConst>
+	class _Iterator
+	{
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = T_flat_map::value_type;
+		using difference_type = std::ptrdiff_t;
+		using pointer = std::conditional_t<bConst, const value_type*, value_type*>;
+		using reference = std::conditional_t<bConst, const value_type&, value_type&>;
+		using map_type = std::conditional_t<bConst, const T_flat_map, T_flat_map>;
+
+		_Iterator() = default;
+		_Iterator(map_type* pMap, size_type index) : m_pMap(pMap), m_Index(index) {}
+		operator _Iterator<true>() const { return _Iterator<true>(m_pMap, m_Index); }
+
+		reference operator*() const		{ return m_pMap->m_pSlots[m_Index]; }
+		pointer operator->() const		{ return &m_pMap->m_pSlots[m_Index]; }
+
+		_Iterator& operator++()
+		{
+			m_Index = m_pMap->_NextFullSlot(m_Index);
+			return *this;
+		}
+		_Iterator operator++(i32)
+		{
+			_Iterator previous = *this;
+			++*this;
+			return previous;
+		}
+
+		bool operator==(const _Iterator& other) const	{ return m_Index == other.m_Index; }
+
+	private:
+		friend class T_flat_map;
+		map_type* m_pMap = nullptr;
+		size_type m_Index = 0;			// Slot index, m_Capacity for end()
+	};
+
+	using iterator = _Iterator<false>;
+	using const_iterator = _Iterator<true>;
+
+	T_flat_map() = default;
+	explicit T_flat_map(size_type count)					{ reserve(count); }
+	T_flat_map(std::initializer_list<value_type> init)
+	{
+		reserve(init.size());
+		for (const value_type& value : init)
+		{
+			insert(value);
+		}
+	}
+	T_flat_map(const T_flat_map& other)
+	{
+		reserve(other.size());
+		for (const value_type& value : other)
+		{
+			insert(value);
+		}
+	}
+	T_flat_map(T_flat_map&& other) noexcept					{ _TakeFrom(other); }
+
+	~T_flat_map()
+	{
+		clear();
+		_FreeBlock();
+	}
+
+	T_flat_map& operator=(const T_flat_map& other)
+	{
+		if (this != &other)
+		{
+			clear();
+			reserve(other.size());
+			for (const value_type& value : other)
+			{
+				insert(value);
+			}
+		}
+		return *this;
+	}
+
+	T_flat_map& operator=(T_flat_map&& other) noexcept
+	{
+		if (this != &other)
+		{
+			clear();
+			_FreeBlock();
+			_TakeFrom(other);
+		}
+		return *this;
+	}
+
+	// Iterators
+	iterator begin()										{ return iterator(this, _NextFullSlot(m_IterationStart)); }
+	const_iterator begin() const							{ return const_iterator(this, _NextFullSlot(m_IterationStart)); }
+	const_iterator cbegin() const							{ return begin(); }
+	iterator end()											{ return iterator(this, m_Capacity); }
+	const_iterator end() const								{ return const_iterator(this, m_Capacity); }
+	const_iterator cend() const								{ return end(); }
+
+	// Capacity
+	[[nodiscard]] bool empty() const						{ return m_Size == 0; }
+	[[nodiscard]] size_type size() const					{ return m_Size; }
+	[[nodiscard]] size_type capacity() const				{ return m_Capacity; }
+
+	// Make room for count elements without rehashing
+	void reserve(size_type count)
+	{
+		size_type newCapacity = _FlatMapGroup::width;
+		while (_MaxLoad(newCapacity) < count)
+		{
+			newCapacity *= 2;
+		}
+		if (newCapacity > m_Capacity)
+		{
+			_Rehash(newCapacity);
+		}
+	}
+
+	// Lookup
+	iterator find(const KEY& key)							{ return iterator(this, _FindIndex(key)); }
+	const_iterator find(const KEY& key) const				{ return const_iterator(this, _FindIndex(key)); }
+	bool contains(const KEY& key) const						{ return _FindIndex(key) != m_Capacity; }
+	size_type count(const KEY& key) const					{ return contains(key) ? 1 : 0; }
+
+	// Heterogeneous lookup, only with a transparent HASH (e.g. T_string keys looked up by const char*/std::string_view)
+	template <typename K> requires _bTransparent
+	iterator find(const K& key)								{ return iterator(this, _FindIndex(key)); }
+	template <typename K> requires _bTransparent
+	const_iterator find(const K& key) const					{ return const_iterator(this, _FindIndex(key)); }
+	template <typename K> requires _bTransparent
+	bool contains(const K& key) const						{ return _FindIndex(key) != m_Capacity; }
+
+	TYPE& operator[](const KEY& key)						{ return try_emplace(key).first->second; }
+	TYPE& operator[](KEY&& key)								{ return try_emplace(std::move(key)).first->second; }
+
+	// Insertion, returns the element with that key and whether it was inserted
+	template <typename K, typename... Args>
+	std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+	{
+		const auto [index, bFound] = _FindOrPrepareInsert(key);
+		if (bFound)
+		{
+			return { iterator(this, index), false };
+		}
+
+		new (m_pSlots + index) value_type(std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)), std::forward_as_tuple(std::forward<Args>(args)...));
+		_FillSlot(index, _H2(_Hash(m_pSlots[index].first)));
+		return { iterator(this, index), true };
+	}
+
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args)
+	{
+		value_type value(std::forward<Args>(args)...);
+		return try_emplace(std::move(const_cast<KEY&>(value.first)), std::move(value.second));
+	}
+
+	std::pair<iterator, bool> insert(const value_type& value)	{ return try_emplace(value.first, value.second); }
+	std::pair<iterator, bool> insert(value_type&& value)		{ return try_emplace(std::move(const_cast<KEY&>(value.first)), std::move(value.second)); }
+
+	template <typename K, typename V>
+	std::pair<iterator, bool> insert_or_assign(K&& key, V&& value)
+	{
+		auto result = try_emplace(std::forward<K>(key), std::forward<V>(value));
+		if (!result.second)
+		{
+			result.first->second = std::forward<V>(value);
+		}
+		return result;
+	}
+
+	// Erase, backward shifts the rest of the probe run so no tombstones are left behind
+	size_type erase(const KEY& key)
+	{
+		const size_type index = _FindIndex(key);
+		if (index == m_Capacity) { return 0; }
+
+		_EraseIndex(index);
+		return 1;
+	}
+
+	// Returns the element after the erased one. Safe while iterating from begin(), nothing already visited gets moved.
+	iterator erase(const_iterator pos)
+	{
+		const size_type index = pos.m_Index;
+		_EraseIndex(index);
+
+		// The erased slot might have been refilled by the shift
+		return iterator(this, m_pCtrl[index] != _emptyCtrl ? index : _NextFullSlot(index));
+	}
+
+	void clear()
+	{
+		for (size_type i = 0; i < m_Capacity; i++)
+		{
+			if (m_pCtrl[i] != _emptyCtrl)
+			{
+				std::destroy_at(m_pSlots + i);
+			}
+		}
+		if (m_Capacity > 0)
+		{
+			memset(m_pCtrl, _emptyCtrl, m_Capacity + _FlatMapGroup::width);
+		}
+		m_Size = 0;
+		m_IterationStart = 0;
+	}
+
+private:
+	static constexpr size_type _MaxLoad(size_type capacity)	{ return capacity - capacity / 8; }
+
+	// std::hash is the identity for integers on most platforms, mix it so H1/H2 both get well distributed bits
+	template <typename K>
+	static u64 _Hash(const K& key)
+	{
+		u64 hash = static_cast<u64>(HASH{}(key));
+		hash = (hash ^ (hash >> 32)) * 0x9E3779B97F4A7C15ULL;
+		return hash ^ (hash >> 29);
+	}
+	static u8 _H2(u64 hash)									{ return static_cast<u8>(hash & 0x7F); }
+	size_type _Home(u64 hash) const							{ return static_cast<size_type>(hash >> 7) & (m_Capacity - 1); }
+
+	// Set a control byte and its mirror past the end (used by groups loaded near the end of the table)
+	void _SetCtrl(size_type index, u8 ctrl)
+	{
+		m_pCtrl[index] = ctrl;
+		if (index < _FlatMapGroup::width)
+		{
+			m_pCtrl[m_Capacity + index] = ctrl;
+		}
+	}
+
+	void _FillSlot(size_type index, u8 h2)
+	{
+		_SetCtrl(index, h2);
+		m_Size++;
+
+		// Iteration has to start past an empty slot, find a new one if we just filled it
+		if (index == m_IterationStart)
+		{
+			while (m_pCtrl[m_IterationStart] != _emptyCtrl)
+			{
+				m_IterationStart = (m_IterationStart + 1) & (m_Capacity - 1);
+			}
+		}
+	}
+
+	// Next full slot after index in iteration order, m_Capacity once it wraps back to m_IterationStart
+	size_type _NextFullSlot(size_type index) const
+	{
+		if (m_Size == 0) { return m_Capacity; }
+
+		const size_type mask = m_Capacity - 1;
+		for (index = (index + 1) & mask; index != m_IterationStart; index = (index + 1) & mask)
+		{
+			if (m_pCtrl[index] != _emptyCtrl)
+			{
+				return index;
+			}
+		}
+		return m_Capacity;
+	}
+
+	// Slot holding key, or m_Capacity if it isn't in the map
+	template <typename K>
+	size_type _FindIndex(const K& key) const
+	{
+		if (m_Size == 0) { return m_Capacity; }
+
+		const u64 hash = _Hash(key);
+		const u8 h2 = _H2(hash);
+		const size_type mask = m_Capacity - 1;
+
+		for (size_type pos = _Home(hash);; pos = (pos + _FlatMapGroup::width) & mask)
+		{
+			const _FlatMapGroup group(m_pCtrl + pos);
+			for (u64 match = group.Match(h2); match != 0; match &= match - 1)
+			{
+				const size_type index = (pos + (std::countr_zero(match) >> _FlatMapGroup::shift)) & mask;
+				if (EQUAL{}(m_pSlots[index].first, key)) [[likely]]
+				{
+					return index;
+				}
+			}
+
+			// Probe runs never skip an empty slot, so the key can't be further along
+			if (group.MatchEmpty() != 0)
+			{
+				return m_Capacity;
+			}
+		}
+	}
+
+	// First empty slot on hash's probe run. Load factor guarantees there is one.
+	size_type _FindFirstEmpty(u64 hash) const
+	{
+		const size_type mask = m_Capacity - 1;
+		for (size_type pos = _Home(hash);; pos = (pos + _FlatMapGroup::width) & mask)
+		{
+			const u64 empty = _FlatMapGroup(m_pCtrl + pos).MatchEmpty();
+			if (empty != 0)
+			{
+				return (pos + (std::countr_zero(empty) >> _FlatMapGroup::shift)) & mask;
+			}
+		}
+	}
+
+	// Returns {slot with key, true} or {empty slot to construct key in, false}, growing first if the insert would pass max load
+	template <typename K>
+	std::pair<size_type, bool> _FindOrPrepareInsert(const K& key)
+	{
+		const size_type foundIndex = _FindIndex(key);
+		if (foundIndex != m_Capacity)
+		{
+			return { foundIndex, true };
+		}
+
+		if (m_Size + 1 > _MaxLoad(m_Capacity)) [[unlikely]]
+		{
+			_Rehash(m_Capacity == 0 ? _FlatMapGroup::width : m_Capacity * 2);
+		}
+		return { _FindFirstEmpty(_Hash(key)), false };
+	}
+
+	void _EraseIndex(size_type index)
+	{
+		std::destroy_at(m_pSlots + index);
+		m_Size--;
+
+		// Pull back every later element of the run whose home isn't between the hole and itself
+		const size_type mask = m_Capacity - 1;
+		for (size_type next = (index + 1) & mask; m_pCtrl[next] != _emptyCtrl; next = (next + 1) & mask)
+		{
+			const size_type home = _Home(_Hash(m_pSlots[next].first));
+			if (((next - home) & mask) >= ((next - index) & mask))
+			{
+				_MoveSlot(next, index);
+				_SetCtrl(index, m_pCtrl[next]);
+				index = next;
+			}
+		}
+		_SetCtrl(index, _emptyCtrl);
+	}
+
+	// Move constructs dst from src and destroys src. Keys are only const to users, the map owns them.
+	void _MoveSlot(size_type src, size_type dst)
+	{
+		value_type& srcSlot = m_pSlots[src];
+		new (m_pSlots + dst) value_type(std::move(const_cast<KEY&>(srcSlot.first)), std::move(srcSlot.second));
+		std::destroy_at(&srcSlot);
+	}
+
+	static size_type _BlockSize(size_type capacity)			{ return capacity * sizeof(value_type) + capacity + _FlatMapGroup::width; }
+
+	void _Rehash(size_type newCapacity)
+	{
+		value_type* pOldSlots = m_pSlots;
+		u8* pOldCtrl = m_pCtrl;
+		const size_type oldCapacity = m_Capacity;
+
+		// Slots first so they keep malloc's alignment, control bytes (+ mirrored group) after
+		u8* pBlock = _LAYER_ALLOCATOR(tag, u8).allocate(_BlockSize(newCapacity));
+		m_pSlots = reinterpret_cast<value_type*>(pBlock);
+		m_pCtrl = pBlock + newCapacity * sizeof(value_type);
+		m_Capacity = newCapacity;
+		m_Size = 0;
+		m_IterationStart = 0;
+		memset(m_pCtrl, _emptyCtrl, newCapacity + _FlatMapGroup::width);
+
+		for (size_type i = 0; i < oldCapacity; i++)
+		{
+			if (pOldCtrl[i] == _emptyCtrl) { continue; }
+
+			value_type& oldSlot = pOldSlots[i];
+			const u64 hash = _Hash(oldSlot.first);
+			const size_type index = _FindFirstEmpty(hash);
+			new (m_pSlots + index) value_type(std::move(const_cast<KEY&>(oldSlot.first)), std::move(oldSlot.second));
+			std::destroy_at(&oldSlot);
+			_FillSlot(index, _H2(hash));
+		}
+
+		if (oldCapacity > 0)
+		{
+			_LAYER_ALLOCATOR(tag, u8).deallocate(reinterpret_cast<u8*>(pOldSlots), _BlockSize(oldCapacity));
+		}
+	}
+
+	// Elements must already be destroyed
+	void _FreeBlock()
+	{
+		if (m_Capacity > 0)
+		{
+			_LAYER_ALLOCATOR(tag, u8).deallocate(reinterpret_cast<u8*>(m_pSlots), _BlockSize(m_Capacity));
+		}
+		m_pSlots = nullptr;
+		m_pCtrl = nullptr;
+		m_Capacity = 0;
+		m_Size = 0;
+		m_IterationStart = 0;
+	}
+
+	// Steals other's block, we must be empty with no block
+	void _TakeFrom(T_flat_map& other)
+	{
+		m_pSlots = std::exchange(other.m_pSlots, nullptr);
+		m_pCtrl = std::exchange(other.m_pCtrl, nullptr);
+		m_Capacity = std::exchange(other.m_Capacity, 0);
+		m_Size = std::exchange(other.m_Size, 0);
+		m_IterationStart = std::exchange(other.m_IterationStart, 0);
+	}
+
+	value_type* m_pSlots = nullptr;
+	u8* m_pCtrl = nullptr;
+	size_type m_Capacity = 0;			// Power of two, at least one group wide once allocated
+	size_type m_Size = 0;
+	size_type m_IterationStart = 0;		// Always an empty slot, iteration runs from just past it all the way around
+};
@@ -34,7 +34,41 @@ namespace LayerMemory
 	#endif
 	}
 
-	
-} // namespace LayerMemory
+	// --LAYER HEAP--
+	// General purpose engine heap the global new overloads and MemoryTrackerAllocator sit on. A TLSF (two level segregated fit)
+	// core gives O(1) bounded latency malloc/free out of large pools, and per thread caches serve small blocks without taking
+	// the heap lock. Blocks are 16 byte aligned, anything over Allocate's large block limit goes straight to the system.
+
+	// Snapshot of the heap for the Memory window/session log
+	struct HeapStats
+	{
+		u64 reservedBytes = 0;			// Pool bytes taken from the system
+		u64 usedBytes = 0;				// Bytes in allocated pool blocks, including headers and blocks parked in thread caches
+		u64 freeBytes = 0;				// Bytes in free pool blocks
+		u64 largestFreeBlock = 0;		// Biggest single allocation the pools can serve without growing
+		u64 numFreeBlocks = 0;
+		u64 numPools = 0;
+		u64 largeBlockBytes = 0;		// Bytes in blocks too big for the pools, allocated straight from the system
+		u64 numLargeBlocks = 0;
+		u64 cacheRefills = 0;			// Times a thread cache went to the heap for more small blocks
+		u64 cacheReleases = 0;			// Times a thread cache handed small blocks back to the heap
+		f32 fragmentation = 0.0f;		// 0 when free pool memory is in as few blocks as the pools allow, close to 1 when it's scattered in small pieces
+	};
 
+#ifdef LAYER_USE_CUSTOM_HEAP
+	// Returns a 16 byte aligned block, nullptr only if the system is out of memory. Thread safe.
+	void* Allocate(size_t size);
+
+	// Frees a block from Allocate(), from any thread. nullptr is ignored.
+	void Free(void* ptr);
+
+	// Walks the heap's free lists under the heap lock, not meant for every frame
+	HeapStats GetHeapStats();
+#else
+	// Custom heap compiled out, straight to the system allocator
+	inline void* Allocate(size_t size)	{ return malloc(size); }
+	inline void Free(void* ptr)			{ free(ptr); }
+	inline HeapStats GetHeapStats()		{ return {}; }
+#endif
+} // namespace LayerMemory
 
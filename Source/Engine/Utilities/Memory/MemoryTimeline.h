@@ -0,0 +1,28 @@
+#pragma once
+#include "ThirdParty.h"
+#include "MemoryTracker.h"
+
+
+// --MEMORY TIMELINE--
+// Ring buffer of per frame host memory samples for every MemoryTrackerTag (bytes, allocs/frees that frame and high-water mark).
+// Used to spot allocation churn and peaks the live totals in the Memory window hide.
+namespace MemoryTimeline
+{
+	// Frames of history kept per tag
+	constexpr u32 timelineLength = 1024;
+
+	// Register the timeline UI and start the clock sample timestamps are relative to
+	void InitializeMemoryTimeline();
+
+	// Export the timeline next to the session log (Logs/MemoryTimeline.csv and Logs/MemoryTimeline.json)
+	void ShutdownMemoryTimeline();
+
+	// Snapshot every tag's counters into the ring. Call once per frame from the main loop.
+	void CaptureFrame();
+
+	// Writes the timeline as CSV (frame, time, tag, bytes, allocs, frees, high-water). Path is relative to the current working directory.
+	void ExportCSV(const char* filePath);
+
+	// Writes the timeline as Chrome trace counter events, open in chrome://tracing or Perfetto. Path is relative to the current working directory.
+	void ExportChromeTrace(const char* filePath);
+}
@@ -2,6 +2,8 @@
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "readability-redundant-declaration"
 #include "ThirdParty.h"
+#include "HelperTypes.h"
+#include "LayerMemory.h"
 
 enum MemoryTrackerTag : u32
 {
@@ -29,34 +31,101 @@ enum MemoryTrackerTag : u32
 	MT_MAX_VALUE
 };
 
-// Overload new and delete ops to capture third party/miscellaneous allocations/frees assigning them to MT_UNKNOWN
+#ifdef LAYER_USE_MEMORY_TRACKING
+// Overload new and delete ops to capture third party/miscellaneous allocations/frees assigning them to the thread's current
+// memory tag (MT_UNKNOWN unless inside a MEMORY_TAG_SCOPE). Each block carries a small header with its size and tag so
+// frees are credited back to the tag that allocated them, even from outside the scope.
 _Ret_notnull_ _Post_writable_byte_size_(size)
 void* __CRTDECL operator new(size_t _Size );
 
 _Ret_notnull_ _Post_writable_byte_size_(size)
 void* __CRTDECL operator new[](size_t size);
 
+_Ret_notnull_ _Post_writable_byte_size_(size)
+void* __CRTDECL operator new(size_t size, std::align_val_t alignment);
+
+_Ret_notnull_ _Post_writable_byte_size_(size)
+void* __CRTDECL operator new[](size_t size, std::align_val_t alignment);
+
+void __CRTDECL operator delete(void* memory) noexcept;
+
+void __CRTDECL operator delete[](void* memory) noexcept;
+
 void __CRTDECL operator delete(void* memory, size_t size) noexcept;
 
 void __CRTDECL operator delete[](void* memory,size_t size) noexcept;
 
+void __CRTDECL operator delete(void* memory, std::align_val_t alignment) noexcept;
+
+void __CRTDECL operator delete[](void* memory, std::align_val_t alignment) noexcept;
+
+void __CRTDECL operator delete(void* memory, size_t size, std::align_val_t alignment) noexcept;
+
+void __CRTDECL operator delete[](void* memory, size_t size, std::align_val_t alignment) noexcept;
+#endif
+
 // --MEMORY TRACKER--
 namespace MemoryTracker
 {
 	// Initialize memory tracker and setup everything it needs
 	void InitializeMemoryTracker();
 
+#ifdef LAYER_USE_MEMORY_TRACKING
 	// Called anytime host memory is allocated, so we can update the relevant tracking info.
+	// Lock free and thread safe, only bumps the calling thread's counter shard.
 	void AllocatedHostMemory(MemoryTrackerTag tag, u64 sizeOfAlloc);
 
 	// Called anytime host memory is deallocated, so we can update the relevant tracking info.
+	// Lock free and thread safe, only bumps the calling thread's counter shard.
 	void DeallocatedHostMemory(MemoryTrackerTag tag, u64 sizeOfAlloc);
+#else
+	// Tracking is compiled out, inline no-ops so manual accounting call sites fold away.
+	inline void AllocatedHostMemory([[maybe_unused]] MemoryTrackerTag tag, [[maybe_unused]] u64 sizeOfAlloc) {}
+	inline void DeallocatedHostMemory([[maybe_unused]] MemoryTrackerTag tag, [[maybe_unused]] u64 sizeOfAlloc) {}
+#endif
+
+	// Sums every counter shard for the given tag. Display label/size are set here instead of on every allocation.
+	// Always returns zeroed usage when tracking is compiled out.
+	MemoryUsageInfo GetHostMemoryUsage(MemoryTrackerTag tag);
 
 	// Add the current host memory usage to the log file
 	void LogMemoryUsage();
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+	// Tag the global new/delete overloads attribute allocations to on this thread. Set through MEMORY_TAG_SCOPE().
+	inline constinit thread_local MemoryTrackerTag currentThreadTag = MT_UNKNOWN;
+#endif
 }
 
-// Custom Allocator that Layer Containers use that tracks host memory usage via 'hostMemoryUsage'
+#ifdef LAYER_USE_MEMORY_TRACKING
+
+// RAII helper that sets the calling thread's memory tag and restores the previous one when it goes out of scope.
+// Scopes nest like a stack, the innermost scope wins.
+class MemoryTagScope
+{
+public:
+	explicit MemoryTagScope(MemoryTrackerTag tag)
+		: m_PreviousTag(MemoryTracker::currentThreadTag)
+	{
+		MemoryTracker::currentThreadTag = tag;
+	}
+	~MemoryTagScope() { MemoryTracker::currentThreadTag = m_PreviousTag; }
+
+	MemoryTagScope(const MemoryTagScope&) = delete;
+	MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+	MemoryTrackerTag m_PreviousTag;
+};
+
+// Attribute every untagged new/delete in the current scope (and anything it calls) to the given MemoryTrackerTag
+#define MEMORY_TAG_SCOPE(tag) MemoryTagScope _MACRO_CONCAT( memoryTagScope, __LINE__ )(tag);
+#else
+#define MEMORY_TAG_SCOPE(tag)
+#endif
+
+// Custom Allocator that Layer Containers use that tracks host memory usage via 'hostMemoryUsage'. Blocks come from the Layer heap.
+// Containers switch to std::allocator instead when tracking is compiled out (see LayerAllocator in LayerContainers.h).
 template<typename TYPE>
 struct MemoryTrackerAllocator
 {
@@ -79,13 +148,13 @@ struct MemoryTrackerAllocator
 	{
 		const size_t bytes = size * sizeof(TYPE);
 		MemoryTracker::AllocatedHostMemory(m_Tag, bytes);
-		return static_cast<TYPE*>(malloc(bytes));
+		return static_cast<TYPE*>(LayerMemory::Allocate(bytes));
 	}
 	void deallocate(TYPE* memory, size_t size) noexcept
 	{
 		const size_t bytes = size * sizeof(TYPE);
 		MemoryTracker::DeallocatedHostMemory(m_Tag, bytes);
-		free(memory);
+		LayerMemory::Free(memory);
 	}
 
 	MemoryTrackerTag m_Tag = MT_UNKNOWN;
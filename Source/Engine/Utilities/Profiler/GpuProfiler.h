@@ -0,0 +1,58 @@
+#pragma once
+#include "ThirdParty.h"
+#include "VkTypes.h"
+
+
+// --GPU PROFILER--
+// GPU_PROFILE_ZONE writes a vkCmdWriteTimestamp pair around a labelled region of a command buffer. Each frame in flight owns a slice
+// of one timestamp query pool. A slice is read back the next time its frame comes around (after its fence has been waited on,
+// so the read never stalls). The ticks are scaled by timestampPeriod, moved onto the CPU profiler's steady clock and recorded
+// as zones on a "GPU" track, so they show up on the same timeline as the CPU zones.
+namespace GpuProfiler
+{
+	// Labelled regions a frame can time, more are skipped
+	constexpr u32 maxZonesPerFrame = 64;
+
+#ifdef LAYER_USE_PROFILER
+	// Creates the query pool and lines the GPU clock up with the CPU profiler's. Does nothing if the graphics queue can't write timestamps.
+	void InitializeGpuProfiler(const VkRef& vkRef);
+
+	// Device must be idle
+	void ShutdownGpuProfiler(const VkRef& vkRef);
+
+	// Reads back the zones frameIndex last recorded and resets its queries. Call right after vkBeginCommandBuffer, after the frame's fence wait.
+	void BeginFrame(VkCommandBuffer cmdBuffer, u32 frameIndex);
+
+	// Returns the zone index EndZone needs, U32_MAX if the profiler is off or the frame is out of queries
+	u32 BeginZone(VkCommandBuffer cmdBuffer, const char* name);
+	void EndZone(VkCommandBuffer cmdBuffer, u32 zoneIndex);
+
+	class ScopedGpuZone
+	{
+	public:
+		ScopedGpuZone(VkCommandBuffer cmdBuffer, const char* name)
+			: m_CmdBuffer(cmdBuffer), m_ZoneIndex(BeginZone(cmdBuffer, name)) {}
+
+		~ScopedGpuZone() { EndZone(m_CmdBuffer, m_ZoneIndex); }
+
+		ScopedGpuZone(const ScopedGpuZone&) = delete;
+		ScopedGpuZone& operator=(const ScopedGpuZone&) = delete;
+
+	private:
+		VkCommandBuffer m_CmdBuffer;
+		u32 m_ZoneIndex;
+	};
+#else
+	// Profiler compiled out
+	inline void InitializeGpuProfiler(const VkRef&) {}
+	inline void ShutdownGpuProfiler(const VkRef&) {}
+	inline void BeginFrame(VkCommandBuffer, u32) {}
+#endif // LAYER_USE_PROFILER
+}
+
+#ifdef LAYER_USE_PROFILER
+	// Times the commands recorded into cmdBuffer for the rest of the scope as a GPU zone named name (a string literal)
+	#define GPU_PROFILE_ZONE(cmdBuffer, name) GpuProfiler::ScopedGpuZone _MACRO_CONCAT( gpuProfileZone, __LINE__ )(cmdBuffer, name);
+#else
+	#define GPU_PROFILE_ZONE(cmdBuffer, name)
+#endif // LAYER_USE_PROFILER
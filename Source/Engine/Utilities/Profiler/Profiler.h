@@ -0,0 +1,125 @@
+#pragma once
+#include "ThirdParty.h"
+#include "LayerContainers.h"
+
+
+// --CPU PROFILER--
+// Nested scoped zones (PROFILE_ZONE/PROFILE_FUNCTION) are timestamped with the steady clock and pushed into a lock free ring owned by
+// the recording thread. EndFrame() collects every thread's zones into a history of the last frameHistoryLength frames, which is
+// exported as a Chrome trace (chrome://tracing, Perfetto, or Tracy through its import-chrome tool) on shutdown.
+// The editor's Performance window plots frame times with their percentiles and captures the zones of frames that spike.
+// With LAYER_PROFILER off the zone macros compile to nothing and the functions below are empty inlines.
+namespace Profiler
+{
+	// Frames of zones kept for the Performance window/trace export
+	constexpr u32 frameHistoryLength = 256;
+
+	// Zones a thread can record between two EndFrame() calls, more get dropped and counted
+	constexpr u32 threadZoneCapacity = 8192;
+
+	// Frame/blocked times kept for the Performance window's graphs and percentiles
+	constexpr u32 frameTimeHistoryLength = 4096;
+
+	struct Zone
+	{
+		const char* name = nullptr;		// String literal, only the pointer is kept
+		u64 begin = 0;					// Steady clock ns
+		u64 end = 0;
+		u16 depth = 0;					// Number of zones open on the thread when it started
+		u16 threadIndex = 0;			// See GetThreadName()
+		bool bBlocking = false;			// PROFILE_WAIT_ZONE, time the thread sat waiting instead of working
+	};
+
+	struct FrameCapture
+	{
+		u64 frameNumber = 0;
+		u64 begin = 0;					// Previous EndFrame(), steady clock ns
+		u64 end = 0;					// This EndFrame()
+		u64 blockedTime = 0;			// Main thread ns spent in PROFILE_WAIT_ZONEs
+		T_vector<Zone, MT_ENGINE> zones = {};	// Every zone that ended during the frame, in the order each thread ended them
+	};
+
+	// Steady clock in ns, the timebase of every zone
+	inline u64 Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+#ifdef LAYER_USE_PROFILER
+	// Names the calling thread "Main", starts the clock trace timestamps are relative to and registers the Performance window
+	void InitializeProfiler();
+
+	// Exports the frame history next to the session log (Logs/CpuProfile.json)
+	void ShutdownProfiler();
+
+	// Collects every thread's finished zones into the frame history. Call once per frame from the main loop, outside any zone.
+	void EndFrame();
+
+	// Name shown for the calling thread's track in exported traces
+	void SetThreadName(const char* name);
+	const T_string& GetThreadName(u16 threadIndex);
+
+	// Adds a track that isn't tied to a thread (e.g. the GPU) and returns the index RecordTrackZone takes
+	u16 CreateTrack(const char* name);
+
+	// Records a finished zone on a CreateTrack() track, times on the Now() clock. Only one thread may record on a given track.
+	void RecordTrackZone(u16 trackIndex, const char* name, u64 begin, u64 end, u16 depth);
+
+	// Frames in the history, i == 0 is the oldest. Only valid until the next EndFrame().
+	u32 NumFrames();
+	const FrameCapture& GetFrame(u32 i);
+
+	// Zones dropped because a thread's ring was full
+	u64 NumDroppedZones();
+
+	// Writes the frame history as Chrome trace complete events, one track per thread. Path is relative to the current working directory.
+	void ExportChromeTrace(const char* filePath);
+
+	// Pushes a finished zone into the calling thread's ring, used by ScopedZone
+	void RecordZone(const char* name, u64 begin, u64 end, u16 depth, bool bBlocking);
+
+	// Open zone count on this thread, for nesting depth
+	inline thread_local u16 threadZoneDepth = 0;
+
+	class ScopedZone
+	{
+	public:
+		explicit ScopedZone(const char* name, bool bBlocking = false)
+			: m_Name(name), m_Depth(threadZoneDepth++), m_bBlocking(bBlocking), m_Begin(Now()) {}
+
+		~ScopedZone()
+		{
+			threadZoneDepth--;
+			RecordZone(m_Name, m_Begin, Now(), m_Depth, m_bBlocking);
+		}
+
+		ScopedZone(const ScopedZone&) = delete;
+		ScopedZone& operator=(const ScopedZone&) = delete;
+
+	private:
+		const char* m_Name;
+		u16 m_Depth;
+		bool m_bBlocking;
+		u64 m_Begin;
+	};
+#else
+	// Profiler compiled out
+	inline void InitializeProfiler() {}
+	inline void ShutdownProfiler() {}
+	inline void EndFrame() {}
+	inline void SetThreadName(const char*) {}
+	inline u32 NumFrames() { return 0; }
+	inline u64 NumDroppedZones() { return 0; }
+	inline void ExportChromeTrace(const char*) {}
+#endif // LAYER_USE_PROFILER
+}
+
+#ifdef LAYER_USE_PROFILER
+	// Times the rest of the scope as a zone named name (a string literal)
+	#define PROFILE_ZONE(name) Profiler::ScopedZone _MACRO_CONCAT( profileZone, __LINE__ )(name);
+	// PROFILE_ZONE named after the enclosing function
+	#define PROFILE_FUNCTION() PROFILE_ZONE(__func__)
+	// PROFILE_ZONE around a wait (fences, swap chain acquire...), on the main thread it counts as blocked rather than CPU time
+	#define PROFILE_WAIT_ZONE(name) Profiler::ScopedZone _MACRO_CONCAT( profileZone, __LINE__ )(name, true);
+#else
+	#define PROFILE_ZONE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_WAIT_ZONE(name)
+#endif // LAYER_USE_PROFILER
@@ -10,6 +10,7 @@ struct MemoryUsageInfo
 
 	const char* tagName = "";
 	u64 allocations = 0;
+	u64 frees = 0;			// Total frees since startup, only filled by the host tracker (allocations + frees == total allocs)
 	u64 size = 0;
 	const char* sizeLabel = " XiB";
 	f32 displaySize = 0.0f;
@@ -2,6 +2,7 @@
 #include "ThirdParty.h"
 #include "MemoryTracker.h"
 #include "LayerContainers.h"
+#include "VkConfig.h"
 
 
 struct SwapChainImage
@@ -13,6 +14,9 @@ struct SwapChainImage
 	VkImageView imageView;
 };
 
+// Swap chain images + views, kept inline since swap chains are rarely past triple buffering
+typedef T_small_vector<SwapChainImage, VkConfig::inlineSwapChainImages, MT_GRAPHICS> SwapChainImageList;
+
 struct PhysicalDevice
 {
 	PhysicalDevice() = default;
@@ -39,7 +43,6 @@ struct PhysicalDevice
 	VkSurfaceFormatKHR preferredSurfaceFormat = {};
 	VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR;
 	u32 swapChainBufferCount = 2;
-	u32 numInFlightFrames = 1;
 	bool bSupportsMailboxMode = false;
 
 	// Attachment Formats
@@ -68,12 +71,39 @@ struct DeviceQueues
 	bool bHasTransferQueue = false;
 };
 
+// Everything one frame in flight records into and syncs on. Once drawFence signals the GPU is done with all of it, so the pools
+// are reset wholesale rather than buffer by buffer. Its transient allocations live in the FrameArena block with the same index.
+struct FrameContext
+{
+	FrameContext() = default;
+	~FrameContext() = default;
+
+	VkCommandPool graphicsCommandPool = {};
+	VkCommandBuffer graphicsCommandBuffer = {};
+
+	VkCommandPool computeCommandPool = {};
+	VkCommandBuffer computeCommandBuffer = {};
+
+	VkCommandPool transferCommandPool = VK_NULL_HANDLE;		// Only with a dedicated transfer queue
+	VkCommandBuffer transferCommandBuffer = VK_NULL_HANDLE;
+
+	// One pool + SECONDARY buffer per recording thread, filled in by ParallelRecorder
+	T_small_vector<VkCommandPool, VkConfig::inlineRecordingThreads, MT_GRAPHICS> secondaryCommandPools = {};
+	T_small_vector<VkCommandBuffer, VkConfig::inlineRecordingThreads, MT_GRAPHICS> secondaryCommandBuffers = {};
+
+	VkSemaphore imageAvailable = {};	// Signaled when the acquired swap chain image can be drawn to
+	VkFence drawFence = {};				// Signaled when the GPU finishes the frame's submission
+};
+
+typedef T_small_vector<FrameContext, VkConfig::inlineFramesInFlight, MT_GRAPHICS> FrameContextList;
+
 struct VkRef
 {
 	VkRef() = default;
 	~VkRef() = default;
 
 	Window* pWindow = nullptr;
+	bool bHeadless = false;		// No window, surface or swap chain. Frames render into offscreen images.
 
 	VkInstance instance = {};
 	VkAllocationCallbacks hostAllocator = {};
@@ -82,16 +112,14 @@ struct VkRef
 
 	PhysicalDevice phyDevice = {};
 	VkDevice logDevice = {};
+	VkPipelineCache pipelineCache = {};		// Pass to every pipeline creation, persisted across runs (see PipelineCache.h)
 
 	DeviceQueues queues = {};
 
+	// One off and long lived graphics command buffers (uploads, calibration, readback), per frame recording uses frames
 	VkCommandPool graphicsCommandPool = {};
-	T_vector<VkCommandBuffer, MT_GRAPHICS> graphicsCommandBuffers = {};
-
-	VkCommandPool computeCommandPool = {};
-	T_vector<VkCommandBuffer, MT_GRAPHICS> computeCommandBuffers = {};
 
+	u32 numInFlightFrames = VkConfig::defaultFramesInFlight;
+	FrameContextList frames = {};		// One per frame in flight
 	bool bHasTransferCommandBuffer = false;
-	VkCommandPool transferCommandPool = {};
-	T_vector<VkCommandBuffer, MT_GRAPHICS> transferCommandBuffers = {};
 };
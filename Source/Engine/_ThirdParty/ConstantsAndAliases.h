@@ -1,3 +1,4 @@
+#pragma once
 // Only include std headers, no third party
 #include <cstdint>
 
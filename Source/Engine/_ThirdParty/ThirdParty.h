@@ -21,19 +21,31 @@
 #include <functional>
 #include <execution>
 #include <set>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <bit>
 #include <malloc.h>
 #include <stdio.h>         
 #include <stdlib.h>
 #include <sys/stat.h> // For stat() on POSIX systems
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h> // SSE2/AVX2 group probing in T_flat_map
+#endif
 
 // Platform includes
 #if LAYER_PLATFORM_WINDOWS
 #include <windows.h>
+#include <dbghelp.h>     // Stack capture/symbols for the allocation sampler
 
 #elif LAYER_PLATFORM_LINUX
 #include <mm_malloc.h>
 #include <unistd.h>
 #include <linux/limits.h>
+#include <execinfo.h>    // Stack capture for the allocation sampler
+#include <dlfcn.h>
+#include <cxxabi.h>
 
 #elif LAYER_PLATFORM_ANDROID
 #include <mm_malloc.h>
@@ -43,6 +55,9 @@
 #elif LAYER_PLATFORM_APPLE
 #include <mm_malloc.h>
 #include <mach-o/dyld.h>
+#include <execinfo.h>    // Stack capture for the allocation sampler
+#include <dlfcn.h>
+#include <cxxabi.h>
 
 #endif // Platform includes
 
@@ -0,0 +1,390 @@
+#include "AllocationSampler.h"
+#include "ImGuiManager.h"
+#include "FileHelper.h"
+#include "HelperTypes.h"
+#include "Logger.h"
+#include "LayerFlatMap.h"
+
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+namespace AllocationSampler
+{
+	// Every sample with the same stack and tag is folded into one site
+	struct _SampleSite
+	{
+		std::array<void*, maxStackDepth> frames = {};	// Innermost frame first
+		u32 frameCount = 0;
+		MemoryTrackerTag tag = MT_UNKNOWN;
+		u64 samples = 0;
+		u64 estimatedBytes = 0;							// Sum of each sample's unbiased size estimate
+	};
+
+	// Frames belonging to the sampler and MemoryTracker::AllocatedHostMemory() that get dropped from every stack
+	constexpr u32 _framesToSkip = 3;
+
+	// Budget used while sampling is off, threads still wake up this often to notice sampling being turned on
+	constexpr i64 _disabledRecheckBytes = 64 * MiB;
+
+	// Number of sites shown in the Memory window
+	constexpr u32 _numTopSites = 10;
+
+	// Path relative to the current working directory the folded stacks get written to on shutdown
+	constexpr const char* _foldedStacksPath = "Logs\\AllocationSamples.folded";
+
+	// Mean bytes between samples, 0 while sampling is off
+	std::atomic<u64> _sampleInterval = 0;
+
+	// Sites keyed by stack + tag hash. Only touched with _sitesMutex held.
+	T_flat_map<u64, _SampleSite, MT_OTHER> _sites;
+	std::mutex _sitesMutex;
+	std::atomic<u64> _totalSamples = 0;
+
+	// Symbol names per frame address. Only touched from the main thread (UI and export).
+	T_flat_map<void*, T_string, MT_OTHER> _symbolCache;
+
+	// Interval the calling thread's current budget was drawn with, 0 if it hasn't drawn a real one yet
+	constinit thread_local u64 _threadSampleInterval = 0;
+
+	// Set while the calling thread is inside the sampler, so allocations it makes aren't sampled (and can't retake _sitesMutex)
+	constinit thread_local bool _bInSampler = false;
+
+	// Per thread xorshift state for drawing sample budgets
+	constinit thread_local u64 _randomState = 0;
+
+	// --Internal helpers--
+
+	// Draws the next exponentially distributed byte budget for the calling thread
+	i64 _DrawSampleBudget(u64 meanSampleBytes);
+
+	// Fills frames with the calling stack, minus the sampler frames. Returns the number of frames written.
+	u32 _CaptureStack(void** frames, u32 maxFrames);
+
+	// FNV-1a over the frame addresses and tag
+	u64 _HashSite(const _SampleSite& site);
+
+	// Copies every site out from under the lock, sorted by estimated bytes. Scratch for the caller's frame, from the frame arena.
+	T_frame_vector<_SampleSite> _CopySortedSites();
+
+	// Returns a readable (demangled when possible) name for a frame address, cached per address. Only valid until the next call.
+	const T_string& _SymbolizeFrame(void* address);
+
+	// Register function ImGui manager uses to draw the sampled sites in the Memory window
+	void _DrawAllocationSamplerUI();
+}
+
+void AllocationSampler::InitializeAllocationSampler()
+{
+#ifdef LAYER_USE_ALLOCATION_SAMPLING
+	SetSampleInterval(defaultSampleInterval);
+	LOG_INFO_FMT("Allocation sampling enabled | Mean Interval: {} bytes", defaultSampleInterval)
+#endif
+
+	REGISTER_EDITOR_UI_WINDOW(nullptr, AllocationSampler::_DrawAllocationSamplerUI)
+}
+
+void AllocationSampler::ShutdownAllocationSampler()
+{
+	SetSampleInterval(0);
+	ExportFoldedStacks(_foldedStacksPath);
+}
+
+void AllocationSampler::SetSampleInterval(u64 meanSampleBytes)
+{
+	_sampleInterval.store(meanSampleBytes, std::memory_order_relaxed);
+
+	// Calling thread picks the new rate up on its next allocation, other threads when their current budget runs out
+	bytesUntilNextSample = 0;
+	_threadSampleInterval = 0;
+}
+
+void AllocationSampler::ClearSamples()
+{
+	_bInSampler = true;
+	{
+		std::lock_guard lock(_sitesMutex);
+		_sites.clear();
+	}
+	_totalSamples.store(0, std::memory_order_relaxed);
+	_bInSampler = false;
+}
+
+bool AllocationSampler::ExportFoldedStacks(const char* filePath)
+{
+	const T_frame_vector<_SampleSite> sites = _CopySortedSites();
+	if (sites.empty()) { return false; }
+
+	T_string foldedStacks;
+	for (const _SampleSite& site : sites)
+	{
+		// Root the stack at the tag so the flame graph splits by tag first
+		T_string tagName = MemoryTracker::GetHostMemoryUsage(site.tag).tagName;
+		std::erase_if(tagName, [](char c) { return c == ':' || c == '\t'; });
+		foldedStacks.append(tagName);
+
+		// Folded format wants the outermost frame first
+		for (u32 i = site.frameCount; i > 0; i--)
+		{
+			foldedStacks.AppendMany(";", _SymbolizeFrame(site.frames[i - 1]));
+		}
+		foldedStacks.AppendMany(" ", std::to_string(site.estimatedBytes), "\n");
+	}
+
+	FileHelper::WriteStringToFile(foldedStacks, filePath);
+	LOG_INFO_FMT("Wrote {} allocation sites to {}", sites.size(), filePath)
+
+	return true;
+}
+
+void AllocationSampler::_RecordSample(MemoryTrackerTag tag, u64 sizeOfAlloc)
+{
+	const u64 interval = _sampleInterval.load(std::memory_order_relaxed);
+	const bool bHadBudget = _threadSampleInterval != 0;
+	_threadSampleInterval = interval;
+
+	if (interval == 0)
+	{
+		bytesUntilNextSample = _disabledRecheckBytes;
+		return;
+	}
+
+	// Draw the next budget first, anything allocated while recording just counts against it
+	bytesUntilNextSample = _DrawSampleBudget(interval);
+
+	// First budget on this thread (or first since sampling was turned on) isn't a real sample
+	if (!bHadBudget || _bInSampler) { return; }
+
+	_bInSampler = true;
+
+	_SampleSite sample = {};
+	sample.frameCount = _CaptureStack(sample.frames.data(), maxStackDepth);
+	sample.tag = tag;
+
+	// Chance an allocation of this size trips the budget is 1 - e^(-size/interval), weight it by the inverse to stay unbiased
+	const f64 sampleChance = 1.0 - std::exp(-static_cast<f64>(sizeOfAlloc) / static_cast<f64>(interval));
+	const u64 estimatedBytes = static_cast<u64>(static_cast<f64>(sizeOfAlloc) / sampleChance);
+
+	const u64 siteKey = _HashSite(sample);
+	{
+		std::lock_guard lock(_sitesMutex);
+		_SampleSite& site = _sites.try_emplace(siteKey, sample).first->second;
+		site.samples++;
+		site.estimatedBytes += estimatedBytes;
+	}
+	_totalSamples.fetch_add(1, std::memory_order_relaxed);
+
+	_bInSampler = false;
+}
+
+i64 AllocationSampler::_DrawSampleBudget(u64 meanSampleBytes)
+{
+	if (_randomState == 0) [[unlikely]]
+	{
+		// Seed off this thread's TLS address and the clock so threads don't sample in lockstep
+		_randomState = reinterpret_cast<u64>(&_randomState) ^ static_cast<u64>(std::chrono::steady_clock::now().time_since_epoch().count());
+		_randomState |= 1;
+	}
+
+	// xorshift64*
+	_randomState ^= _randomState >> 12;
+	_randomState ^= _randomState << 25;
+	_randomState ^= _randomState >> 27;
+	const u64 random = _randomState * 0x2545F4914F6CDD1DULL;
+
+	// Uniform in (0, 1], then inverse CDF of the exponential distribution
+	const f64 uniform = static_cast<f64>((random >> 11) + 1) * (1.0 / 9007199254740992.0);
+	const f64 budget = -std::log(uniform) * static_cast<f64>(meanSampleBytes);
+
+	return static_cast<i64>(std::min(budget, static_cast<f64>(I64_MAX / 2))) + 1;
+}
+
+u32 AllocationSampler::_CaptureStack(void** frames, u32 maxFrames)
+{
+#if LAYER_PLATFORM_WINDOWS
+	return RtlCaptureStackBackTrace(_framesToSkip, maxFrames, frames, nullptr);
+#elif LAYER_PLATFORM_LINUX || LAYER_PLATFORM_APPLE
+	std::array<void*, maxStackDepth + _framesToSkip> rawFrames;
+	const i32 numRawFrames = backtrace(rawFrames.data(), static_cast<i32>(rawFrames.size()));
+	if (numRawFrames <= static_cast<i32>(_framesToSkip)) { return 0; }
+
+	const u32 numFrames = std::min(static_cast<u32>(numRawFrames) - _framesToSkip, maxFrames);
+	std::copy_n(rawFrames.begin() + _framesToSkip, numFrames, frames);
+	return numFrames;
+#else
+	// TODO: Android unwinding (_Unwind_Backtrace)
+	return 0;
+#endif
+}
+
+u64 AllocationSampler::_HashSite(const _SampleSite& site)
+{
+	u64 hash = 14695981039346656037ULL;
+	for (u32 i = 0; i < site.frameCount; i++)
+	{
+		hash = (hash ^ reinterpret_cast<u64>(site.frames[i])) * 1099511628211ULL;
+	}
+	return (hash ^ site.tag) * 1099511628211ULL;
+}
+
+T_frame_vector<AllocationSampler::_SampleSite> AllocationSampler::_CopySortedSites()
+{
+	T_frame_vector<_SampleSite> sites;
+
+	_bInSampler = true;
+	{
+		std::lock_guard lock(_sitesMutex);
+		sites.reserve(_sites.size());
+		for (const auto& [key, site] : _sites)
+		{
+			sites.push_back(site);
+		}
+	}
+	_bInSampler = false;
+
+	std::sort(sites.begin(), sites.end(), [](const _SampleSite& a, const _SampleSite& b) { return a.estimatedBytes > b.estimatedBytes; });
+	return sites;
+}
+
+const T_string& AllocationSampler::_SymbolizeFrame(void* address)
+{
+	auto cachedSymbol = _symbolCache.find(address);
+	if (cachedSymbol != _symbolCache.end())
+	{
+		return cachedSymbol->second;
+	}
+
+	T_string symbol;
+
+#if LAYER_PLATFORM_WINDOWS
+	static const bool bSymbolsLoaded = SymInitialize(GetCurrentProcess(), nullptr, TRUE);
+
+	alignas(SYMBOL_INFO) u8 symbolBuffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME] = {};
+	SYMBOL_INFO* pSymbolInfo = reinterpret_cast<SYMBOL_INFO*>(symbolBuffer);
+	pSymbolInfo->SizeOfStruct = sizeof(SYMBOL_INFO);
+	pSymbolInfo->MaxNameLen = MAX_SYM_NAME;
+
+	DWORD64 displacement = 0;
+	if (bSymbolsLoaded && SymFromAddr(GetCurrentProcess(), reinterpret_cast<DWORD64>(address), &displacement, pSymbolInfo))
+	{
+		symbol = pSymbolInfo->Name;
+	}
+#elif LAYER_PLATFORM_LINUX || LAYER_PLATFORM_APPLE
+	Dl_info info = {};
+	if (dladdr(address, &info) != 0 && info.dli_sname != nullptr)
+	{
+		i32 status = 0;
+		char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+		symbol = (status == 0 && demangled != nullptr) ? demangled : info.dli_sname;
+		free(demangled);
+	}
+	else if (info.dli_fname != nullptr)
+	{
+		// No exported symbol, fall back to module + offset so the frame can still be resolved offline
+		char offset[32];
+		snprintf(offset, sizeof(offset), "+0x%llx", static_cast<unsigned long long>(reinterpret_cast<u64>(address) - reinterpret_cast<u64>(info.dli_fbase)));
+		symbol = T_string(std::filesystem::path(info.dli_fname).filename().string().c_str(), offset);
+	}
+#endif
+
+	if (symbol.empty())
+	{
+		char rawAddress[32];
+		snprintf(rawAddress, sizeof(rawAddress), "0x%llx", static_cast<unsigned long long>(reinterpret_cast<u64>(address)));
+		symbol = rawAddress;
+	}
+
+	return _symbolCache.emplace(address, symbol).first->second;
+}
+
+void AllocationSampler::_DrawAllocationSamplerUI()
+{
+	ImGui::Begin("Memory");
+
+	ImGui::SeparatorText("Allocation Sampling");
+
+	const u64 interval = _sampleInterval.load(std::memory_order_relaxed);
+	bool bEnabled = interval != 0;
+	if (ImGui::Checkbox("Enabled", &bEnabled))
+	{
+		SetSampleInterval(bEnabled ? defaultSampleInterval : 0);
+	}
+
+	if (bEnabled)
+	{
+		i32 intervalKiB = static_cast<i32>(interval / KiB);
+		ImGui::SameLine();
+		ImGui::SetNextItemWidth(200.0f);
+		if (ImGui::SliderInt("Mean Interval (KiB)", &intervalKiB, 16, 16384, "%d", ImGuiSliderFlags_Logarithmic))
+		{
+			SetSampleInterval(static_cast<u64>(intervalKiB) * KiB);
+		}
+	}
+
+	ImGui::Text("Samples: %llu", _totalSamples.load(std::memory_order_relaxed));
+	ImGui::SameLine();
+	if (ImGui::Button("Clear"))
+	{
+		ClearSamples();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Export Folded Stacks"))
+	{
+		ExportFoldedStacks(_foldedStacksPath);
+	}
+
+	const T_frame_vector<_SampleSite> sites = _CopySortedSites();
+
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+	if (!sites.empty() && ImGui::BeginTable("AllocationSitesTable", 4, flags))
+	{
+		ImGui::TableSetupColumn("Memory Type");
+		ImGui::TableSetupColumn("Est. Size");
+		ImGui::TableSetupColumn("# Samples");
+		ImGui::TableSetupColumn("Call Site");
+		ImGui::TableHeadersRow();
+
+		MemoryUsageInfo sizeInfo = {};
+		for (u32 i = 0; i < std::min<u64>(sites.size(), _numTopSites); i++)
+		{
+			const _SampleSite& site = sites[i];
+			sizeInfo.size = site.estimatedBytes;
+			sizeInfo.SetDisplayLabel();
+
+			ImGui::TableNextRow();
+			// Tag Name
+			ImGui::TableSetColumnIndex(0);
+			ImGui::TextUnformatted(MemoryTracker::GetHostMemoryUsage(site.tag).tagName);
+			// Estimated bytes allocated from this site
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%.3f%s", sizeInfo.displaySize, sizeInfo.sizeLabel);
+			// Number of samples
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%llu", site.samples);
+			// Innermost frame, full stack on hover
+			ImGui::TableSetColumnIndex(3);
+			ImGui::TextUnformatted(site.frameCount > 0 ? _SymbolizeFrame(site.frames[0]).c_str() : "<no stack>");
+			if (ImGui::BeginItemTooltip())
+			{
+				for (u32 frame = 0; frame < site.frameCount; frame++)
+				{
+					ImGui::TextUnformatted(_SymbolizeFrame(site.frames[frame]).c_str());
+				}
+				ImGui::EndTooltip();
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+#else // LAYER_USE_MEMORY_TRACKING
+
+// Sampler hooks the tracker, nothing to do with tracking compiled out
+void AllocationSampler::InitializeAllocationSampler() {}
+void AllocationSampler::ShutdownAllocationSampler() {}
+void AllocationSampler::SetSampleInterval([[maybe_unused]] u64 meanSampleBytes) {}
+void AllocationSampler::ClearSamples() {}
+bool AllocationSampler::ExportFoldedStacks([[maybe_unused]] const char* filePath) { return false; }
+
+#endif // LAYER_USE_MEMORY_TRACKING
@@ -3,24 +3,38 @@
 #include "RenderManager.h"
 #include "Logger.h"
 #include "LoggingCallbacks.h"
+#include "MemoryTracker.h"
+#include "MemoryTimeline.h"
+#include "Profiler.h"
+#include "StartupGraph.h"
 
 
-void Engine::StartUp(const char* appName, u32 winWidth, u32 winHeight)
+void Engine::StartUp(const char* appName, u32 winWidth, u32 winHeight, bool bHeadless)
 {
+	MEMORY_TAG_SCOPE(MT_ENGINE)
 	LOG_DEBUG("Starting Engine...")
     
-    EngineUtilities::InitializeEngineUtilities();
+	{
+		STARTUP_STAGE("Engine Utilities")
+		EngineUtilities::InitializeEngineUtilities();
+	}
     
     #if LAYER_PLATFORM_ANDROID
 		// TODO: Create Android implementation
     #else // GLFW
-		glfwSetErrorCallback(LoggingCallbacks::glfw_error_callback);
-		glfwInit();
+		// Headless machines may not have a display for GLFW to connect to, and don't need one
+		if (!bHeadless)
+		{
+			STARTUP_STAGE("GLFW Init")
+			glfwSetErrorCallback(LoggingCallbacks::glfw_error_callback);
+			glfwInit();
+		}
     #endif
     
-    RenderManager::Initialize(appName, winWidth, winHeight);
+    RenderManager::Initialize(appName, winWidth, winHeight, bHeadless);
 
 	LOG_INFO("Engine Started")
+	StartupGraph::LogBreakdown();
 }
 
 void Engine::Run()
@@ -28,9 +42,22 @@ void Engine::Run()
 	// TODO: Make this loop multi-platform
 	while (!RenderManager::WindowsShouldClose())
 	{
-		glfwPollEvents();
+		RunFrame();
+	}
+}
+
+void Engine::RunFrame()
+{
+	{
+		PROFILE_ZONE("Frame")
+		if (!RenderManager::IsHeadless())
+		{
+			glfwPollEvents();
+		}
 		RenderManager::DrawFrame();
+		MemoryTimeline::CaptureFrame();
 	}
+	Profiler::EndFrame();
 }
 
 void Engine::Shutdown()
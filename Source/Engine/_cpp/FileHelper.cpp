@@ -108,6 +108,66 @@ void FileHelper::WriteStringToFile(const T_string& str, const char* filePath, bo
 
 }
 
+bool FileHelper::ReadBinaryFile(const char* filePath, std::vector<u8, LayerAllocator<u8>>& outBytes, bool bFromCurrentWorkingDirectory)
+{
+	if (!_ValidPath(filePath)) return false;
+
+	T_string fullPath;
+	if (bFromCurrentWorkingDirectory)
+	{
+		fullPath.AppendMany(currentWorkingDirectory, filePath);
+	}
+	else
+	{
+		fullPath = filePath;
+	}
+
+	std::ifstream file(fullPath.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+	if (!file.is_open()) return false;
+
+	const std::streamsize size = file.tellg();
+	if (size < 0) return false;
+
+	outBytes.resize(static_cast<u64>(size));
+	file.seekg(0);
+	return static_cast<bool>(file.read(reinterpret_cast<char*>(outBytes.data()), size));
+}
+
+bool FileHelper::WriteBinaryFileAtomic(const void* pData, u64 size, const char* filePath, bool bFromCurrentWorkingDirectory)
+{
+	if (!_ValidPath(filePath)) return false;
+
+	T_string fullPath;
+	if (bFromCurrentWorkingDirectory)
+	{
+		fullPath.AppendMany(currentWorkingDirectory, filePath);
+	}
+	else
+	{
+		fullPath = filePath;
+	}
+	const T_string tempPath(fullPath, ".tmp");
+
+	{
+		std::ofstream file(tempPath.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file.is_open()) return false;
+
+		file.write(static_cast<const char*>(pData), static_cast<std::streamsize>(size));
+		if (!file.good()) return false;
+	}
+
+	// Replaces the old file in one step on every platform (MoveFileEx with MOVEFILE_REPLACE_EXISTING on Windows)
+	std::error_code error;
+	std::filesystem::rename(tempPath.c_str(), fullPath.c_str(), error);
+	if (error)
+	{
+		LOG_ERROR(T_string("Failed to replace \"", fullPath, "\": ", error.message()))
+		std::filesystem::remove(tempPath.c_str(), error);
+		return false;
+	}
+	return true;
+}
+
 bool FileHelper::_ValidPath(const char* path)
 {
     for (u64 i = 0; path[i] != '\0'; i++)
@@ -0,0 +1,175 @@
+#include "FrameArena.h"
+#include "LayerMemory.h"
+#include "ImGuiManager.h"
+#include "HelperTypes.h"
+#include "Logger.h"
+
+
+namespace FrameArena
+{
+	// One bump block per frame in flight
+	struct _FrameBlock
+	{
+		u8* pMemory = nullptr;
+		std::atomic<u64> offset = 0;			// Bytes handed out since the last reset (can run past capacity when full)
+		std::atomic<u64> spilledBytes = 0;		// Bytes that didn't fit and went to the heap since the last reset
+		u64 lastFramePeak = 0;					// Offset the block reached the last time it was used
+		u64 lastFrameSpilled = 0;				// Spilled bytes the last time it was used
+	};
+
+	// Upper bound on frames in flight the arena can track
+	constexpr u32 _maxFrameBlocks = 8;
+
+	std::array<_FrameBlock, _maxFrameBlocks> _frameBlocks = {};
+	u32 _numFrameBlocks = 0;
+	u64 _frameCapacity = 0;
+
+	// Block new allocations go to, U32_MAX until the first BeginFrame()
+	std::atomic<u32> _activeFrame = U32_MAX;
+
+	// Highest per frame usage seen this session
+	u64 _sessionPeak = 0;
+
+	// --Internal helpers--
+
+	// Register function ImGui manager uses to draw frame arena usage in the Memory window
+	void _DrawFrameArenaUI();
+}
+
+void FrameArena::InitializeFrameArena(u32 numInFlightFrames, u64 frameCapacity)
+{
+	LOG_DEBUG("Initializing Frame Arena...")
+
+	LOG_ERROR_IF(numInFlightFrames > _maxFrameBlocks, T_string("Frame arena only supports ", std::to_string(_maxFrameBlocks), " frames in flight!"))
+
+	_frameCapacity = frameCapacity;
+	_numFrameBlocks = std::min(numInFlightFrames, _maxFrameBlocks);
+
+	for (u32 i = 0; i < _numFrameBlocks; i++)
+	{
+		_FrameBlock& block = _frameBlocks[i];
+		block.pMemory = static_cast<u8*>(LayerMemory::AlignedMalloc(_frameCapacity, 64));
+		ASSERT_PTR(block.pMemory)
+		MemoryTracker::AllocatedHostMemory(MT_TEMPORARY, _frameCapacity);
+	}
+
+	REGISTER_EDITOR_UI_WINDOW(nullptr, FrameArena::_DrawFrameArenaUI)
+
+	LOG_INFO_FMT("Frame Arena Initialized | Frames: {} | Bytes Per Frame: {}", numInFlightFrames, _frameCapacity)
+}
+
+void FrameArena::ShutdownFrameArena()
+{
+	_activeFrame.store(U32_MAX, std::memory_order_release);
+
+	for (u32 i = 0; i < _numFrameBlocks; i++)
+	{
+		LayerMemory::AlignedFree(_frameBlocks[i].pMemory);
+		_frameBlocks[i].pMemory = nullptr;
+		MemoryTracker::DeallocatedHostMemory(MT_TEMPORARY, _frameCapacity);
+	}
+	_numFrameBlocks = 0;
+}
+
+void FrameArena::BeginFrame(u32 frameIndex)
+{
+	if (frameIndex >= _numFrameBlocks) [[unlikely]]
+	{
+		LOG_ERROR(T_string("Frame arena index out of range! Given index: ", std::to_string(frameIndex)))
+		return;
+	}
+
+	_FrameBlock& block = _frameBlocks[frameIndex];
+
+	// Capture how much the block used the last time around before wiping it
+	block.lastFramePeak = std::min(block.offset.load(std::memory_order_relaxed), _frameCapacity);
+	block.lastFrameSpilled = block.spilledBytes.load(std::memory_order_relaxed);
+	_sessionPeak = std::max(_sessionPeak, block.lastFramePeak + block.lastFrameSpilled);
+
+	block.offset.store(0, std::memory_order_relaxed);
+	block.spilledBytes.store(0, std::memory_order_relaxed);
+
+	_activeFrame.store(frameIndex, std::memory_order_release);
+}
+
+void* FrameArena::Allocate(u64 size, u64 alignment)
+{
+	const u32 activeFrame = _activeFrame.load(std::memory_order_acquire);
+	if (activeFrame == U32_MAX) [[unlikely]] { return nullptr; }
+
+	_FrameBlock& block = _frameBlocks[activeFrame];
+
+	// Reserve enough to align inside the reserved range. Aligned on the real address, so alignments past the block base's 64 work too.
+	const u64 reserveSize = size + alignment - 1;
+	const u64 start = block.offset.fetch_add(reserveSize, std::memory_order_relaxed);
+	if (start + reserveSize > _frameCapacity) [[unlikely]]
+	{
+		block.spilledBytes.fetch_add(size, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	const uintptr_t address = reinterpret_cast<uintptr_t>(block.pMemory) + start;
+	return reinterpret_cast<void*>((address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1));
+}
+
+bool FrameArena::Owns(const void* ptr)
+{
+	const u8* pByte = static_cast<const u8*>(ptr);
+	for (u32 i = 0; i < _numFrameBlocks; i++)
+	{
+		if (pByte >= _frameBlocks[i].pMemory && pByte < _frameBlocks[i].pMemory + _frameCapacity)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void FrameArena::_DrawFrameArenaUI()
+{
+	ImGui::Begin("Memory");
+
+	ImGui::SeparatorText("Frame Arena Usage");
+
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+	if (ImGui::BeginTable("FrameArenaUsageTable", 3, flags))
+	{
+		ImGui::TableSetupColumn("Frame");
+		ImGui::TableSetupColumn("Peak / Capacity");
+		ImGui::TableSetupColumn("Spilled To Heap");
+		ImGui::TableHeadersRow();
+
+		MemoryUsageInfo peakInfo = {};
+		MemoryUsageInfo capacityInfo = {};
+		MemoryUsageInfo spilledInfo = {};
+		capacityInfo.size = _frameCapacity;
+		capacityInfo.SetDisplayLabel();
+
+		for (u32 i = 0; i < _numFrameBlocks; i++)
+		{
+			peakInfo.size = _frameBlocks[i].lastFramePeak;
+			peakInfo.SetDisplayLabel();
+			spilledInfo.size = _frameBlocks[i].lastFrameSpilled;
+			spilledInfo.SetDisplayLabel();
+
+			ImGui::TableNextRow();
+			// Frame index
+			ImGui::TableSetColumnIndex(0);
+			ImGui::Text("%u", i);
+			// Peak usage of the last completed frame on this block
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%.3f%s / %.3f%s", peakInfo.displaySize, peakInfo.sizeLabel, capacityInfo.displaySize, capacityInfo.sizeLabel);
+			// Bytes that didn't fit
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.3f%s", spilledInfo.displaySize, spilledInfo.sizeLabel);
+		}
+		ImGui::EndTable();
+
+		peakInfo.size = _sessionPeak;
+		peakInfo.SetDisplayLabel();
+		ImGui::Text("Session Peak: %.3f%s", peakInfo.displaySize, peakInfo.sizeLabel);
+	}
+
+	ImGui::End();
+}
@@ -50,6 +50,11 @@ void GpuMemoryTracker::DeallocatedGpuMemory(GpuMemoryUsageTag tag, u64 sizeOfAll
 	_gpuMemoryUsage[tag].SetDisplayLabel();
 }
 
+const MemoryUsageInfo& GpuMemoryTracker::GetGpuMemoryUsage(GpuMemoryUsageTag tag)
+{
+	return _gpuMemoryUsage[tag];
+}
+
 
 void GpuMemoryTracker::LogGpuMemoryUsage()
 {
@@ -124,6 +129,8 @@ const char* GpuMemoryTracker::_GetGpuUsageTagName(u32 tag)
 		return "STORAGE IMAGES:\t\t";
 	case GPU_USAGE_ATTACHMENT_IMAGE:
 		return "ATTACHMENT IMAGES:\t";
+	case GPU_USAGE_READBACK_BUFFER:
+		return "READBACK BUFFERS:\t";
 	case GPU_USAGE_MAX:
 		return "GPU_USAGE_MAX (THIS SHOULDN'T BE PRINTED) ";
 	default:
@@ -0,0 +1,208 @@
+#include "GpuProfiler.h"
+
+#ifdef LAYER_USE_PROFILER
+#include "Profiler.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
+
+
+namespace GpuProfiler
+{
+	// One frame in flight's zones, queries [firstQuery, firstQuery + 2 * maxZonesPerFrame) of the pool
+	struct _FrameSlot
+	{
+		std::array<const char*, maxZonesPerFrame> names = {};
+		std::array<u16, maxZonesPerFrame> depths = {};
+		u32 numZones = 0;			// Zones recorded the last time the slot was used, waiting to be read back
+		u32 firstQuery = 0;
+	};
+
+	bool _bEnabled = false;
+	VkDevice _device = VK_NULL_HANDLE;
+	const VkAllocationCallbacks* _pHostAllocator = nullptr;
+	VkQueryPool _queryPool = VK_NULL_HANDLE;
+	T_vector<_FrameSlot, MT_GRAPHICS> _frameSlots = {};
+
+	// Slot the command buffer being recorded writes into, and how deep its open zones go
+	_FrameSlot* _pRecordingSlot = nullptr;
+	u16 _openZones = 0;
+
+	// Tick -> Profiler::Now() conversion
+	f64 _timestampPeriod = 1.0;		// ns per tick
+	u64 _timestampMask = U64_MAX;	// Only timestampValidBits of a timestamp are meaningful
+	u64 _calibrationTicks = 0;
+	u64 _calibrationTime = 0;
+
+	u16 _gpuTrack = 0;
+	T_vector<u64, MT_GRAPHICS> _queryResults = {};
+
+	// --Internal helpers--
+
+	// Writes one timestamp through a throw away submit and pairs it with the CPU clock, blocks until the GPU is done
+	void _CalibrateClocks(const VkRef& vkRef);
+
+	// Moves a GPU timestamp onto the CPU profiler's clock
+	u64 _TicksToTime(u64 ticks);
+
+	// Records the slot's zones on the GPU track if its queries are done, returns false if they aren't yet
+	bool _ReadBackSlot(_FrameSlot& slot);
+}
+
+void GpuProfiler::InitializeGpuProfiler(const VkRef& vkRef)
+{
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+	LOG_DEBUG("Initializing GPU Profiler...")
+
+	u32 queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(vkRef.phyDevice.handle, &queueFamilyCount, nullptr);
+	T_small_vector<VkQueueFamilyProperties, 8> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(vkRef.phyDevice.handle, &queueFamilyCount, queueFamilies.data());
+
+	const u32 timestampValidBits = queueFamilies[vkRef.phyDevice.graphicsQueueIndex].timestampValidBits;
+	if (timestampValidBits == 0 || vkRef.phyDevice.properties.limits.timestampPeriod <= 0.0f)
+	{
+		LOG_WARNING("Graphics queue can't write timestamps, GPU profiling is off")
+		return;
+	}
+
+	_device = vkRef.logDevice;
+	_pHostAllocator = &vkRef.hostAllocator;
+	_timestampPeriod = static_cast<f64>(vkRef.phyDevice.properties.limits.timestampPeriod);
+	_timestampMask = timestampValidBits >= 64 ? U64_MAX : (1ull << timestampValidBits) - 1;
+
+	const u32 numFrames = vkRef.numInFlightFrames;
+	VkQueryPoolCreateInfo queryPoolCreateInfo = { VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO };
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = numFrames * maxZonesPerFrame * 2;	// Begin + end per zone
+	LOG_VKRESULT(vkCreateQueryPool(_device, &queryPoolCreateInfo, _pHostAllocator, &_queryPool))
+
+	_frameSlots.resize(numFrames);
+	for (u32 i = 0; i < numFrames; i++)
+	{
+		_frameSlots[i].firstQuery = i * maxZonesPerFrame * 2;
+	}
+	_queryResults.resize(maxZonesPerFrame * 2);
+
+	_CalibrateClocks(vkRef);
+	_gpuTrack = Profiler::CreateTrack("GPU");
+	_bEnabled = true;
+
+	LOG_INFO_FMT("GPU Profiler Initialized | Timestamp Period: {} ns | Valid Bits: {}", _timestampPeriod, timestampValidBits)
+}
+
+void GpuProfiler::ShutdownGpuProfiler(const VkRef& vkRef)
+{
+	if (!_bEnabled) { return; }
+
+	vkDestroyQueryPool(vkRef.logDevice, _queryPool, &vkRef.hostAllocator);
+	_queryPool = VK_NULL_HANDLE;
+	_bEnabled = false;
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer cmdBuffer, u32 frameIndex)
+{
+	if (!_bEnabled) { return; }
+
+	_FrameSlot& slot = _frameSlots[frameIndex];
+
+	// The frame's fence has been waited on, so its last zones are normally done. If a driver isn't there yet skip them, never stall.
+	if (!_ReadBackSlot(slot))
+	{
+		slot.numZones = 0;
+	}
+
+	vkCmdResetQueryPool(cmdBuffer, _queryPool, slot.firstQuery, maxZonesPerFrame * 2);
+	_pRecordingSlot = &slot;
+	_openZones = 0;
+}
+
+u32 GpuProfiler::BeginZone(VkCommandBuffer cmdBuffer, const char* name)
+{
+	if (_pRecordingSlot == nullptr || _pRecordingSlot->numZones == maxZonesPerFrame) { return U32_MAX; }
+
+	const u32 zoneIndex = _pRecordingSlot->numZones++;
+	_pRecordingSlot->names[zoneIndex] = name;
+	_pRecordingSlot->depths[zoneIndex] = _openZones++;
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, _queryPool, _pRecordingSlot->firstQuery + zoneIndex * 2);
+	return zoneIndex;
+}
+
+void GpuProfiler::EndZone(VkCommandBuffer cmdBuffer, u32 zoneIndex)
+{
+	if (_pRecordingSlot == nullptr || zoneIndex == U32_MAX) { return; }
+
+	_openZones--;
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, _pRecordingSlot->firstQuery + zoneIndex * 2 + 1);
+}
+
+void GpuProfiler::_CalibrateClocks(const VkRef& vkRef)
+{
+	VkCommandBufferAllocateInfo cmdBufferAllocInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+	cmdBufferAllocInfo.commandPool = vkRef.graphicsCommandPool;
+	cmdBufferAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	cmdBufferAllocInfo.commandBufferCount = 1;
+	VkCommandBuffer cmdBuffer = VK_NULL_HANDLE;
+	LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &cmdBufferAllocInfo, &cmdBuffer))
+
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+	vkCmdResetQueryPool(cmdBuffer, _queryPool, 0, 1);
+	vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _queryPool, 0);
+	vkEndCommandBuffer(cmdBuffer);
+
+	VkFenceCreateInfo fenceCreateInfo = { VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	VkFence fence = VK_NULL_HANDLE;
+	LOG_VKRESULT(vkCreateFence(vkRef.logDevice, &fenceCreateInfo, &vkRef.hostAllocator, &fence))
+
+	VkSubmitInfo submitInfo = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmdBuffer;
+
+	// The timestamp lands somewhere between the submit and the fence signalling, take the middle
+	const u64 submitTime = Profiler::Now();
+	LOG_VKRESULT(vkQueueSubmit(vkRef.queues.graphics, 1, &submitInfo, fence))
+	LOG_VKRESULT(vkWaitForFences(vkRef.logDevice, 1, &fence, VK_TRUE, U64_MAX))
+	const u64 signalledTime = Profiler::Now();
+
+	LOG_VKRESULT(vkGetQueryPoolResults(vkRef.logDevice, _queryPool, 0, 1, sizeof(u64), &_calibrationTicks, sizeof(u64), VK_QUERY_RESULT_64_BIT))
+	_calibrationTicks &= _timestampMask;
+	_calibrationTime = submitTime + (signalledTime - submitTime) / 2;
+
+	vkDestroyFence(vkRef.logDevice, fence, &vkRef.hostAllocator);
+	vkFreeCommandBuffers(vkRef.logDevice, vkRef.graphicsCommandPool, 1, &cmdBuffer);
+}
+
+u64 GpuProfiler::_TicksToTime(u64 ticks)
+{
+	// Signed distance from the calibration point, wrapped to the valid bits
+	u64 delta = (ticks - _calibrationTicks) & _timestampMask;
+	if (_timestampMask != U64_MAX && delta > (_timestampMask >> 1))
+	{
+		delta |= ~_timestampMask;	// Before the calibration point, sign extend
+	}
+	return _calibrationTime + static_cast<u64>(static_cast<i64>(static_cast<f64>(static_cast<i64>(delta)) * _timestampPeriod));
+}
+
+bool GpuProfiler::_ReadBackSlot(_FrameSlot& slot)
+{
+	if (slot.numZones == 0) { return true; }
+
+	// No WAIT flag, VK_NOT_READY instead of blocking if the GPU isn't done
+	const VkResult result = vkGetQueryPoolResults(_device, _queryPool, slot.firstQuery, slot.numZones * 2, slot.numZones * 2 * sizeof(u64),
+		_queryResults.data(), sizeof(u64), VK_QUERY_RESULT_64_BIT);
+	if (result == VK_NOT_READY) { return false; }
+	LOG_VKRESULT(result)
+
+	for (u32 i = 0; i < slot.numZones; i++)
+	{
+		const u64 begin = _TicksToTime(_queryResults[i * 2] & _timestampMask);
+		const u64 end = _TicksToTime(_queryResults[i * 2 + 1] & _timestampMask);
+		Profiler::RecordTrackZone(_gpuTrack, slot.names[i], begin, std::max(begin, end), slot.depths[i]);
+	}
+
+	slot.numZones = 0;
+	return true;
+}
+
+#endif // LAYER_USE_PROFILER
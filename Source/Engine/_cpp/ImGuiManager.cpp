@@ -5,14 +5,16 @@
 #include "LayerContainers.h"
 #include "MemoryTracker.h"
 #include "FileHelper.h"
+#include "Profiler.h"
+#include "StartupGraph.h"
+#include "PipelineCache.h"
 
 namespace ImGuiManager
 {
     // ImGui Vulkan members
     VkRenderPass _imguiRenderPass = {};
-    T_vector<VkFramebuffer, MT_GRAPHICS> _imguiFrameBuffers = {};
+    T_small_vector<VkFramebuffer, VkConfig::inlineSwapChainImages, MT_GRAPHICS> _imguiFrameBuffers = {};
     VkExtent2D _swapChainExtentRef;
-    VkPipelineCache _imguiPipelineCache = {};
     VkDescriptorPool _imguiDescriptorPool = {};
     VkClearValue _imguiClearValue = {};
     
@@ -24,10 +26,90 @@ namespace ImGuiManager
     void _DockSpaceManager(ImGuiIO& io);
 }
 
+void ImGuiManager::CreateImguiContext()
+{
+    #ifdef LAYER_USE_UI
+    
+	MEMORY_TAG_SCOPE(MT_EDITOR)
+	LOG_DEBUG("Creating ImGui Context...")
+
+	// Setup Dear ImGui context
+	IMGUI_CHECKVERSION(); 
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO(); (void)io;
+	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
+	io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
+	io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;         // Enable Docking
+	io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;       // Enable Multi-Viewport / Platform Windows
+	// io.ConfigViewportsNoAutoMerge = true;
+	// io.ConfigViewportsNoTaskBarIcon = true;
+
+	// Set config location
+	if (imguiConfigDirPath.empty()) [[unlikely]]
+	{
+		LOG_ERROR("ImGui config file path hasn't be set!")
+	}
+    else if(imguiConfigFilePath.empty()) [[unlikely]]
+    {
+        LOG_ERROR("ImGui config file name hasn't be set!")
+    }
+	else [[likely]]
+	{
+        // Create the folder to store the .ini file
+		FileHelper::CreateFolderIfAbsent(imguiConfigDirPath.c_str(), false);
+        // Set the path for the .ini file
+		io.IniFilename = imguiConfigFilePath.c_str();
+	}
+
+
+	// Setup Dear ImGui style
+	ImGui::StyleColorsDark();
+	//ImGui::StyleColorsLight();
+
+	// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
+	ImGuiStyle& style = ImGui::GetStyle();
+	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
+	{
+		style.WindowRounding = 0.0f;
+		style.FrameRounding = 2.0f;
+		style.GrabRounding = 2.0f;
+		style.Colors[ImGuiCol_WindowBg].w = _imguiWindowOpacity;
+	}
+
+	// Load Fonts
+	// - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
+	// - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
+	// - If the file cannot be loaded, the function will return a nullptr. Please handle those errors in your application (e.g. use an assertion, or display an error and quit).
+	// - The fonts will be rasterized at a given size (w/ oversampling) and stored into a texture when calling ImFontAtlas::Build()/GetTexDataAsXXXX(), which ImGui_ImplXXXX_NewFrame below will call.
+	// - Use '#define IMGUI_ENABLE_FREETYPE' in your imconfig file to use Freetype for higher quality font rendering.
+	// - Read 'docs/FONTS.md' for more instructions and details.
+	// - Remember that in C/C++ if you want to include a backslash \ in a string literal you need to write a double backslash \\ !
+	// io.Fonts->AddFontDefault();
+	// io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\segoeui.ttf", 18.0f);
+	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/DroidSans.ttf", 16.0f);
+	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/Roboto-Medium.ttf", 16.0f);
+	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/Cousine-Regular.ttf", 15.0f);
+	// ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, nullptr, io.Fonts->GetGlyphRangesJapanese());
+	// IM_ASSERT(font != nullptr);
+
+	// Rasterize the atlas now, ImGui_ImplVulkan_CreateFontsTexture() only uploads what's already built
+	{
+		u8* pPixels = nullptr;
+		i32 width = 0;
+		i32 height = 0;
+		io.Fonts->GetTexDataAsRGBA32(&pPixels, &width, &height);
+	}
+
+	LOG_INFO("ImGui Context Created")
+    
+    #endif // LAYER_USE_UI
+}
+
 void ImGuiManager::SetupImgui(const VkRef& vkRef)
 {
     #ifdef LAYER_USE_UI
     
+	MEMORY_TAG_SCOPE(MT_EDITOR)
 	LOG_DEBUG("Setting Up ImGui...")
 
 	// Create Render Pass For Just ImGui
@@ -79,49 +161,6 @@ void ImGuiManager::SetupImgui(const VkRef& vkRef)
 	poolInfo.pPoolSizes = poolSizes.data();
 	LOG_VKRESULT(vkCreateDescriptorPool(vkRef.logDevice, &poolInfo, &vkRef.hostAllocator, &ImGuiManager::_imguiDescriptorPool))
 
-	// Setup Dear ImGui context
-	IMGUI_CHECKVERSION(); 
-	ImGui::CreateContext();
-	ImGuiIO& io = ImGui::GetIO(); (void)io;
-	io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;     // Enable Keyboard Controls
-	io.ConfigFlags |= ImGuiConfigFlags_NavEnableGamepad;      // Enable Gamepad Controls
-	io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;         // Enable Docking
-	io.ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;       // Enable Multi-Viewport / Platform Windows
-	// io.ConfigViewportsNoAutoMerge = true;
-	// io.ConfigViewportsNoTaskBarIcon = true;
-
-	// Set config location
-	if (imguiConfigDirPath.empty()) [[unlikely]]
-	{
-		LOG_ERROR("ImGui config file path hasn't be set!")
-	}
-    else if(imguiConfigFilePath.empty()) [[unlikely]]
-    {
-        LOG_ERROR("ImGui config file name hasn't be set!")
-    }
-	else [[likely]]
-	{
-        // Create the folder to store the .ini file
-		FileHelper::CreateFolderIfAbsent(imguiConfigDirPath.c_str(), false);
-        // Set the path for the .ini file
-		io.IniFilename = imguiConfigFilePath.c_str();
-	}
-
-
-	// Setup Dear ImGui style
-	ImGui::StyleColorsDark();
-	//ImGui::StyleColorsLight();
-
-	// When viewports are enabled we tweak WindowRounding/WindowBg so platform windows can look identical to regular ones.
-	ImGuiStyle& style = ImGui::GetStyle();
-	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
-	{
-		style.WindowRounding = 0.0f;
-		style.FrameRounding = 2.0f;
-		style.GrabRounding = 2.0f;
-		style.Colors[ImGuiCol_WindowBg].w = _imguiWindowOpacity;
-	}
-
 	// Setup Platform/Renderer back ends
 	ImGui_ImplGlfw_InitForVulkan(vkRef.pWindow, true);
 	ImGui_ImplVulkan_InitInfo initInfo = {};
@@ -130,50 +169,37 @@ void ImGuiManager::SetupImgui(const VkRef& vkRef)
 	initInfo.Device = vkRef.logDevice;
 	initInfo.QueueFamily = vkRef.phyDevice.graphicsQueueIndex;
 	initInfo.Queue = vkRef.queues.graphics;
-	initInfo.PipelineCache = _imguiPipelineCache;
+	initInfo.PipelineCache = vkRef.pipelineCache;
 	initInfo.DescriptorPool = _imguiDescriptorPool;
 	initInfo.Subpass = 0;
 	initInfo.MinImageCount = vkRef.phyDevice.swapChainBufferCount;
-	initInfo.ImageCount = vkRef.phyDevice.swapChainBufferCount;
+	initInfo.ImageCount = std::max(vkRef.phyDevice.swapChainBufferCount, vkRef.numInFlightFrames);	// ImGui rotates its vertex buffers by this, each frame in flight needs its own
 	initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 	initInfo.Allocator = &vkRef.hostAllocator;
 	initInfo.CheckVkResultFn = LoggingCallbacks::ImguiCheckVkResult;
+	// Creates ImGui's pipeline, the one place startup pays for a cold pipeline cache
+	const u64 pipelineBegin = Profiler::Now();
 	ImGui_ImplVulkan_Init(&initInfo, _imguiRenderPass);
-
-	// Load Fonts
-	// - If no fonts are loaded, dear imgui will use the default font. You can also load multiple fonts and use ImGui::PushFont()/PopFont() to select them.
-	// - AddFontFromFileTTF() will return the ImFont* so you can store it if you need to select the font among multiple.
-	// - If the file cannot be loaded, the function will return a nullptr. Please handle those errors in your application (e.g. use an assertion, or display an error and quit).
-	// - The fonts will be rasterized at a given size (w/ oversampling) and stored into a texture when calling ImFontAtlas::Build()/GetTexDataAsXXXX(), which ImGui_ImplXXXX_NewFrame below will call.
-	// - Use '#define IMGUI_ENABLE_FREETYPE' in your imconfig file to use Freetype for higher quality font rendering.
-	// - Read 'docs/FONTS.md' for more instructions and details.
-	// - Remember that in C/C++ if you want to include a backslash \ in a string literal you need to write a double backslash \\ !
-	// io.Fonts->AddFontDefault();
-	// io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\segoeui.ttf", 18.0f);
-	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/DroidSans.ttf", 16.0f);
-	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/Roboto-Medium.ttf", 16.0f);
-	// io.Fonts->AddFontFromFileTTF("../../misc/fonts/Cousine-Regular.ttf", 15.0f);
-	// ImFont* font = io.Fonts->AddFontFromFileTTF("c:\\Windows\\Fonts\\ArialUni.ttf", 18.0f, nullptr, io.Fonts->GetGlyphRangesJapanese());
-	// IM_ASSERT(font != nullptr);
+	StartupGraph::RecordStage(PipelineCache::IsWarm() ? "ImGui Pipeline (Cache Hit)" : "ImGui Pipeline (Cache Miss)", pipelineBegin, Profiler::Now());
 
 	// TODO: Upload custom fonts
 	// Upload Fonts
 	{
-		// Use any command queue
-
-		LOG_VKRESULT(vkResetCommandPool(vkRef.logDevice, vkRef.graphicsCommandPool, 0))
+		// Borrow the first frame's command buffer, nothing has been recorded into it yet
+		const FrameContext& frame = vkRef.frames[0];
+		LOG_VKRESULT(vkResetCommandPool(vkRef.logDevice, frame.graphicsCommandPool, 0))
 		VkCommandBufferBeginInfo beginInfo = {};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-		LOG_VKRESULT(vkBeginCommandBuffer(vkRef.graphicsCommandBuffers[0], &beginInfo))
+		LOG_VKRESULT(vkBeginCommandBuffer(frame.graphicsCommandBuffer, &beginInfo))
 
-		ImGui_ImplVulkan_CreateFontsTexture(vkRef.graphicsCommandBuffers[0]);
+		ImGui_ImplVulkan_CreateFontsTexture(frame.graphicsCommandBuffer);
 
 		VkSubmitInfo endInfo = {};
 		endInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 		endInfo.commandBufferCount = 1;
-		endInfo.pCommandBuffers = &vkRef.graphicsCommandBuffers[0];
-		LOG_VKRESULT(vkEndCommandBuffer(vkRef.graphicsCommandBuffers[0]))
+		endInfo.pCommandBuffers = &frame.graphicsCommandBuffer;
+		LOG_VKRESULT(vkEndCommandBuffer(frame.graphicsCommandBuffer))
 		LOG_VKRESULT(vkQueueSubmit(vkRef.queues.graphics, 1, &endInfo, VK_NULL_HANDLE))
 
 		LOG_VKRESULT(vkDeviceWaitIdle(vkRef.logDevice))
@@ -189,6 +215,9 @@ void ImGuiManager::StartImguiFrame()
 {
     #ifdef LAYER_USE_UI
     
+	MEMORY_TAG_SCOPE(MT_EDITOR)
+	PROFILE_ZONE("ImGuiManager::StartImguiFrame")
+
 	// Start the Dear ImGui frame
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
@@ -227,6 +256,20 @@ void ImGuiManager::StartImguiFrame()
 }
 
 void ImGuiManager::SubmitImGuiVulkanCommands(VkCommandBuffer cmdBuffer, u32 frameIndex)
+{
+    #ifdef LAYER_USE_UI
+    
+	BeginImGuiRenderPass(cmdBuffer, frameIndex, VK_SUBPASS_CONTENTS_INLINE);
+
+	RecordImGuiDrawData(cmdBuffer);
+
+	// Submit command buffer
+	vkCmdEndRenderPass(cmdBuffer);
+    
+    #endif // LAYER_USE_UI
+}
+
+void ImGuiManager::BeginImGuiRenderPass(VkCommandBuffer cmdBuffer, u32 frameIndex, VkSubpassContents contents)
 {
     #ifdef LAYER_USE_UI
     
@@ -241,17 +284,32 @@ void ImGuiManager::SubmitImGuiVulkanCommands(VkCommandBuffer cmdBuffer, u32 fram
 	imguiRenderPassBeginInfo.renderArea.extent.height = _swapChainExtentRef.height;
 	imguiRenderPassBeginInfo.clearValueCount = 1;
 	imguiRenderPassBeginInfo.pClearValues = &_imguiClearValue;
-	vkCmdBeginRenderPass(cmdBuffer, &imguiRenderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+	vkCmdBeginRenderPass(cmdBuffer, &imguiRenderPassBeginInfo, contents);
+    
+    #endif // LAYER_USE_UI
+}
 
+void ImGuiManager::RecordImGuiDrawData(VkCommandBuffer cmdBuffer)
+{
+    #ifdef LAYER_USE_UI
+    
 	// Record dear imgui primitives into command buffer
 	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmdBuffer);
-
-	// Submit command buffer
-	vkCmdEndRenderPass(cmdBuffer);
     
     #endif // LAYER_USE_UI
 }
 
+VkRenderPass ImGuiManager::GetImGuiRenderPass()
+{
+	// Stays null without LAYER_USE_UI
+	return _imguiRenderPass;
+}
+
+VkFramebuffer ImGuiManager::GetImGuiFrameBuffer(u32 frameIndex)
+{
+	return _imguiFrameBuffers[frameIndex];
+}
+
 void ImGuiManager::EndImguiFrame()
 {
     #ifdef LAYER_USE_UI
@@ -290,7 +348,7 @@ void ImGuiManager::ShutdownImgui(const VkRef& vkRef)
     #endif // LAYER_USE_UI
 }
 
-void ImGuiManager::CreateImGuiFrameBuffer(const VkRef& vkRef, const T_vector<SwapChainImage, MT_GRAPHICS>& swapChainImages, VkExtent2D swapChainExtent)
+void ImGuiManager::CreateImGuiFrameBuffer(const VkRef& vkRef, const SwapChainImageList& swapChainImages, VkExtent2D swapChainExtent)
 {
     #ifdef LAYER_USE_UI
     
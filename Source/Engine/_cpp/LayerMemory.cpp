@@ -0,0 +1,465 @@
+#include "LayerMemory.h"
+
+
+#ifdef LAYER_USE_CUSTOM_HEAP
+namespace LayerMemory
+{
+	// Every block starts with this header, the payload Allocate() hands out follows it
+	struct _Block
+	{
+		_Block* pPrevPhysical;		// Block right before this one in its pool, nullptr for the first block of a pool
+		u64 sizeAndFlags;			// Payload bytes (multiple of 16) | _freeFlag | _largeFlag
+
+		// Only valid while the block is free (heap free list) or parked in a thread cache, they live in the payload
+		_Block* pNextFree;
+		_Block* pPrevFree;
+	};
+
+	constexpr u64 _blockHeaderSize = 16;
+	constexpr u64 _blockAlignment = 16;
+	constexpr u64 _minPayload = 16;					// Room for the free list links
+	constexpr u64 _freeFlag = 1;
+	constexpr u64 _largeFlag = 2;
+	constexpr u64 _flagMask = _blockAlignment - 1;
+
+	// TLSF levels: the first level is the power of two, the second splits it into 32 linear lists. Sizes under 512 bytes share first level 0.
+	constexpr u32 _slIndexCountLog2 = 5;
+	constexpr u32 _slIndexCount = 1 << _slIndexCountLog2;
+	constexpr u32 _flIndexShift = _slIndexCountLog2 + 4;	// + log2(_blockAlignment)
+	constexpr u32 _flIndexMax = 32;
+	constexpr u32 _flIndexCount = _flIndexMax - _flIndexShift + 1;
+	constexpr u64 _smallBlockSize = 1ULL << _flIndexShift;
+
+	// Pools are taken from the system this size at a time, payloads over _largeBlockSize skip the pools entirely
+	constexpr u64 _poolSize = 4 * MiB;
+	constexpr u64 _largeBlockSize = 1 * MiB;
+
+	// Thread caches hold small blocks in 16 byte size classes up to 256 bytes
+	constexpr u32 _numCacheClasses = 16;
+	constexpr u64 _maxCachedPayload = _numCacheClasses * _blockAlignment;
+	constexpr u32 _cacheRefillCount = 16;			// Blocks carved per refill, one heap lock per refill
+	constexpr u32 _maxCachedBlocks = 64;			// Per class, half get released back to the heap past this
+
+	struct _Heap
+	{
+		u32 flBitmap = 0;
+		std::array<u32, _flIndexCount> slBitmaps = {};
+		std::array<std::array<_Block*, _slIndexCount>, _flIndexCount> freeLists = {};
+
+		u64 reservedBytes = 0;
+		u64 freeBytes = 0;
+		u64 numFreeBlocks = 0;
+		u64 numPools = 0;
+		u64 cacheRefills = 0;
+		u64 cacheReleases = 0;
+	};
+
+	// Constant initialized so the global new overloads can use the heap before any static constructor runs
+	constinit _Heap _heap;
+	constinit std::mutex _heapMutex;
+
+	std::atomic<u64> _largeBlockBytes = 0;
+	std::atomic<u64> _numLargeBlocks = 0;
+
+	struct _ThreadCache
+	{
+		std::array<_Block*, _numCacheClasses> lists = {};	// Singly linked through pNextFree
+		std::array<u32, _numCacheClasses> counts = {};
+		bool bRegistered = false;							// _threadCacheFlusher has been constructed for this thread
+		bool bExited = false;								// Thread is shutting down, go straight to the heap
+	};
+
+	// Trivially destructible so it stays usable while other thread_local destructors free memory
+	constinit thread_local _ThreadCache _threadCache = {};
+
+	// Hands the thread's cached blocks back to the heap when the thread exits
+	struct _ThreadCacheFlusher
+	{
+		~_ThreadCacheFlusher();
+		void Register() {}
+	};
+	thread_local _ThreadCacheFlusher _threadCacheFlusher;
+
+	// --Internal helpers--
+
+	u64 _BlockSize(const _Block* pBlock)					{ return pBlock->sizeAndFlags & ~_flagMask; }
+	_Block* _NextPhysical(_Block* pBlock)					{ return reinterpret_cast<_Block*>(reinterpret_cast<u8*>(pBlock) + _blockHeaderSize + _BlockSize(pBlock)); }
+	void* _Payload(_Block* pBlock)							{ return reinterpret_cast<u8*>(pBlock) + _blockHeaderSize; }
+	_Block* _BlockFromPayload(void* ptr)					{ return reinterpret_cast<_Block*>(static_cast<u8*>(ptr) - _blockHeaderSize); }
+
+	// Free list a block of exactly size bytes belongs in
+	void _MappingInsert(u64 size, u32& fl, u32& sl);
+
+	// First free list whose blocks are all at least size bytes
+	void _MappingSearch(u64 size, u32& fl, u32& sl);
+
+	// Head of the first non empty free list at or above fl/sl (updated to that list), nullptr if there isn't one
+	_Block* _FindSuitableBlock(u32& fl, u32& sl);
+
+	// Free list bookkeeping, heap lock held
+	void _InsertFreeBlock(_Block* pBlock);
+	void _RemoveFreeBlock(_Block* pBlock);
+
+	// Takes another pool from the system big enough for payload, heap lock held
+	bool _AddPool(u64 payload);
+
+	// O(1) TLSF allocate/free of a pool block, heap lock held
+	_Block* _HeapAllocate(u64 payload);
+	void _HeapFree(_Block* pBlock);
+
+	// Carves _cacheRefillCount blocks for a size class out of one heap block
+	void _RefillThreadCache(_ThreadCache& cache, u32 sizeClass);
+
+	// Returns cached blocks of a size class to the heap until keepCount are left
+	void _ReleaseThreadCache(_ThreadCache& cache, u32 sizeClass, u32 keepCount);
+}
+
+void* LayerMemory::Allocate(size_t size)
+{
+	const u64 payload = std::max<u64>(_minPayload, (size + _blockAlignment - 1) & ~_flagMask);
+
+	if (payload > _largeBlockSize) [[unlikely]]
+	{
+		_Block* pBlock = static_cast<_Block*>(AlignedMalloc(_blockHeaderSize + payload, _blockAlignment));
+		if (pBlock == nullptr) { return nullptr; }
+
+		pBlock->pPrevPhysical = nullptr;
+		pBlock->sizeAndFlags = payload | _largeFlag;
+		_largeBlockBytes.fetch_add(payload, std::memory_order_relaxed);
+		_numLargeBlocks.fetch_add(1, std::memory_order_relaxed);
+		return _Payload(pBlock);
+	}
+
+	_ThreadCache& cache = _threadCache;
+	if (payload <= _maxCachedPayload && !cache.bExited)
+	{
+		if (!cache.bRegistered) [[unlikely]]
+		{
+			// Set first, registering the flusher can allocate
+			cache.bRegistered = true;
+			_threadCacheFlusher.Register();
+		}
+
+		const u32 sizeClass = static_cast<u32>(payload / _blockAlignment) - 1;
+		if (cache.lists[sizeClass] == nullptr)
+		{
+			_RefillThreadCache(cache, sizeClass);
+		}
+
+		_Block* pBlock = cache.lists[sizeClass];
+		if (pBlock == nullptr) [[unlikely]] { return nullptr; }
+
+		cache.lists[sizeClass] = pBlock->pNextFree;
+		cache.counts[sizeClass]--;
+		return _Payload(pBlock);
+	}
+
+	std::lock_guard lock(_heapMutex);
+	_Block* pBlock = _HeapAllocate(payload);
+	return pBlock != nullptr ? _Payload(pBlock) : nullptr;
+}
+
+void LayerMemory::Free(void* ptr)
+{
+	if (ptr == nullptr) { return; }
+
+	_Block* pBlock = _BlockFromPayload(ptr);
+	const u64 size = _BlockSize(pBlock);
+
+	if (pBlock->sizeAndFlags & _largeFlag) [[unlikely]]
+	{
+		_largeBlockBytes.fetch_sub(size, std::memory_order_relaxed);
+		_numLargeBlocks.fetch_sub(1, std::memory_order_relaxed);
+		AlignedFree(pBlock);
+		return;
+	}
+
+	// Small blocks go to the freeing thread's cache, whichever thread allocated them
+	_ThreadCache& cache = _threadCache;
+	if (size <= _maxCachedPayload && !cache.bExited)
+	{
+		if (!cache.bRegistered) [[unlikely]]
+		{
+			cache.bRegistered = true;
+			_threadCacheFlusher.Register();
+		}
+
+		const u32 sizeClass = static_cast<u32>(size / _blockAlignment) - 1;
+		pBlock->pNextFree = cache.lists[sizeClass];
+		cache.lists[sizeClass] = pBlock;
+
+		if (++cache.counts[sizeClass] > _maxCachedBlocks)
+		{
+			_ReleaseThreadCache(cache, sizeClass, _maxCachedBlocks / 2);
+		}
+		return;
+	}
+
+	std::lock_guard lock(_heapMutex);
+	_HeapFree(pBlock);
+}
+
+LayerMemory::HeapStats LayerMemory::GetHeapStats()
+{
+	HeapStats stats = {};
+
+	{
+		std::lock_guard lock(_heapMutex);
+		stats.reservedBytes = _heap.reservedBytes;
+		stats.freeBytes = _heap.freeBytes;
+		stats.usedBytes = _heap.reservedBytes - _heap.freeBytes;
+		stats.numFreeBlocks = _heap.numFreeBlocks;
+		stats.numPools = _heap.numPools;
+		stats.cacheRefills = _heap.cacheRefills;
+		stats.cacheReleases = _heap.cacheReleases;
+
+		// Largest free block lives in the highest non empty list, which can hold a range of sizes
+		if (_heap.flBitmap != 0)
+		{
+			const u32 fl = 31 - std::countl_zero(_heap.flBitmap);
+			const u32 sl = 31 - std::countl_zero(_heap.slBitmaps[fl]);
+			for (_Block* pBlock = _heap.freeLists[fl][sl]; pBlock != nullptr; pBlock = pBlock->pNextFree)
+			{
+				stats.largestFreeBlock = std::max(stats.largestFreeBlock, _BlockSize(pBlock));
+			}
+		}
+	}
+
+	// A free block can't span pools, so compare against the biggest block the free bytes could form
+	const u64 idealLargestFree = std::min(stats.freeBytes, _poolSize - 2 * _blockHeaderSize);
+	stats.fragmentation = idealLargestFree == 0 ? 0.0f : 1.0f - static_cast<f32>(std::min(stats.largestFreeBlock, idealLargestFree)) / static_cast<f32>(idealLargestFree);
+
+	stats.largeBlockBytes = _largeBlockBytes.load(std::memory_order_relaxed);
+	stats.numLargeBlocks = _numLargeBlocks.load(std::memory_order_relaxed);
+
+	return stats;
+}
+
+LayerMemory::_ThreadCacheFlusher::~_ThreadCacheFlusher()
+{
+	_ThreadCache& cache = _threadCache;
+	cache.bExited = true;
+
+	for (u32 sizeClass = 0; sizeClass < _numCacheClasses; sizeClass++)
+	{
+		if (cache.counts[sizeClass] > 0)
+		{
+			_ReleaseThreadCache(cache, sizeClass, 0);
+		}
+	}
+}
+
+void LayerMemory::_MappingInsert(u64 size, u32& fl, u32& sl)
+{
+	if (size < _smallBlockSize)
+	{
+		fl = 0;
+		sl = static_cast<u32>(size / (_smallBlockSize / _slIndexCount));
+	}
+	else
+	{
+		const u32 topBit = 63 - std::countl_zero(size);
+		sl = static_cast<u32>(size >> (topBit - _slIndexCountLog2)) ^ _slIndexCount;
+		fl = topBit - (_flIndexShift - 1);
+	}
+}
+
+void LayerMemory::_MappingSearch(u64 size, u32& fl, u32& sl)
+{
+	// Round up to the next list boundary so any block in the list found is big enough, this is what keeps allocation O(1)
+	if (size >= _smallBlockSize)
+	{
+		size += (1ULL << ((63 - std::countl_zero(size)) - _slIndexCountLog2)) - 1;
+	}
+	_MappingInsert(size, fl, sl);
+}
+
+LayerMemory::_Block* LayerMemory::_FindSuitableBlock(u32& fl, u32& sl)
+{
+	u32 slMap = _heap.slBitmaps[fl] & (~0u << sl);
+	if (slMap == 0)
+	{
+		// Nothing left in this first level, take the smallest list of the next non empty one
+		const u32 flMap = fl + 1 < _flIndexCount ? _heap.flBitmap & (~0u << (fl + 1)) : 0;
+		if (flMap == 0) { return nullptr; }
+
+		fl = std::countr_zero(flMap);
+		slMap = _heap.slBitmaps[fl];
+	}
+
+	sl = std::countr_zero(slMap);
+	return _heap.freeLists[fl][sl];
+}
+
+void LayerMemory::_InsertFreeBlock(_Block* pBlock)
+{
+	u32 fl, sl;
+	_MappingInsert(_BlockSize(pBlock), fl, sl);
+
+	_Block*& pHead = _heap.freeLists[fl][sl];
+	pBlock->sizeAndFlags |= _freeFlag;
+	pBlock->pPrevFree = nullptr;
+	pBlock->pNextFree = pHead;
+	if (pHead != nullptr)
+	{
+		pHead->pPrevFree = pBlock;
+	}
+	pHead = pBlock;
+
+	_heap.flBitmap |= 1u << fl;
+	_heap.slBitmaps[fl] |= 1u << sl;
+	_heap.freeBytes += _BlockSize(pBlock);
+	_heap.numFreeBlocks++;
+}
+
+void LayerMemory::_RemoveFreeBlock(_Block* pBlock)
+{
+	u32 fl, sl;
+	_MappingInsert(_BlockSize(pBlock), fl, sl);
+
+	if (pBlock->pPrevFree != nullptr)
+	{
+		pBlock->pPrevFree->pNextFree = pBlock->pNextFree;
+	}
+	else
+	{
+		_heap.freeLists[fl][sl] = pBlock->pNextFree;
+		if (pBlock->pNextFree == nullptr)
+		{
+			_heap.slBitmaps[fl] &= ~(1u << sl);
+			if (_heap.slBitmaps[fl] == 0)
+			{
+				_heap.flBitmap &= ~(1u << fl);
+			}
+		}
+	}
+	if (pBlock->pNextFree != nullptr)
+	{
+		pBlock->pNextFree->pPrevFree = pBlock->pPrevFree;
+	}
+
+	pBlock->sizeAndFlags &= ~_freeFlag;
+	_heap.freeBytes -= _BlockSize(pBlock);
+	_heap.numFreeBlocks--;
+}
+
+bool LayerMemory::_AddPool(u64 payload)
+{
+	// Room for the rounding _MappingSearch does, the first block's header and the end sentinel
+	const u64 poolBytes = std::max(_poolSize, payload + (payload >> _slIndexCountLog2) + 2 * _blockHeaderSize + _smallBlockSize);
+
+	u8* pPool = static_cast<u8*>(AlignedMalloc(poolBytes, 64));
+	if (pPool == nullptr) { return false; }
+
+	_Block* pBlock = reinterpret_cast<_Block*>(pPool);
+	pBlock->pPrevPhysical = nullptr;
+	pBlock->sizeAndFlags = poolBytes - 2 * _blockHeaderSize;
+
+	// Zero size, never free sentinel so coalescing stops at the end of the pool
+	_Block* pSentinel = _NextPhysical(pBlock);
+	pSentinel->pPrevPhysical = pBlock;
+	pSentinel->sizeAndFlags = 0;
+
+	_InsertFreeBlock(pBlock);
+	_heap.reservedBytes += poolBytes;
+	_heap.numPools++;
+	return true;
+}
+
+LayerMemory::_Block* LayerMemory::_HeapAllocate(u64 payload)
+{
+	u32 fl, sl;
+	_MappingSearch(payload, fl, sl);
+
+	_Block* pBlock = _FindSuitableBlock(fl, sl);
+	if (pBlock == nullptr)
+	{
+		if (!_AddPool(payload)) { return nullptr; }
+
+		_MappingSearch(payload, fl, sl);
+		pBlock = _FindSuitableBlock(fl, sl);
+	}
+	_RemoveFreeBlock(pBlock);
+
+	// Split the tail off into its own free block if it's big enough to be one
+	const u64 blockSize = _BlockSize(pBlock);
+	if (blockSize >= payload + _blockHeaderSize + _minPayload)
+	{
+		_Block* pRemainder = reinterpret_cast<_Block*>(reinterpret_cast<u8*>(pBlock) + _blockHeaderSize + payload);
+		pRemainder->pPrevPhysical = pBlock;
+		pRemainder->sizeAndFlags = blockSize - payload - _blockHeaderSize;
+		_NextPhysical(pRemainder)->pPrevPhysical = pRemainder;
+
+		pBlock->sizeAndFlags = payload;
+		_InsertFreeBlock(pRemainder);
+	}
+
+	return pBlock;
+}
+
+void LayerMemory::_HeapFree(_Block* pBlock)
+{
+	// Coalesce with free physical neighbours, so there are never two free blocks next to each other
+	_Block* pPrev = pBlock->pPrevPhysical;
+	if (pPrev != nullptr && (pPrev->sizeAndFlags & _freeFlag))
+	{
+		_RemoveFreeBlock(pPrev);
+		pPrev->sizeAndFlags = _BlockSize(pPrev) + _blockHeaderSize + _BlockSize(pBlock);
+		pBlock = pPrev;
+		_NextPhysical(pBlock)->pPrevPhysical = pBlock;
+	}
+
+	_Block* pNext = _NextPhysical(pBlock);
+	if (pNext->sizeAndFlags & _freeFlag)
+	{
+		_RemoveFreeBlock(pNext);
+		pBlock->sizeAndFlags = _BlockSize(pBlock) + _blockHeaderSize + _BlockSize(pNext);
+		_NextPhysical(pBlock)->pPrevPhysical = pBlock;
+	}
+
+	_InsertFreeBlock(pBlock);
+}
+
+void LayerMemory::_RefillThreadCache(_ThreadCache& cache, u32 sizeClass)
+{
+	const u64 payload = (sizeClass + 1) * _blockAlignment;
+	const u64 stride = _blockHeaderSize + payload;
+
+	std::lock_guard lock(_heapMutex);
+
+	_Block* pRun = _HeapAllocate(stride * _cacheRefillCount - _blockHeaderSize);
+	if (pRun == nullptr) { return; }
+	_heap.cacheRefills++;
+
+	// Cut the run into physically adjacent blocks, the last one keeps any slack the heap left on the run
+	const u64 runSize = _BlockSize(pRun);
+	_Block* pPrev = pRun->pPrevPhysical;
+	for (u32 i = 0; i < _cacheRefillCount; i++)
+	{
+		_Block* pBlock = reinterpret_cast<_Block*>(reinterpret_cast<u8*>(pRun) + i * stride);
+		pBlock->pPrevPhysical = pPrev;
+		pBlock->sizeAndFlags = i + 1 < _cacheRefillCount ? payload : runSize - i * stride;
+		pBlock->pNextFree = cache.lists[sizeClass];
+		cache.lists[sizeClass] = pBlock;
+		pPrev = pBlock;
+	}
+	_NextPhysical(pPrev)->pPrevPhysical = pPrev;
+
+	// The slack block may be a bigger class, it just gets served as this one
+	cache.counts[sizeClass] += _cacheRefillCount;
+}
+
+void LayerMemory::_ReleaseThreadCache(_ThreadCache& cache, u32 sizeClass, u32 keepCount)
+{
+	std::lock_guard lock(_heapMutex);
+	_heap.cacheReleases++;
+
+	while (cache.counts[sizeClass] > keepCount)
+	{
+		_Block* pBlock = cache.lists[sizeClass];
+		cache.lists[sizeClass] = pBlock->pNextFree;
+		cache.counts[sizeClass]--;
+		_HeapFree(pBlock);
+	}
+}
+#endif
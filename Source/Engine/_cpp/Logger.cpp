@@ -1,6 +1,7 @@
 #include "Logger.h"
 #include "ImGuiManager.h"
 #include "FileHelper.h"
+#include "LayerFlatMap.h"
 
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "misc-no-recursion"
@@ -8,16 +9,241 @@
 // Private
 namespace Logger
 {
-	// Global log message buffer that will be used by _DrawLogUI()
+	// Fixed size ring slot. A record takes one slot, or several consecutive ones for long messages.
+	struct alignas(64) _LogSlot
+	{
+		std::atomic<u64> sequence;					// See _LoadSequence()
+		char bytes[256 - sizeof(std::atomic<u64>)];	// First slot of a record: _LogRecordHeader + text, following slots: text only
+	};
+
+	enum _LogRecordType : u8
+	{
+		_LOG_RECORD_TEXT,
+		_LOG_RECORD_SESSION_LOG_ONLY,	// AddToSessionLogFile(), no severity prefix and not shown in the live logger
+		_LOG_RECORD_BINARY				// Encoded BLOG_RECORD_MESSAGE for the binary log
+	};
+
+	struct _LogRecordHeader
+	{
+		LogSeverityLevel severity;
+		u32 line;					// 0 when there's no location info
+		u32 textLength;				// Or record size for _LOG_RECORD_BINARY
+		u16 numSlots;
+		_LogRecordType type;
+		const char* file;			// String literals, only the pointers are queued
+		const char* function;
+	};
+
+	constexpr u32 _ringCapacity = 4096;				// Power of two, 1 MiB of slots
+	constexpr u32 _maxSlotsPerRecord = 32;			// Longer messages get truncated (~7.9 KiB)
+	constexpr u64 _headSlotText = sizeof(_LogSlot::bytes) - sizeof(_LogRecordHeader);
+	constexpr u64 _slotText = sizeof(_LogSlot::bytes);
+
+	// How often the writer thread wakes up to drain the ring
+	constexpr std::chrono::milliseconds _writerInterval{ 2 };
+
+	// Multi producer, single consumer ring. Producers claim slots with one add on _writePos, whoever holds _drainMutex consumes.
+	// Zero initialized, so logging works before any static constructor has run.
+	std::array<_LogSlot, _ringCapacity> _ring = {};
+	alignas(64) std::atomic<u64> _writePos = 0;
+	alignas(64) u64 _readPos = 0;					// Only touched with _drainMutex held
+	std::mutex _drainMutex;
+
+	// Times a producer found the ring full and had to drain it itself
+	std::atomic<u64> _ringFullStalls = 0;
+
+	// Background writer, draining the ring every _writerInterval until ShutdownLogging()
+	std::thread _writerThread;
+	std::mutex _writerWakeMutex;
+	std::condition_variable _writerWake;
+	bool _bStopWriter = false;
+
+	// Set once ShutdownLogging() stops the writer, every record is drained by whoever logged it from then on
+	std::atomic<bool> _bWriterStopped = false;
+
+	// Session log stays open for the whole process, so logs after ShutdownLogging() still make it to disk. Only touched with _drainMutex held.
+	std::ofstream _sessionLogFile;
+	u64 _sessionLogBytes = 0;
+
+	// Once the session log reaches this size it's rotated to SessionLog.1.txt (.1 -> .2 etc.) and a fresh one started
+	constexpr u64 _maxSessionLogBytes = 32 * MiB;
+	constexpr u32 _numRotatedSessionLogs = 3;
+
+	// Formatted lines are written out whenever this much is pending, so draining a full ring doesn't hold it all at once
+	constexpr u64 _sessionLogWriteSize = 64 * KiB;
+
+	// Lines drained before InitializeLogging() opened the session log, anything past the cap is dropped
+	constexpr u64 _maxUnwrittenSessionLog = 1 * MiB;
+	T_string _unwrittenSessionLog = {};
+
+	// Formatted lines waiting to be written, reused so draining doesn't reallocate
+	T_string _drainBuffer = {};
+
+	// Live logger lines from the current drain, as offsets into _drainBuffer or _liveOnlyText
+	struct _DrainedLine
+	{
+		u64 start;
+		u64 end;
+		LogSeverityLevel severity;
+		bool bLiveOnly;
+	};
+	T_vector<_DrainedLine, MT_ENGINE> _drainedLiveLines = {};
+
+	// Text of binary log records formatted for the live logger only, they don't go in SessionLog.txt
+	T_string _liveOnlyText = {};
+
+	// Structured log sites registered by the LOG_*_FMT macros, indexed by site id
+	T_vector<const BinaryLogSite*, MT_ENGINE> _binaryLogSites = {};
+	std::mutex _binaryLogSiteMutex;
+
+	// Drain side copy of _binaryLogSites so records can be decoded without taking its lock. Only touched with _drainMutex held, like
+	// everything binary log below.
+	T_vector<const BinaryLogSite*, MT_ENGINE> _drainedBinaryLogSites = {};
+	u32 _numBinaryLogSitesWritten = 0;		// Sites whose BLOG_RECORD_SITE is already in the binary log stream
+
+	std::ofstream _binaryLogFile;
+	u64 _binaryLogBytes = 0;
+	u64 _binaryLogStartTimestamp = 0;
+	T_string _binaryDrainBuffer = {};		// Records waiting to be written, same write size as _drainBuffer
+	T_string _unwrittenBinaryLog = {};		// Records drained before InitializeLogging(), capped like _unwrittenSessionLog
+	T_string _binaryRecord = {};			// Scratch for gathering one record out of the ring
+
+	// Most recent log lines shown by _DrawLogUI(). Lines are numbered in the order they arrive, line n lives at n % _maxLiveLogLines
+	// until it's overwritten. Guarded by _liveLogMutex, the writer fills it and the UI reads it, same for everything live logger below.
+	constexpr u32 _maxLiveLogLines = 10000;
 	T_vector<LogLine, MT_ENGINE> _liveLogLineBuffer = {};
+	u64 _numLiveLogLines = 0;			// Lines ever added
+	u64 _firstShownLiveLogLine = 0;		// Lines before this were cleared from the Log window
+	std::mutex _liveLogMutex;
 
-	// Global log buffer that will hold all log records
-	T_string _sessionLogBuffer = {};
+	// Ascending live logger line numbers, old ones get dropped from the front as the ring overwrites them
+	struct _LiveLogLineIndex
+	{
+		T_vector<u64, MT_ENGINE> lines = {};
+		u64 start = 0;
 
-	// Path relative to the current working directory to place the session log
-	constexpr const char* _sessionLogPath = "Logs\\SessionLog.txt";
+		u64 Size() const					{ return lines.size() - start; }
+		u64 operator[](u64 i) const			{ return lines[start + i]; }
+		void Add(u64 line)					{ lines.push_back(line); }
+		void Clear()						{ lines.clear(); start = 0; }
 
-	// Dump the _sessionLogBuffer into the _sessionLogPath and open the txt file in an external viewer
+		// Drops every line before oldestLine, compacting once most of the vector is dropped lines
+		void DropBefore(u64 oldestLine)
+		{
+			while (start < lines.size() && lines[start] < oldestLine) { start++; }
+			if (start >= 1024 && start * 2 >= lines.size())
+			{
+				lines.erase(lines.begin(), lines.begin() + static_cast<i64>(start));
+				start = 0;
+			}
+		}
+	};
+
+	// Lines of each severity still in the ring, kept up to date by the writer so severity toggles don't have to scan every line
+	std::array<_LiveLogLineIndex, LOG_SEVERITY_MAX> _severityLineIndices = {};
+
+	// Lines passing the Log window's filter and severity toggles, extended with new lines each frame and only rebuilt when those change
+	_LiveLogLineIndex _filteredLines = {};
+	u64 _numLinesFiltered = 0;			// Lines before this have been run through the filter
+	std::array<bool, LOG_SEVERITY_MAX> _shownSeverities = { true, true, true, true, true, true, true };
+
+	constexpr const char* _severityNames[] = { "Fatal", "Error", "Warning", "Info", "Benchmark", "Debug", "Other" };
+
+	// Per key rate limiting state, see PassRateLimit()
+	struct _RateLimitEntry
+	{
+		std::chrono::steady_clock::time_point windowStart = {};
+		u32 numInWindow = 0;			// Messages let through this window
+		u64 numSuppressed = 0;			// Dropped since the last summary line
+		u64 totalPrinted = 0;			// Whole session, for the Log window
+		u64 totalSuppressed = 0;
+		LogSeverityLevel severity = LOG_SEVERITY_INFO;
+		T_string message = {};			// First message printed for the key
+	};
+
+	// Each key can print _rateLimitBurst messages per _rateLimitWindow
+	constexpr u32 _rateLimitBurst = 8;
+	constexpr std::chrono::seconds _rateLimitWindow{ 1 };
+
+	// Past this many keys idle ones are dropped, and if they're all busy new keys go unlimited
+	constexpr u64 _maxRateLimitKeys = 1024;
+
+	T_flat_map<u64, _RateLimitEntry, MT_ENGINE> _rateLimits = {};
+	std::mutex _rateLimitMutex;
+	std::atomic<u64> _totalSuppressedLogs = 0;
+
+	// Last time the writer thread summarized keys that went quiet after being suppressed
+	std::chrono::steady_clock::time_point _lastRateLimitSweep = {};
+
+	// Binary log lives next to the session log (Logger::sessionLogPath)
+	constexpr const char* _binaryLogPath = "Logs\\SessionLog.bin";
+
+	constexpr const char* _severityStrings[] = {
+		"[FATAL]: ",
+		"[ERROR]: ",
+		"[WARNING]: ",
+		"[INFO]: ",
+		"[BENCHMARK]: ",
+		"[DEBUG]: ",
+		"" // OTHER
+	};
+
+	constexpr ImVec4 _severityColors[] = {
+		{ 0.45f, 0.0f, 0.0f, 1.0f },	// FATAL == Dark Red
+		{ 0.85f, 0.5f, 0.0f, 1.0f },	// ERROR == Dark Orange
+		{ 1.0f, 1.0f, 0.0f, 1.0f },		// WARNING == Yellow
+		{ 1.0f, 1.0f, 1.0f, 1.0f },		// INFO == White
+		{ 0.73f, 0.29f, 1.0f, 1.0f },	// BENCHMARK == Light Purple
+		{ 0.29f, 0.87f, 1.0f, 1.0f },	// DEBUG == Light Blue
+		{ 0.0f, 0.80f, 0.0f, 1.0f }		// OTHER == Green
+	};
+
+	// Sequence of the slot position pos maps to: pos when free for that lap, pos + 1 once published, pos + _ringCapacity once drained.
+	// Slots store it minus their index so an all zero ring starts out free for the first lap.
+	u64 _LoadSequence(u64 pos);
+	void _StoreSequence(u64 pos, u64 sequence);
+
+	// Copies a record into the ring, draining it on the calling thread if it's full
+	void _EnqueueRecord(LogSeverityLevel severityLevel, const char* bytes, u64 length, const char* file, u32 line, const char* function, _LogRecordType type);
+
+	// Formats and writes every published record, caller must hold _drainMutex
+	void _DrainRing();
+
+	// Adds a drained binary record (in _binaryRecord) to the binary log, preceded by any sites it hasn't described yet. Caller must hold _drainMutex.
+	void _DrainBinaryRecord(LogSeverityLevel severityLevel);
+
+	// Appends _drainBuffer to the session log (rotating it first if it would pass _maxSessionLogBytes), does the same for the binary log
+	// and hands drained lines to the live logger. Caller must hold _drainMutex.
+	void _WriteDrainBuffer();
+
+	// Shifts SessionLog.txt -> SessionLog.1.txt -> ... (same for .bin) and reopens an empty log at path, caller must hold _drainMutex
+	void _RotateLogFile(std::ofstream& file, const char* path, std::ios::openmode mode);
+
+	// Starts a binary log file with the file header and every site written so far, so each rotated file decodes on its own
+	void _WriteBinaryLogHeader();
+
+	// Live logger line by number, caller must hold _liveLogMutex and make sure it's still in the ring
+	const LogLine& _GetLiveLogLine(u64 line);
+
+	// Oldest line still in the ring and not cleared, caller must hold _liveLogMutex
+	u64 _OldestLiveLogLine();
+
+	// Brings _filteredLines up to date, starting over when bRebuild. Caller must hold _liveLogMutex.
+	void _UpdateFilteredLines(const ImGuiTextFilter& filter, bool bRebuild);
+
+	// Queues "Repeated N more times" for entry and starts its next window, caller must hold _rateLimitMutex
+	void _SummarizeSuppressedLogs(_RateLimitEntry& entry, std::chrono::steady_clock::time_point now);
+
+	// Summarizes every key whose window is over (all of them when bAll), drops long idle keys if there are too many. Takes _rateLimitMutex.
+	void _SweepRateLimits(bool bAll);
+
+	// Writer thread loop
+	void _WriterThreadMain();
+
+	// Shows the blocking FATAL/ERROR popup, location info included
+	void _ShowErrorPopup(LogSeverityLevel severityLevel, const char* message, const char* file, u32 line, const char* function);
+
+	// Flush the session log and open the txt file in an external viewer
 	void _OpenSessionLogFile();
     
     //
@@ -28,72 +254,114 @@ void Logger::InitializeLogging()
 {
 	FileHelper::CreateFolderIfAbsent("Logs\\");
     REGISTER_EDITOR_UI_WINDOW(nullptr, Logger::_DrawLogUI)
+
+	{
+		std::lock_guard lock(_drainMutex);
+		_sessionLogFile.open(T_string(FileHelper::currentWorkingDirectory, sessionLogPath).c_str(), std::ios::out | std::ios::trunc);
+		_sessionLogFile << _unwrittenSessionLog;
+		_sessionLogBytes = _unwrittenSessionLog.size();
+		_unwrittenSessionLog.clear();
+		_unwrittenSessionLog.shrink_to_fit();
+
+		_drainBuffer.reserve(_sessionLogWriteSize + 16 * KiB);
+		_liveLogLineBuffer.reserve(_maxLiveLogLines);
+
+	#ifdef LAYER_USE_BINARY_LOG
+		_binaryLogStartTimestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		_binaryLogFile.open(T_string(FileHelper::currentWorkingDirectory, _binaryLogPath).c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+		_WriteBinaryLogHeader();
+		_binaryLogFile.write(_unwrittenBinaryLog.data(), static_cast<std::streamsize>(_unwrittenBinaryLog.size()));
+		_binaryLogBytes += _unwrittenBinaryLog.size();
+		_unwrittenBinaryLog.clear();
+		_unwrittenBinaryLog.shrink_to_fit();
+
+		_binaryDrainBuffer.reserve(_sessionLogWriteSize + 16 * KiB);
+	#endif
+	}
+
+	{
+		std::lock_guard lock(_rateLimitMutex);
+		_rateLimits.reserve(_maxRateLimitKeys);
+	}
+
+	_bStopWriter = false;
+	_bWriterStopped.store(false, std::memory_order_release);
+	_writerThread = std::thread(_WriterThreadMain);
 }
 
 void Logger::ShutdownLogging()
 {
-	FileHelper::WriteStringToFile(_sessionLogBuffer, _sessionLogPath);
+	_bWriterStopped.store(true, std::memory_order_release);
+
+	if (_writerThread.joinable())
+	{
+		{
+			std::lock_guard lock(_writerWakeMutex);
+			_bStopWriter = true;
+		}
+		_writerWake.notify_one();
+
+		// A FATAL logged on the writer thread itself (e.g. by a fatalShutdownBroadcaster listener) ends up here too, it can't join itself
+		if (std::this_thread::get_id() != _writerThread.get_id())
+		{
+			_writerThread.join();
+		}
+		else
+		{
+			_writerThread.detach();
+		}
+	}
+
+	_SweepRateLimits(true);
+	FlushLogging();
+}
+
+void Logger::FlushLogging()
+{
+	std::lock_guard lock(_drainMutex);
+	_DrainRing();
 }
 
 void Logger::AddToSessionLogFile(const char* message)
 {
-	_sessionLogBuffer.AppendMany(message, "\n");
+	_EnqueueRecord(LOG_SEVERITY_OTHER, message, strlen(message), nullptr, 0, nullptr, _LOG_RECORD_SESSION_LOG_ONLY);
 }
 
 void Logger::AddToSessionLogFile(const T_string& message)
 {
-	_sessionLogBuffer.AppendMany(message, "\n");
+	_EnqueueRecord(LOG_SEVERITY_OTHER, message.c_str(), message.size(), nullptr, 0, nullptr, _LOG_RECORD_SESSION_LOG_ONLY);
 }
 
 void Logger::PrintLog(LogSeverityLevel severityLevel, const char* message)
+{
+	PrintLog(severityLevel, message, nullptr, 0, nullptr);
+}
+
+void Logger::PrintLog(LogSeverityLevel severityLevel, const T_string& message)
+{
+	PrintLog(severityLevel, message.c_str(), nullptr, 0, nullptr);
+}
+
+void Logger::PrintLog(LogSeverityLevel severityLevel, const T_string& message, const char* file, u32 line, const char* function)
+{
+	PrintLog(severityLevel, message.c_str(), file, line, function);
+}
+
+void Logger::PrintLog(LogSeverityLevel severityLevel, const char* message, const char* file, u32 line, const char* function)
 {
     if(severityLevel >= LOG_SEVERITY_MAX)
     {
         LOG_ERROR("severityLevel >= LOG_SEVERITY_MAX")
         return;
     }
-    
-	constexpr const char* severityStrings[] = {
-		"[FATAL]: ",
-		"[ERROR]: ",
-		"[WARNING]: ",
-		"[INFO]: ",
-		"[BENCHMARK]: ",
-		"[DEBUG]: ",
-		"" // OTHER
-		};
-  
 
-	constexpr ImVec4 severityColors[] = {
-		{ 0.45f, 0.0f, 0.0f, 1.0f },	// FATAL == Dark Red
-		{ 0.85f, 0.5f, 0.0f, 1.0f },	// ERROR == Dark Orange
-		{ 1.0f, 1.0f, 0.0f, 1.0f },		// WARNING == Yellow
-		{ 1.0f, 1.0f, 1.0f, 1.0f },		// INFO == White
-		{ 0.73f, 0.29f, 1.0f, 1.0f },	// BENCHMARK == Light Purple
-		{ 0.29f, 0.87f, 1.0f, 1.0f },	// DEBUG == Light Blue
-		{ 0.0f, 0.80f, 0.0f, 1.0f }		// OTHER == Green
-	};
- 
-
-	const T_string printBuffer = T_string(severityStrings[severityLevel], message);
-	_sessionLogBuffer.AppendMany(printBuffer, "\n");
-    
-    #if LAYER_USE_LIVE_LOGGER
-        _liveLogLineBuffer.emplace_back(severityColors[severityLevel], printBuffer);
-    #endif
+	_EnqueueRecord(severityLevel, message, strlen(message), file, line, function, _LOG_RECORD_TEXT);
 
-
-	// TODO: Update this to pop up messages on Linux and MacOS
 	if (severityLevel == LOG_SEVERITY_FATAL)
 	{
-        #if LAYER_PLATFORM_WINDOWS
-            MessageBoxA(nullptr, message, "Fatal Error", MB_ICONERROR | MB_OK);
-        #elif LAYER_PLATFORM_LINUX
-            //TODO: Implement Linux version
-        #elif LAYER_PLATFORM_APPLE
-            //TODO: Implement Apple version
-        #endif
-		
+		// Get everything up to the fatal line on disk before anything else can go wrong
+		FlushLogging();
+		_ShowErrorPopup(severityLevel, message, file, line, function);
 
 		Logger::fatalShutdownBroadcaster.Broadcast();
 		ShutdownLogging();
@@ -101,26 +369,514 @@ void Logger::PrintLog(LogSeverityLevel severityLevel, const char* message)
 	}
 	else if (severityLevel == LOG_SEVERITY_ERROR)
 	{
-        #if LAYER_PLATFORM_WINDOWS
-            MessageBoxA(nullptr, message, "Error", MB_ICONERROR | MB_OK);
-        #elif LAYER_PLATFORM_LINUX
-            //TODO: Implement Linux version
-        #elif LAYER_PLATFORM_APPLE
-            //TODO: Implement Apple version
-        #endif
+		_ShowErrorPopup(severityLevel, message, file, line, function);
 	}
 }
 
-void Logger::PrintLog(LogSeverityLevel severityLevel, const T_string& message)
+bool Logger::PassRateLimit(LogSeverityLevel severityLevel, u64 key)
+{
+	// FATAL exits anyway, never hide it
+	if (severityLevel == LOG_SEVERITY_FATAL) { return true; }
+
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::lock_guard lock(_rateLimitMutex);
+
+	auto entryIt = _rateLimits.find(key);
+	if (entryIt == _rateLimits.end())
+	{
+		if (_rateLimits.size() >= _maxRateLimitKeys) { return true; } // Table full, see _SweepRateLimits()
+
+		entryIt = _rateLimits.try_emplace(key).first;
+		entryIt->second.windowStart = now;
+		entryIt->second.severity = severityLevel;
+	}
+	_RateLimitEntry& entry = entryIt->second;
+
+	if (now - entry.windowStart >= _rateLimitWindow)
+	{
+		_SummarizeSuppressedLogs(entry, now);
+	}
+
+	if (entry.numInWindow < _rateLimitBurst)
+	{
+		entry.numInWindow++;
+		entry.totalPrinted++;
+		return true;
+	}
+
+	entry.numSuppressed++;
+	entry.totalSuppressed++;
+	_totalSuppressedLogs.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
+
+void Logger::PrintRateLimitedLog(LogSeverityLevel severityLevel, u64 key, const T_string& message, const char* file, u32 line, const char* function)
+{
+	PrintRateLimitedLog(severityLevel, key, message.c_str(), file, line, function);
+}
+
+void Logger::PrintRateLimitedLog(LogSeverityLevel severityLevel, u64 key, const char* message, const char* file, u32 line, const char* function)
+{
+	{
+		std::lock_guard lock(_rateLimitMutex);
+		auto entryIt = _rateLimits.find(key);
+		if (entryIt != _rateLimits.end() && entryIt->second.message.empty())
+		{
+			entryIt->second.message = message;
+		}
+	}
+
+	// Same as the plain loggers, WARNING and up get location info
+	if (severityLevel <= LOG_SEVERITY_WARNING)
+	{
+		PrintLog(severityLevel, message, file, line, function);
+	}
+	else
+	{
+		PrintLog(severityLevel, message);
+	}
+}
+
+void Logger::_SummarizeSuppressedLogs(_RateLimitEntry& entry, std::chrono::steady_clock::time_point now)
+{
+	if (entry.numSuppressed > 0)
+	{
+		const f64 seconds = std::chrono::duration<f64>(now - entry.windowStart).count();
+		char prefix[96];
+		snprintf(prefix, sizeof(prefix), "Repeated %llu more times in %.1fs: ", static_cast<unsigned long long>(entry.numSuppressed), seconds);
+
+		// Straight into the ring, a summary of errors shouldn't pop up another error box
+		const T_string summary(prefix, entry.message);
+		_EnqueueRecord(entry.severity, summary.c_str(), summary.size(), nullptr, 0, nullptr, _LOG_RECORD_TEXT);
+	}
+
+	entry.windowStart = now;
+	entry.numInWindow = 0;
+	entry.numSuppressed = 0;
+}
+
+void Logger::_SweepRateLimits(bool bAll)
+{
+	const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::lock_guard lock(_rateLimitMutex);
+
+	for (auto entryIt = _rateLimits.begin(); entryIt != _rateLimits.end();)
+	{
+		_RateLimitEntry& entry = entryIt->second;
+		const bool bWindowOver = now - entry.windowStart >= _rateLimitWindow;
+		if (entry.numSuppressed > 0 && (bWindowOver || bAll))
+		{
+			_SummarizeSuppressedLogs(entry, now);
+		}
+
+		// Nearly full, forget keys that have been quiet for a while so new ones still get limited
+		if (_rateLimits.size() > _maxRateLimitKeys * 3 / 4 && now - entry.windowStart >= 10 * _rateLimitWindow)
+		{
+			entryIt = _rateLimits.erase(entryIt);
+			continue;
+		}
+		++entryIt;
+	}
+}
+
+u32 Logger::RegisterBinaryLogSite(const BinaryLogSite& site)
+{
+	std::lock_guard lock(_binaryLogSiteMutex);
+	_binaryLogSites.push_back(&site);
+	return static_cast<u32>(_binaryLogSites.size() - 1);
+}
+
+void Logger::PrintBinaryRecord(LogSeverityLevel severityLevel, const u8* record, u64 size)
+{
+	_EnqueueRecord(severityLevel, reinterpret_cast<const char*>(record), size, nullptr, 0, nullptr, _LOG_RECORD_BINARY);
+}
+
+void Logger::_EnqueueRecord(LogSeverityLevel severityLevel, const char* bytes, u64 length, const char* file, u32 line, const char* function, _LogRecordType type)
+{
+	u64 textLength = length;
+	u64 numSlots = 1;
+	if (textLength > _headSlotText)
+	{
+		numSlots += (textLength - _headSlotText + _slotText - 1) / _slotText;
+		if (numSlots > _maxSlotsPerRecord)
+		{
+			numSlots = _maxSlotsPerRecord;
+			textLength = _headSlotText + (_maxSlotsPerRecord - 1) * _slotText;
+		}
+	}
+
+	// Claim numSlots consecutive positions up front, one atomic add even under contention
+	const u64 pos = _writePos.fetch_add(numSlots, std::memory_order_relaxed);
+
+	// The writer frees slots in order, so once the last one is free for this lap they all are
+	const u64 lastPos = pos + numSlots - 1;
+	while (_LoadSequence(lastPos) != lastPos) [[unlikely]]
+	{
+		// Full, drain it ourselves instead of spinning on the writer
+		_ringFullStalls.fetch_add(1, std::memory_order_relaxed);
+		FlushLogging();
+		std::this_thread::yield();
+	}
+
+	// Text continues across the following slots, publish those first so the head slot publishes the whole record
+	const char* pText = bytes + _headSlotText;
+	for (u64 i = 1; i < numSlots; i++)
+	{
+		_LogSlot& slot = _ring[(pos + i) & (_ringCapacity - 1)];
+		const u64 chunk = std::min<u64>(_slotText, textLength - (pText - bytes));
+		memcpy(slot.bytes, pText, chunk);
+		pText += chunk;
+		_StoreSequence(pos + i, pos + i + 1);
+	}
+
+	_LogSlot& headSlot = _ring[pos & (_ringCapacity - 1)];
+	const _LogRecordHeader header = { severityLevel, line, static_cast<u32>(textLength), static_cast<u16>(numSlots), type, file, function };
+	memcpy(headSlot.bytes, &header, sizeof(header));
+	memcpy(headSlot.bytes + sizeof(header), bytes, std::min(textLength, _headSlotText));
+	_StoreSequence(pos, pos + 1);
+
+	// Nothing else is going to drain it after shutdown (Editor logs its final memory report then)
+	if (_bWriterStopped.load(std::memory_order_acquire)) [[unlikely]]
+	{
+		FlushLogging();
+	}
+}
+
+u64 Logger::_LoadSequence(u64 pos)
+{
+	const u64 index = pos & (_ringCapacity - 1);
+	return _ring[index].sequence.load(std::memory_order_acquire) + index;
+}
+
+void Logger::_StoreSequence(u64 pos, u64 sequence)
+{
+	const u64 index = pos & (_ringCapacity - 1);
+	_ring[index].sequence.store(sequence - index, std::memory_order_release);
+}
+
+void Logger::_DrainRing()
+{
+
+	while (true)
+	{
+		_LogSlot& headSlot = _ring[_readPos & (_ringCapacity - 1)];
+		if (_LoadSequence(_readPos) != _readPos + 1) { break; }
+
+		_LogRecordHeader header;
+		memcpy(&header, headSlot.bytes, sizeof(header));
+
+		[[maybe_unused]] const u64 lineStart = _drainBuffer.size();
+		if (header.type == _LOG_RECORD_TEXT)
+		{
+			_drainBuffer.append(_severityStrings[header.severity]);
+		}
+
+		// Gather the text back out of the record's slots and free them for the producers
+		T_string& destination = header.type == _LOG_RECORD_BINARY ? _binaryRecord : _drainBuffer;
+		u64 remaining = header.textLength;
+		for (u64 i = 0; i < header.numSlots; i++)
+		{
+			_LogSlot& slot = _ring[(_readPos + i) & (_ringCapacity - 1)];
+			const char* pChunk = i == 0 ? slot.bytes + sizeof(_LogRecordHeader) : slot.bytes;
+			const u64 chunk = std::min(remaining, i == 0 ? _headSlotText : _slotText);
+			destination.append(pChunk, chunk);
+			remaining -= chunk;
+			_StoreSequence(_readPos + i, _readPos + i + _ringCapacity);
+		}
+		_readPos += header.numSlots;
+
+		if (header.type == _LOG_RECORD_BINARY)
+		{
+			_DrainBinaryRecord(header.severity);
+			continue;
+		}
+
+		if (header.file != nullptr)
+		{
+			_drainBuffer.AppendMany(" >>> Line: ", std::to_string(header.line), " | File: ", header.file, " | Function: ", header.function);
+		}
+
+	#if LAYER_USE_LIVE_LOGGER
+		if (header.type == _LOG_RECORD_TEXT)
+		{
+			_drainedLiveLines.push_back({ lineStart, _drainBuffer.size(), header.severity, false });
+		}
+	#endif
+		_drainBuffer.push_back('\n');
+
+		if (_drainBuffer.size() >= _sessionLogWriteSize)
+		{
+			_WriteDrainBuffer();
+		}
+	}
+
+	_WriteDrainBuffer();
+}
+
+void Logger::_DrainBinaryRecord(LogSeverityLevel severityLevel)
+{
+	u32 siteId;
+	memcpy(&siteId, _binaryRecord.data() + sizeof(u8), sizeof(siteId));
+
+	// New sites since the last record, copy them over so the lock is only taken when a site logs for the first time
+	if (siteId >= _drainedBinaryLogSites.size())
+	{
+		std::lock_guard lock(_binaryLogSiteMutex);
+		_drainedBinaryLogSites.assign(_binaryLogSites.begin(), _binaryLogSites.end());
+	}
+
+	// The decoder needs a site's description before its first message
+	for (; _numBinaryLogSitesWritten < _drainedBinaryLogSites.size(); _numBinaryLogSitesWritten++)
+	{
+		AppendBinaryLogSiteRecord(_binaryDrainBuffer, _numBinaryLogSitesWritten, *_drainedBinaryLogSites[_numBinaryLogSitesWritten]);
+	}
+	_binaryDrainBuffer.append(_binaryRecord);
+
+#if LAYER_USE_LIVE_LOGGER
+	// Still shown live, formatted here on the writer thread instead of by whoever logged it
+	const BinaryLogSite& site = *_drainedBinaryLogSites[siteId];
+	const u8* pRecord = reinterpret_cast<const u8*>(_binaryRecord.data());
+	const u64 lineStart = _liveOnlyText.size();
+	_liveOnlyText.append(_severityStrings[severityLevel]);
+	AppendBinaryLogMessageText(_liveOnlyText, site.format, site.argTypes, site.numArgs, pRecord + binaryLogMessageHeaderSize, pRecord + _binaryRecord.size());
+	_drainedLiveLines.push_back({ lineStart, _liveOnlyText.size(), severityLevel, true });
+#endif
+
+	_binaryRecord.clear();
+
+	if (_binaryDrainBuffer.size() >= _sessionLogWriteSize)
+	{
+		_WriteDrainBuffer();
+	}
+}
+
+void Logger::_WriteDrainBuffer()
+{
+	if (_drainBuffer.empty() && _binaryDrainBuffer.empty()) { return; }
+
+	if (_sessionLogFile.is_open())
+	{
+		if (_sessionLogBytes + _drainBuffer.size() > _maxSessionLogBytes)
+		{
+			_RotateLogFile(_sessionLogFile, sessionLogPath, std::ios::out | std::ios::trunc);
+			_sessionLogBytes = 0;
+		}
+		_sessionLogFile << _drainBuffer;
+		_sessionLogFile.flush();
+		_sessionLogBytes += _drainBuffer.size();
+	}
+	else if (_unwrittenSessionLog.size() < _maxUnwrittenSessionLog)
+	{
+		_unwrittenSessionLog.append(_drainBuffer);
+	}
+
+	if (_binaryLogFile.is_open())
+	{
+		if (_binaryLogBytes + _binaryDrainBuffer.size() > _maxSessionLogBytes)
+		{
+			_RotateLogFile(_binaryLogFile, _binaryLogPath, std::ios::out | std::ios::trunc | std::ios::binary);
+			_WriteBinaryLogHeader();
+		}
+		_binaryLogFile.write(_binaryDrainBuffer.data(), static_cast<std::streamsize>(_binaryDrainBuffer.size()));
+		_binaryLogFile.flush();
+		_binaryLogBytes += _binaryDrainBuffer.size();
+	}
+	else if (_unwrittenBinaryLog.size() < _maxUnwrittenSessionLog)
+	{
+		_unwrittenBinaryLog.append(_binaryDrainBuffer);
+	}
+
+	if (!_drainedLiveLines.empty())
+	{
+		std::lock_guard lock(_liveLogMutex);
+		for (const _DrainedLine& drainedLine : _drainedLiveLines)
+		{
+			const ImVec4& color = _severityColors[drainedLine.severity];
+			const char* pText = (drainedLine.bLiveOnly ? _liveOnlyText : _drainBuffer).c_str() + drainedLine.start;
+			const u64 length = drainedLine.end - drainedLine.start;
+
+			if (_liveLogLineBuffer.size() < _maxLiveLogLines)
+			{
+				_liveLogLineBuffer.emplace_back(color, T_string(pText, length), drainedLine.severity);
+			}
+			else
+			{
+				// Full, overwrite the oldest line in place so its string's capacity gets reused
+				LogLine& oldestLine = _liveLogLineBuffer[_numLiveLogLines % _maxLiveLogLines];
+				_LiveLogLineIndex& oldSeverityIndex = _severityLineIndices[oldestLine.severity];
+				if (oldSeverityIndex.Size() > 0 && oldSeverityIndex[0] == _numLiveLogLines - _maxLiveLogLines)
+				{
+					oldSeverityIndex.DropBefore(_numLiveLogLines - _maxLiveLogLines + 1);
+				}
+
+				oldestLine.color = color;
+				oldestLine.severity = drainedLine.severity;
+				if (length > oldestLine.text.capacity())
+				{
+					// Growing in place would double the capacity, start from an empty string so it's sized to the line
+					oldestLine.text.clear();
+					oldestLine.text.shrink_to_fit();
+				}
+				oldestLine.text.assign(pText, length);
+			}
+
+			_severityLineIndices[drainedLine.severity].Add(_numLiveLogLines);
+			_numLiveLogLines++;
+		}
+	}
+
+	_drainBuffer.clear();
+	_binaryDrainBuffer.clear();
+	_liveOnlyText.clear();
+	_drainedLiveLines.clear();
+}
+
+void Logger::_RotateLogFile(std::ofstream& file, const char* path, std::ios::openmode mode)
+{
+	file.close();
+
+	const auto logPath = [path](u32 index)
+	{
+		const std::filesystem::path logPath(T_string(FileHelper::currentWorkingDirectory, path).c_str());
+		const std::string extension = logPath.extension().string();
+		return index == 0 ? logPath : std::filesystem::path(logPath).replace_extension(T_string(".", std::to_string(index), extension.c_str()).c_str());
+	};
+
+	// Oldest falls off the end, errors are ignored so a locked/missing old log never stops logging
+	std::error_code error;
+	std::filesystem::remove(logPath(_numRotatedSessionLogs), error);
+	for (u32 i = _numRotatedSessionLogs; i > 0; i--)
+	{
+		std::filesystem::rename(logPath(i - 1), logPath(i), error);
+	}
+
+	file.open(logPath(0), mode);
+}
+
+void Logger::_WriteBinaryLogHeader()
+{
+	BinaryLogFileHeader fileHeader = {};
+	memcpy(fileHeader.magic, binaryLogMagic, sizeof(binaryLogMagic));
+	fileHeader.version = binaryLogVersion;
+	fileHeader.startTimestamp = _binaryLogStartTimestamp;
+
+	T_string header(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+	for (u32 siteId = 0; siteId < _numBinaryLogSitesWritten; siteId++)
+	{
+		AppendBinaryLogSiteRecord(header, siteId, *_drainedBinaryLogSites[siteId]);
+	}
+
+	_binaryLogFile.write(header.data(), static_cast<std::streamsize>(header.size()));
+	_binaryLogBytes = header.size();
+}
+
+const Logger::LogLine& Logger::_GetLiveLogLine(u64 line)
+{
+	return _liveLogLineBuffer[line % _maxLiveLogLines];
+}
+
+u64 Logger::_OldestLiveLogLine()
 {
-	PrintLog(severityLevel, message.c_str());
+	return std::max<u64>(_numLiveLogLines - _liveLogLineBuffer.size(), _firstShownLiveLogLine);
+}
+
+void Logger::_UpdateFilteredLines(const ImGuiTextFilter& filter, bool bRebuild)
+{
+	const u64 oldestLine = _OldestLiveLogLine();
+
+	if (bRebuild)
+	{
+		_filteredLines.Clear();
+
+		// Merge the shown severities' indices back into line order, so hiding the noisy severities makes the rebuild cheaper too
+		std::array<u64, LOG_SEVERITY_MAX> cursors = {};
+		for (u32 severity = 0; severity < LOG_SEVERITY_MAX; severity++)
+		{
+			_severityLineIndices[severity].DropBefore(oldestLine);
+		}
+
+		while (true)
+		{
+			u32 nextSeverity = LOG_SEVERITY_MAX;
+			for (u32 severity = 0; severity < LOG_SEVERITY_MAX; severity++)
+			{
+				const _LiveLogLineIndex& index = _severityLineIndices[severity];
+				if (!_shownSeverities[severity] || cursors[severity] == index.Size()) { continue; }
+				if (nextSeverity == LOG_SEVERITY_MAX || index[cursors[severity]] < _severityLineIndices[nextSeverity][cursors[nextSeverity]])
+				{
+					nextSeverity = severity;
+				}
+			}
+			if (nextSeverity == LOG_SEVERITY_MAX) { break; }
+
+			const u64 line = _severityLineIndices[nextSeverity][cursors[nextSeverity]++];
+			if (filter.PassFilter(_GetLiveLogLine(line).text.c_str()))
+			{
+				_filteredLines.Add(line);
+			}
+		}
+	}
+	else
+	{
+		// Only the lines that came in since last frame
+		_filteredLines.DropBefore(oldestLine);
+		for (u64 line = std::max(_numLinesFiltered, oldestLine); line < _numLiveLogLines; line++)
+		{
+			const LogLine& logLine = _GetLiveLogLine(line);
+			if (_shownSeverities[logLine.severity] && filter.PassFilter(logLine.text.c_str()))
+			{
+				_filteredLines.Add(line);
+			}
+		}
+	}
+
+	_numLinesFiltered = _numLiveLogLines;
+}
+
+void Logger::_WriterThreadMain()
+{
+	MEMORY_TAG_SCOPE(MT_ENGINE)
+
+	std::unique_lock wakeLock(_writerWakeMutex);
+	while (!_bStopWriter)
+	{
+		wakeLock.unlock();
+
+		// Keys that stopped repeating still get their summary line
+		if (std::chrono::steady_clock::now() - _lastRateLimitSweep >= _rateLimitWindow)
+		{
+			_SweepRateLimits(false);
+			_lastRateLimitSweep = std::chrono::steady_clock::now();
+		}
+		FlushLogging();
+
+		wakeLock.lock();
+
+		_writerWake.wait_for(wakeLock, _writerInterval, []() { return _bStopWriter; });
+	}
+}
+
+void Logger::_ShowErrorPopup(LogSeverityLevel severityLevel, const char* message, const char* file, u32 line, const char* function)
+{
+    #if LAYER_PLATFORM_WINDOWS
+		T_string popupText(message);
+		if (file != nullptr)
+		{
+			popupText.AppendMany(" >>> Line: ", std::to_string(line), " | File: ", file, " | Function: ", function);
+		}
+        MessageBoxA(nullptr, popupText.c_str(), severityLevel == LOG_SEVERITY_FATAL ? "Fatal Error" : "Error", MB_ICONERROR | MB_OK);
+    #elif LAYER_PLATFORM_LINUX
+        //TODO: Implement Linux version
+    #elif LAYER_PLATFORM_APPLE
+        //TODO: Implement Apple version
+    #endif
 }
 
 
 void Logger::_OpenSessionLogFile()
 {
-	FileHelper::WriteStringToFile(_sessionLogBuffer, _sessionLogPath);
-	FileHelper::OpenFileInExternalProgram(_sessionLogPath);
+	FlushLogging();
+	FileHelper::OpenFileInExternalProgram(sessionLogPath);
 }
 
 void Logger::_DrawLogUI()
@@ -144,47 +900,109 @@ void Logger::_DrawLogUI()
 
 	bool clear = ImGui::Button("Clear");
 	ImGui::SameLine();
-	filter.Draw("Filter", -100.0f);
+	bool bRebuildFilter = filter.Draw("Filter", -100.0f);
 
-	ImGui::Separator();
+	const u64 ringFullStalls = _ringFullStalls.load(std::memory_order_relaxed);
+	if (ringFullStalls > 0)
+	{
+		ImGui::TextDisabled("Log ring filled up %llu times, logging threads had to write it out themselves", ringFullStalls);
+	}
 
-	if (ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar))
+	// Per key counters for rate limited messages, most suppressed first
+	const u64 totalSuppressedLogs = _totalSuppressedLogs.load(std::memory_order_relaxed);
+	if (ImGui::TreeNode("RateLimitedLogs", "Rate Limited Messages: %llu suppressed", totalSuppressedLogs))
 	{
-		if (clear)
-			_liveLogLineBuffer.clear();
+		std::lock_guard lock(_rateLimitMutex);
 
-		ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
-		
-		if (filter.IsActive())
+		T_frame_vector<const _RateLimitEntry*> entries;
+		entries.reserve(_rateLimits.size());
+		for (const auto& [key, entry] : _rateLimits)
 		{
-			for (const LogLine& logLine : _liveLogLineBuffer)
+			entries.push_back(&entry);
+		}
+		std::sort(entries.begin(), entries.end(), [](const _RateLimitEntry* a, const _RateLimitEntry* b) { return a->totalSuppressed > b->totalSuppressed; });
+
+		constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY;
+		if (ImGui::BeginTable("RateLimitTable", 4, flags, ImVec2(0.0f, ImGui::GetTextLineHeightWithSpacing() * 8.0f)))
+		{
+			ImGui::TableSetupScrollFreeze(0, 1);
+			ImGui::TableSetupColumn("Severity", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Printed", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Suppressed", ImGuiTableColumnFlags_WidthFixed);
+			ImGui::TableSetupColumn("Message");
+			ImGui::TableHeadersRow();
+
+			for (const _RateLimitEntry* pEntry : entries)
 			{
-				if (filter.PassFilter(logLine.text.c_str()))
-					ImGui::TextColored(logLine.color, "%s", logLine.text.c_str());
+				ImGui::TableNextRow();
+				ImGui::TableSetColumnIndex(0);
+				ImGui::TextColored(_severityColors[pEntry->severity], "%s", _severityStrings[pEntry->severity]);
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%llu", pEntry->totalPrinted);
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%llu", pEntry->totalSuppressed);
+				ImGui::TableSetColumnIndex(3);
+				ImGui::TextUnformatted(pEntry->message.c_str());
 			}
+			ImGui::EndTable();
 		}
-		else
+		ImGui::TreePop();
+	}
+
+	// Writer thread waits while we draw, it only needs the lock to add lines
+	std::unique_lock liveLogLock(_liveLogMutex);
+
+	if (clear)
+	{
+		_firstShownLiveLogLine = _numLiveLogLines;
+		for (_LiveLogLineIndex& severityIndex : _severityLineIndices)
 		{
-			// Here we instead demonstrate using the clipper to only process lines that are within the visible area.
-			// If you have tens of thousands of items and their processing cost is non-negligible, coarse clipping them
-			// on your side is recommended. Using ImGuiListClipper requires
-			// - A: random access into your data
-			// - B: items all being the  same height,
-			// both of which we can handle since we have an array pointing to the beginning of each line of text.
-			// When using the filter (in the block of code above) we don't have random access into the data to display
-			// anymore, which is why we don't use the clipper. Storing or skimming through the search result would make
-			// it possible (and would be recommended if you want to search through tens of thousands of entries).
-			ImGuiListClipper clipper;
-			clipper.Begin(static_cast<i32>(_liveLogLineBuffer.size()));
-			while (clipper.Step())
+			severityIndex.Clear();
+		}
+		bRebuildFilter = true;
+	}
+
+	// Severity toggles with how many lines of each are in the log
+	for (u32 severity = 0; severity < LOG_SEVERITY_MAX; severity++)
+	{
+		_severityLineIndices[severity].DropBefore(_OldestLiveLogLine());
+
+		char label[64];
+		snprintf(label, sizeof(label), "%s (%llu)###Severity%u", _severityNames[severity], _severityLineIndices[severity].Size(), severity);
+		if (severity > 0) { ImGui::SameLine(); }
+		ImGui::PushStyleColor(ImGuiCol_Text, _severityColors[severity]);
+		bRebuildFilter |= ImGui::Checkbox(label, &_shownSeverities[severity]);
+		ImGui::PopStyleColor();
+	}
+
+	ImGui::Separator();
+
+	if (ImGui::BeginChild("scrolling", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar))
+	{
+		ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
+
+		const bool bShowAllSeverities = std::all_of(_shownSeverities.begin(), _shownSeverities.end(), [](bool bShown) { return bShown; });
+		const bool bFiltered = filter.IsActive() || !bShowAllSeverities;
+		if (bFiltered)
+		{
+			_UpdateFilteredLines(filter, bRebuildFilter);
+		}
+
+		// Lines are the same height, so both views only touch the visible lines. Filtered lines come from the index instead of the ring.
+		const u64 oldestLine = _OldestLiveLogLine();
+		const u64 numShownLines = bFiltered ? _filteredLines.Size() : _numLiveLogLines - oldestLine;
+
+		ImGuiListClipper clipper;
+		clipper.Begin(static_cast<i32>(numShownLines));
+		while (clipper.Step())
+		{
+			for (i32 row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
 			{
-				for (int lineNumber = clipper.DisplayStart; lineNumber < clipper.DisplayEnd; lineNumber++)
-				{
-					ImGui::TextColored(_liveLogLineBuffer[lineNumber].color, "%s",_liveLogLineBuffer[lineNumber].text.c_str());
-				}
+				const LogLine& logLine = _GetLiveLogLine(bFiltered ? _filteredLines[row] : oldestLine + row);
+				ImGui::TextColored(logLine.color, "%s", logLine.text.c_str());
 			}
-			clipper.End();
 		}
+		clipper.End();
 
 		ImGui::PopStyleVar();
 
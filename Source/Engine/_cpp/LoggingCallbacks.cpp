@@ -21,25 +21,37 @@ void LoggingCallbacks::ImguiCheckVkResult(VkResult err)
 namespace ValidationLayers
 {
 	VkDebugUtilsMessengerEXT _VkDebugMessenger = {};
-	T_string _VkMessageBuffer = {};
 }
 
 VKAPI_ATTR VkBool32 VKAPI_CALL ValidationLayers::DebugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, [[maybe_unused]] VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, [[maybe_unused]] void* pUserData)
 {
-	_VkMessageBuffer.clear();
-	_VkMessageBuffer.AppendMany("Validation Layers: ", pCallbackData->pMessage);
+	LogSeverityLevel severityLevel = LOG_SEVERITY_INFO;
 	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
 	{
-		LOG_ERROR_MIN(_VkMessageBuffer.c_str())
+		severityLevel = LOG_SEVERITY_ERROR;
 	}
 	else if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
 	{
-		LOG_WARNING_MIN(_VkMessageBuffer.c_str())
+		severityLevel = LOG_SEVERITY_WARNING;
 	}
+#if !defined(LAYER_USE_VERBOSE_LOGGER)
 	else
 	{
-		LOG_INFO(_VkMessageBuffer.c_str())
+		return VK_FALSE; // LOG_INFO is compiled out
 	}
+#endif
+
+	// The same message can come every draw, rate limit by message id (or text when there's none) before doing any formatting
+	const u64 messageKey = pCallbackData->messageIdNumber != 0
+		? static_cast<u32>(pCallbackData->messageIdNumber) | (static_cast<u64>(messageSeverity) << 32)
+		: std::hash<std::string_view>{}(pCallbackData->pMessage);
+	if (!Logger::PassRateLimit(severityLevel, messageKey)) { return VK_FALSE; }
+
+	// Validation messages can come from any thread recording/submitting
+	thread_local T_string vkMessageBuffer;
+	vkMessageBuffer.clear();
+	vkMessageBuffer.AppendMany("Validation Layers: ", pCallbackData->pMessage);
+	Logger::PrintRateLimitedLog(severityLevel, messageKey, vkMessageBuffer, nullptr, 0, nullptr);
 
 	return VK_FALSE;
 }
@@ -119,8 +131,22 @@ void ValidationLayers::SetupDebugMessenger(VkInstance instance)
 
 namespace MemoryTackingCallbacks
 {
-	// Hash map used for tracking the various allocations VkHostMemory functions use and remembers each allocation size
-	T_unordered_map<void*, size_t, MT_GRAPHICS> _vkHostMemoryAllocationTracker = {};
+	// Bookkeeping stored directly in front of every block we hand to Vulkan, so frees/reallocs don't need a lookup table.
+	struct _VkAllocationHeader
+	{
+		u64 size;		// Size Vulkan asked for
+		u64 alignment;	// Alignment Vulkan asked for, decides how far in front of the block the real allocation starts
+	};
+
+	// Blocks with at most this alignment come straight from malloc/realloc, so realloc can grow them in place.
+	// Anything more aligned goes through LayerMemory::AlignedMalloc with the header padded out to the alignment.
+	constexpr u64 _vkHeaderSize = 16;
+	static_assert(sizeof(_VkAllocationHeader) <= _vkHeaderSize);
+
+	// Offset from the start of the real allocation to the block Vulkan sees
+	inline u64 _GetHeaderOffset(u64 alignment) { return alignment <= _vkHeaderSize ? _vkHeaderSize : alignment; }
+
+	inline _VkAllocationHeader* _GetHeader(void* pMemory) { return reinterpret_cast<_VkAllocationHeader*>(static_cast<u8*>(pMemory) - sizeof(_VkAllocationHeader)); }
 }
 
 // Callback for a VkAllocationCallbacks object
@@ -128,8 +154,12 @@ void* MemoryTackingCallbacks::vkAllocateHostMemory([[maybe_unused]] void* pUserD
 {
 	if (size == 0) { return nullptr; }
 
-	void* ptr = LayerMemory::AlignedMalloc(size, alignment);
-	_vkHostMemoryAllocationTracker.emplace(ptr, size);
+	const u64 headerOffset = _GetHeaderOffset(alignment);
+	void* pBase = alignment <= _vkHeaderSize ? malloc(headerOffset + size) : LayerMemory::AlignedMalloc(headerOffset + size, alignment);
+	if (pBase == nullptr) [[unlikely]] { return nullptr; }
+
+	void* ptr = static_cast<u8*>(pBase) + headerOffset;
+	*_GetHeader(ptr) = { size, alignment };
 	MemoryTracker::AllocatedHostMemory(MT_VULKAN, size);
 
 	// LOG_DEBUG(T_string("Vk Allocating ", std::to_string(size), " bytes!"));
@@ -141,13 +171,20 @@ void MemoryTackingCallbacks::vkFreeHostMemory([[maybe_unused]] void* pUserData,
 {
 	if (pMemory)
 	{
-		const size_t originalSize = _vkHostMemoryAllocationTracker.at(pMemory);
-		MemoryTracker::DeallocatedHostMemory(MT_VULKAN, originalSize);
-		_vkHostMemoryAllocationTracker.erase(pMemory);
+		const _VkAllocationHeader header = *_GetHeader(pMemory);
+		MemoryTracker::DeallocatedHostMemory(MT_VULKAN, header.size);
 
-		// LOG_DEBUG(T_string("Vk Freeing ", std::to_string(originalSize), " bytes!"));
+		// LOG_DEBUG(T_string("Vk Freeing ", std::to_string(header.size), " bytes!"));
 
-		LayerMemory::AlignedFree(pMemory);
+		void* pBase = static_cast<u8*>(pMemory) - _GetHeaderOffset(header.alignment);
+		if (header.alignment <= _vkHeaderSize)
+		{
+			free(pBase);
+		}
+		else
+		{
+			LayerMemory::AlignedFree(pBase);
+		}
 	}
 }
 
@@ -160,8 +197,34 @@ void* MemoryTackingCallbacks::vkReallocateHostMemory(void* pUserData, void* pOri
 		return nullptr;
 	}
 
-	size_t originalSize = _vkHostMemoryAllocationTracker.at(pOriginal);
-	size_t copySize = std::min(originalSize, size);
+	const _VkAllocationHeader originalHeader = *_GetHeader(pOriginal);
+
+	// Malloc backed blocks can be resized by realloc, which grows in place when the heap has room after the block.
+	// Vulkan requires the same alignment as the original allocation, so this only applies if both fit under the header alignment.
+	if (originalHeader.alignment <= _vkHeaderSize && alignment <= _vkHeaderSize)
+	{
+		void* pBase = realloc(static_cast<u8*>(pOriginal) - _vkHeaderSize, _vkHeaderSize + size);
+		if (pBase == nullptr) [[unlikely]] { return nullptr; }
+
+		void* pNewMemory = static_cast<u8*>(pBase) + _vkHeaderSize;
+		*_GetHeader(pNewMemory) = { size, originalHeader.alignment };
+		MemoryTracker::DeallocatedHostMemory(MT_VULKAN, originalHeader.size);
+		MemoryTracker::AllocatedHostMemory(MT_VULKAN, size);
+
+		return pNewMemory;
+	}
+
+	// Over aligned blocks can still shrink in place, the tail just goes unused until the block is freed
+	if (size <= originalHeader.size && alignment <= originalHeader.alignment)
+	{
+		_GetHeader(pOriginal)->size = size;
+		MemoryTracker::DeallocatedHostMemory(MT_VULKAN, originalHeader.size);
+		MemoryTracker::AllocatedHostMemory(MT_VULKAN, size);
+
+		return pOriginal;
+	}
+
+	const size_t copySize = std::min<size_t>(originalHeader.size, size);
 	void* pNewMemory = vkAllocateHostMemory(pUserData, size, alignment, allocationScope);
 	if (pNewMemory != nullptr)
 	{
@@ -0,0 +1,284 @@
+#include "MemoryTimeline.h"
+#include "ImGuiManager.h"
+#include "FileHelper.h"
+#include "HelperTypes.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+
+namespace MemoryTimeline
+{
+	// One tag's counters for a single frame
+	struct _TagSample
+	{
+		u64 bytes = 0;			// Live bytes at the end of the frame
+		u64 highWater = 0;		// Highest end of frame bytes seen this session, up to this frame
+		u32 allocs = 0;			// Allocations made during the frame
+		u32 frees = 0;			// Frees made during the frame
+	};
+
+	struct _FrameSample
+	{
+		u64 frameNumber = 0;
+		u64 timeMicroseconds = 0;	// Since InitializeMemoryTimeline()
+		std::array<_TagSample, MT_MAX_VALUE> tags = {};
+	};
+
+	// Paths relative to the current working directory, next to the session log
+	constexpr const char* _csvPath = "Logs\\MemoryTimeline.csv";
+	constexpr const char* _chromeTracePath = "Logs\\MemoryTimeline.json";
+
+	std::array<_FrameSample, timelineLength> _frames = {};
+	u64 _numCapturedFrames = 0;
+
+	// Running totals from the previous capture, used to turn the tracker's totals into per frame deltas
+	std::array<u64, MT_MAX_VALUE> _prevTotalAllocs = {};
+	std::array<u64, MT_MAX_VALUE> _prevTotalFrees = {};
+	std::array<u64, MT_MAX_VALUE> _highWaterMarks = {};
+
+	// Tag names without the tabs/colons the tracker pads them with
+	std::array<T_string, MT_MAX_VALUE> _tagNames = {};
+
+	std::chrono::steady_clock::time_point _startTime = {};
+
+	// Tag plotted in the Memory window
+	i32 _plottedTag = MT_UNKNOWN;
+
+	// --Internal helpers--
+
+	// Number of frames currently held in the ring
+	u32 _NumFrames();
+
+	// i-th oldest frame still in the ring
+	const _FrameSample& _GetFrame(u32 i);
+
+	// Register function ImGui manager uses to draw the timeline in the Memory window
+	void _DrawMemoryTimelineUI();
+}
+
+void MemoryTimeline::InitializeMemoryTimeline()
+{
+	_startTime = std::chrono::steady_clock::now();
+
+	for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+	{
+		const MemoryUsageInfo usageInfo = MemoryTracker::GetHostMemoryUsage(static_cast<MemoryTrackerTag>(tag));
+		_prevTotalAllocs[tag] = usageInfo.allocations + usageInfo.frees;
+		_prevTotalFrees[tag] = usageInfo.frees;
+		_highWaterMarks[tag] = usageInfo.size;
+
+		_tagNames[tag] = usageInfo.tagName;
+		std::erase_if(_tagNames[tag], [](char c) { return c == ':' || c == '\t'; });
+	}
+
+	REGISTER_EDITOR_UI_WINDOW(nullptr, MemoryTimeline::_DrawMemoryTimelineUI)
+}
+
+void MemoryTimeline::ShutdownMemoryTimeline()
+{
+	if (_numCapturedFrames == 0) { return; }
+
+	ExportCSV(_csvPath);
+	ExportChromeTrace(_chromeTracePath);
+}
+
+void MemoryTimeline::CaptureFrame()
+{
+#ifdef LAYER_USE_MEMORY_TRACKING
+	PROFILE_ZONE("MemoryTimeline::CaptureFrame")
+	_FrameSample& frame = _frames[_numCapturedFrames % timelineLength];
+	frame.frameNumber = _numCapturedFrames;
+	frame.timeMicroseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _startTime).count();
+
+	for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+	{
+		const MemoryUsageInfo usageInfo = MemoryTracker::GetHostMemoryUsage(static_cast<MemoryTrackerTag>(tag));
+		const u64 totalAllocs = usageInfo.allocations + usageInfo.frees;
+
+		_TagSample& sample = frame.tags[tag];
+		sample.bytes = usageInfo.size;
+		sample.allocs = static_cast<u32>(totalAllocs - _prevTotalAllocs[tag]);
+		sample.frees = static_cast<u32>(usageInfo.frees - _prevTotalFrees[tag]);
+
+		_highWaterMarks[tag] = std::max(_highWaterMarks[tag], usageInfo.size);
+		sample.highWater = _highWaterMarks[tag];
+
+		_prevTotalAllocs[tag] = totalAllocs;
+		_prevTotalFrees[tag] = usageInfo.frees;
+	}
+
+	_numCapturedFrames++;
+#endif
+}
+
+void MemoryTimeline::ExportCSV(const char* filePath)
+{
+	T_string csv("frame,time_ms,tag,bytes,allocs,frees,high_water_bytes\n");
+
+	for (u32 i = 0; i < _NumFrames(); i++)
+	{
+		const _FrameSample& frame = _GetFrame(i);
+		const T_string frameColumns(std::to_string(frame.frameNumber), ",", std::to_string(static_cast<f64>(frame.timeMicroseconds) / 1000.0), ",");
+
+		for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+		{
+			const _TagSample& sample = frame.tags[tag];
+			if (sample.highWater == 0 && sample.allocs == 0 && sample.frees == 0) { continue; } // Tag never used
+
+			csv.AppendMany(frameColumns, _tagNames[tag], ",", std::to_string(sample.bytes), ",", std::to_string(sample.allocs), ",",
+				std::to_string(sample.frees), ",", std::to_string(sample.highWater), "\n");
+		}
+	}
+
+	FileHelper::WriteStringToFile(csv, filePath);
+}
+
+void MemoryTimeline::ExportChromeTrace(const char* filePath)
+{
+	T_string trace("{\"traceEvents\":[\n");
+	bool bFirstEvent = true;
+
+	for (u32 i = 0; i < _NumFrames(); i++)
+	{
+		const _FrameSample& frame = _GetFrame(i);
+		const T_string timestamp = std::to_string(frame.timeMicroseconds);
+
+		for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+		{
+			const _TagSample& sample = frame.tags[tag];
+			if (sample.highWater == 0 && sample.allocs == 0 && sample.frees == 0) { continue; } // Tag never used
+
+			// One counter track for live bytes and one for churn per tag
+			trace.AppendMany(bFirstEvent ? "" : ",\n",
+				"{\"name\":\"Host Bytes: ", _tagNames[tag], "\",\"ph\":\"C\",\"ts\":", timestamp, ",\"pid\":0,\"tid\":0,\"args\":{\"bytes\":", std::to_string(sample.bytes), "}},\n",
+				"{\"name\":\"Host Churn: ", _tagNames[tag], "\",\"ph\":\"C\",\"ts\":", timestamp, ",\"pid\":0,\"tid\":0,\"args\":{\"allocs\":", std::to_string(sample.allocs),
+				",\"frees\":", std::to_string(sample.frees), "}}");
+			bFirstEvent = false;
+		}
+	}
+
+	trace.append("\n]}\n");
+	FileHelper::WriteStringToFile(trace, filePath);
+}
+
+u32 MemoryTimeline::_NumFrames()
+{
+	return static_cast<u32>(std::min<u64>(_numCapturedFrames, timelineLength));
+}
+
+const MemoryTimeline::_FrameSample& MemoryTimeline::_GetFrame(u32 i)
+{
+	const u64 oldestFrame = _numCapturedFrames - _NumFrames();
+	return _frames[(oldestFrame + i) % timelineLength];
+}
+
+void MemoryTimeline::_DrawMemoryTimelineUI()
+{
+	ImGui::Begin("Memory");
+
+	ImGui::SeparatorText("Memory Timeline");
+
+#ifndef LAYER_USE_MEMORY_TRACKING
+	ImGui::TextDisabled("Host memory tracking is compiled out (LAYER_MEMORY_TRACKING=OFF)");
+	ImGui::End();
+	return;
+#endif
+
+	const u32 numFrames = _NumFrames();
+	if (numFrames == 0)
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (ImGui::BeginCombo("Tag", _tagNames[_plottedTag].c_str()))
+	{
+		for (i32 tag = 0; tag < MT_MAX_VALUE; tag++)
+		{
+			if (ImGui::Selectable(_tagNames[tag].c_str(), tag == _plottedTag))
+			{
+				_plottedTag = tag;
+			}
+		}
+		ImGui::EndCombo();
+	}
+
+	// Plot the selected tag, oldest frame on the left
+	const auto bytesGetter = [](void* pTag, i32 i) { return static_cast<f32>(_GetFrame(i).tags[*static_cast<i32*>(pTag)].bytes) / static_cast<f32>(MiB); };
+	const auto allocsGetter = [](void* pTag, i32 i) { return static_cast<f32>(_GetFrame(i).tags[*static_cast<i32*>(pTag)].allocs); };
+
+	const _TagSample& latest = _GetFrame(numFrames - 1).tags[_plottedTag];
+	const T_string bytesOverlay(std::to_string(static_cast<f32>(latest.bytes) / static_cast<f32>(MiB)), " MiB");
+	const T_string allocsOverlay(std::to_string(latest.allocs), " allocs");
+	ImGui::PlotLines("Bytes (MiB)", bytesGetter, &_plottedTag, static_cast<i32>(numFrames), 0, bytesOverlay.c_str(), 0.0f, F32_MAX, ImVec2(0.0f, 60.0f));
+	ImGui::PlotHistogram("Allocs/Frame", allocsGetter, &_plottedTag, static_cast<i32>(numFrames), 0, allocsOverlay.c_str(), 0.0f, F32_MAX, ImVec2(0.0f, 60.0f));
+
+	// Churn report over the frames in the ring, busiest tag first
+	struct ChurnRow
+	{
+		u32 tag = 0;
+		f32 avgAllocs = 0.0f;
+		f32 avgFrees = 0.0f;
+		u32 peakAllocs = 0;
+		u64 highWater = 0;
+	};
+	std::array<ChurnRow, MT_MAX_VALUE> churnRows = {};
+
+	for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+	{
+		ChurnRow& row = churnRows[tag];
+		row.tag = tag;
+		for (u32 i = 0; i < numFrames; i++)
+		{
+			const _TagSample& sample = _GetFrame(i).tags[tag];
+			row.avgAllocs += static_cast<f32>(sample.allocs);
+			row.avgFrees += static_cast<f32>(sample.frees);
+			row.peakAllocs = std::max(row.peakAllocs, sample.allocs);
+		}
+		row.avgAllocs /= static_cast<f32>(numFrames);
+		row.avgFrees /= static_cast<f32>(numFrames);
+		row.highWater = _highWaterMarks[tag];
+	}
+	std::sort(churnRows.begin(), churnRows.end(), [](const ChurnRow& a, const ChurnRow& b) { return a.avgAllocs > b.avgAllocs; });
+
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+	if (ImGui::BeginTable("MemoryChurnTable", 5, flags))
+	{
+		ImGui::TableSetupColumn("Memory Type");
+		ImGui::TableSetupColumn("Allocs/Frame");
+		ImGui::TableSetupColumn("Frees/Frame");
+		ImGui::TableSetupColumn("Peak Allocs/Frame");
+		ImGui::TableSetupColumn("High-Water");
+		ImGui::TableHeadersRow();
+
+		MemoryUsageInfo highWaterInfo = {};
+		for (const ChurnRow& row : churnRows)
+		{
+			if (row.highWater == 0 && row.peakAllocs == 0) { continue; } // Tag never used
+
+			highWaterInfo.size = row.highWater;
+			highWaterInfo.SetDisplayLabel();
+
+			ImGui::TableNextRow();
+			// Tag Name
+			ImGui::TableSetColumnIndex(0);
+			ImGui::TextUnformatted(_tagNames[row.tag].c_str());
+			// Average allocations per frame
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%.1f", row.avgAllocs);
+			// Average frees per frame
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.1f", row.avgFrees);
+			// Worst frame
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%u", row.peakAllocs);
+			// Session high-water mark
+			ImGui::TableSetColumnIndex(4);
+			ImGui::Text("%.3f%s", highWaterInfo.displaySize, highWaterInfo.sizeLabel);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
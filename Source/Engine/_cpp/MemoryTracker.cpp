@@ -1,50 +1,152 @@
 #include "MemoryTracker.h"
+#include "AllocationSampler.h"
+#include "LayerMemory.h"
 #include "HelperTypes.h"
 #include "ImGuiManager.h"
 #include "Logger.h"
 
 
+#ifdef LAYER_USE_MEMORY_TRACKING
+namespace MemoryTracker
+{
+	// Header placed in front of every block handed out by the global new overloads
+	struct _NewAllocationHeader
+	{
+		u64 size;				// Size the caller asked for
+		MemoryTrackerTag tag;	// Tag the block was charged to
+		u32 alignment;			// 0 for default aligned blocks from the Layer heap, else the over-alignment LayerMemory::AlignedMalloc was given
+	};
+
+	// Keeps blocks at the default new alignment (16 bytes on 64-bit platforms)
+	constexpr u64 _newHeaderSize = 16;
+	static_assert(sizeof(_NewAllocationHeader) <= _newHeaderSize);
+
+	// Allocates the block + header and charges it to the calling thread's current tag
+	void* _TrackedNew(size_t size, size_t alignment);
+
+	// Credits the block back to the tag it was allocated under and frees it
+	void _TrackedDelete(void* memory);
+}
+
 // -----NEW/DELETE OVERLOADS------
 void* __CRTDECL operator new(size_t size)
 {
-	// Capture third party/miscellaneous allocations, and add them to MT_UNKNOWN
-	MemoryTracker::AllocatedHostMemory(MT_UNKNOWN, size);
-	return malloc(size);
+	// Capture third party/miscellaneous allocations, and add them to the current thread's tag
+	return MemoryTracker::_TrackedNew(size, 0);
 }
 
 void* __CRTDECL operator new[](size_t size)
 {
-	// Capture third party/miscellaneous allocations, and add them to MT_UNKNOWN
-	MemoryTracker::AllocatedHostMemory(MT_UNKNOWN, size);
-	return malloc(size);
+	// Capture third party/miscellaneous allocations, and add them to the current thread's tag
+	return MemoryTracker::_TrackedNew(size, 0);
 }
 
-void __CRTDECL operator delete(void* memory, size_t size) noexcept
+void* __CRTDECL operator new(size_t size, std::align_val_t alignment)
 {
-	// Capture third party/miscellaneous frees, and subtract them from MT_UNKNOWN
-	MemoryTracker::DeallocatedHostMemory(MT_UNKNOWN, size);
-	free(memory);
+	// Capture over-aligned allocations, and add them to the current thread's tag
+	return MemoryTracker::_TrackedNew(size, static_cast<size_t>(alignment));
 }
 
-void __CRTDECL operator delete[](void* memory, size_t size) noexcept
+void* __CRTDECL operator new[](size_t size, std::align_val_t alignment)
 {
-	// Capture third party/miscellaneous frees, and subtract them from MT_UNKNOWN
-	MemoryTracker::DeallocatedHostMemory(MT_UNKNOWN, size);
-	free(memory);
+	// Capture over-aligned allocations, and add them to the current thread's tag
+	return MemoryTracker::_TrackedNew(size, static_cast<size_t>(alignment));
 }
 
+void __CRTDECL operator delete(void* memory) noexcept
+{
+	// Capture third party/miscellaneous frees, and subtract them from the tag they were allocated under
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete[](void* memory) noexcept
+{
+	// Capture third party/miscellaneous frees, and subtract them from the tag they were allocated under
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete(void* memory, [[maybe_unused]] size_t size) noexcept
+{
+	// Capture third party/miscellaneous frees, and subtract them from the tag they were allocated under
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete[](void* memory, [[maybe_unused]] size_t size) noexcept
+{
+	// Capture third party/miscellaneous frees, and subtract them from the tag they were allocated under
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete(void* memory, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete[](void* memory, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete(void* memory, [[maybe_unused]] size_t size, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+	MemoryTracker::_TrackedDelete(memory);
+}
+
+void __CRTDECL operator delete[](void* memory, [[maybe_unused]] size_t size, [[maybe_unused]] std::align_val_t alignment) noexcept
+{
+	MemoryTracker::_TrackedDelete(memory);
+}
+#endif
+
 
 
 namespace MemoryTracker
 {
-	// Array to keep track of every host memory allocation
+#ifdef LAYER_USE_MEMORY_TRACKING
+	// Number of counter shards threads get spread across. Threads past this count share shards, which is still correct since every counter is atomic.
+	constexpr u32 _hostMemoryShardCount = 16;
+
+	// One cache line aligned block of counters per shard, so threads bumping their own shard never false share with each other.
+	// Counters are unsigned and allowed to wrap, a free on a different thread than its allocation just makes a shard "negative" until summed.
+	struct alignas(64) _HostMemoryShard
+	{
+		std::array<std::atomic<u64>, MT_MAX_VALUE> size = {};
+		std::array<std::atomic<u64>, MT_MAX_VALUE> allocations = {};
+		std::array<std::atomic<u64>, MT_MAX_VALUE> frees = {};
+	};
+
+	// Per thread group counters every host allocation/free gets added to. Zero initialized before any operator new can run.
+	std::array<_HostMemoryShard, _hostMemoryShardCount> _hostMemoryShards = {};
+
+	// Round robin counter used to hand out a shard to each new thread
+	std::atomic<u32> _nextHostMemoryShard = 0;
+
+	// Shard the calling thread writes to, U32_MAX until the thread's first allocation
+	constinit thread_local u32 _threadHostMemoryShard = U32_MAX;
+#endif
+
+	// Aggregated snapshot of every tag, only updated when the UI or log reads it.
 	std::array<MemoryUsageInfo, MT_MAX_VALUE> _hostMemoryUsage;
 
 	// --Internal helpers--
 
+#ifdef LAYER_USE_MEMORY_TRACKING
+	// Returns the calling thread's counter shard, assigning one on first use
+	_HostMemoryShard& _GetThreadShard();
+#endif
+
+	// Sums every shard into _hostMemoryUsage and updates the display labels
+	void _GatherHostMemoryUsage();
+
 	// Register function ImGui manager uses to draw CPU host memory tracker UI
 	void _DrawMemoryTrackerUI();
 
+	// Register function ImGui manager uses to draw the Layer heap's pool usage and fragmentation
+	void _DrawLayerHeapUI();
+
+	// Byte count as a 3 decimal "<size><label>" string
+	T_string _FormatBytes(u64 bytes);
+
 	// Returns CPU host usage tag name for given MemoryTrackerTags index 
 	const char* _GetMemoryTrackerTagName(u32 tag);
 }
@@ -61,24 +163,56 @@ void MemoryTracker::InitializeMemoryTracker()
 	}
 
 	REGISTER_EDITOR_UI_WINDOW(nullptr, MemoryTracker::_DrawMemoryTrackerUI)
+	REGISTER_EDITOR_UI_WINDOW(nullptr, MemoryTracker::_DrawLayerHeapUI)
 }
 
+#ifdef LAYER_USE_MEMORY_TRACKING
 void MemoryTracker::AllocatedHostMemory(MemoryTrackerTag tag, u64 sizeOfAlloc)
 {
-	_hostMemoryUsage[tag].size += sizeOfAlloc;
-	_hostMemoryUsage[tag].allocations += 1;
-	_hostMemoryUsage[tag].SetDisplayLabel();
+	_HostMemoryShard& shard = _GetThreadShard();
+	shard.size[tag].fetch_add(sizeOfAlloc, std::memory_order_relaxed);
+	shard.allocations[tag].fetch_add(1, std::memory_order_relaxed);
+
+	AllocationSampler::SampleAllocation(tag, sizeOfAlloc);
 }
 
 void MemoryTracker::DeallocatedHostMemory(MemoryTrackerTag tag, u64 sizeOfAlloc)
 {
-	_hostMemoryUsage[tag].size -= sizeOfAlloc;
-	_hostMemoryUsage[tag].allocations -= 1;
-	_hostMemoryUsage[tag].SetDisplayLabel();
+	_HostMemoryShard& shard = _GetThreadShard();
+	shard.size[tag].fetch_sub(sizeOfAlloc, std::memory_order_relaxed);
+	shard.allocations[tag].fetch_sub(1, std::memory_order_relaxed);
+	shard.frees[tag].fetch_add(1, std::memory_order_relaxed);
+}
+#endif
+
+MemoryUsageInfo MemoryTracker::GetHostMemoryUsage(MemoryTrackerTag tag)
+{
+	MemoryUsageInfo usageInfo = {};
+	if (tag >= MT_MAX_VALUE) [[unlikely]] { return usageInfo; }
+
+	usageInfo.tagName = _GetMemoryTrackerTagName(tag);
+#ifdef LAYER_USE_MEMORY_TRACKING
+	for (const _HostMemoryShard& shard : _hostMemoryShards)
+	{
+		usageInfo.size += shard.size[tag].load(std::memory_order_relaxed);
+		usageInfo.allocations += shard.allocations[tag].load(std::memory_order_relaxed);
+		usageInfo.frees += shard.frees[tag].load(std::memory_order_relaxed);
+	}
+#endif
+	usageInfo.SetDisplayLabel();
+
+	return usageInfo;
 }
 
 void MemoryTracker::LogMemoryUsage()
 {
+#ifndef LAYER_USE_MEMORY_TRACKING
+	Logger::AddToSessionLogFile("------- HOST MEMORY USAGE: Tracking compiled out (LAYER_MEMORY_TRACKING=OFF) -------");
+	return;
+#endif
+
+	_GatherHostMemoryUsage();
+
 	Logger::AddToSessionLogFile("------- HOST MEMORY USAGE (Allocation # | Size) -------");
 	for (u64 i = 0; i < MT_MAX_VALUE; i++)
 	{
@@ -86,14 +220,96 @@ void MemoryTracker::LogMemoryUsage()
 				std::to_string(_hostMemoryUsage[i].allocations), " Allocations | ", 
 				std::to_string(_hostMemoryUsage[i].displaySize), _hostMemoryUsage[i].sizeLabel));
 	}
+
+#ifdef LAYER_USE_CUSTOM_HEAP
+	const LayerMemory::HeapStats heapStats = LayerMemory::GetHeapStats();
+	Logger::AddToSessionLogFile(T_string("LAYER HEAP:\t", std::to_string(heapStats.numPools), " Pools | Reserved ", _FormatBytes(heapStats.reservedBytes),
+		" | Used ", _FormatBytes(heapStats.usedBytes), " | Free ", _FormatBytes(heapStats.freeBytes), " | Largest Free ", _FormatBytes(heapStats.largestFreeBlock),
+		" | Fragmentation ", std::to_string(heapStats.fragmentation * 100.0f), "% | Large Blocks ", std::to_string(heapStats.numLargeBlocks), " (", _FormatBytes(heapStats.largeBlockBytes), ")"));
+#endif
+}
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+MemoryTracker::_HostMemoryShard& MemoryTracker::_GetThreadShard()
+{
+	if (_threadHostMemoryShard == U32_MAX) [[unlikely]]
+	{
+		_threadHostMemoryShard = _nextHostMemoryShard.fetch_add(1, std::memory_order_relaxed) % _hostMemoryShardCount;
+	}
+
+	return _hostMemoryShards[_threadHostMemoryShard];
+}
+
+void* MemoryTracker::_TrackedNew(size_t size, size_t alignment)
+{
+	// Single TLS read, the only cost the tag scope adds to the hot path
+	const MemoryTrackerTag tag = currentThreadTag;
+
+	u8* pBase;
+	u64 headerOffset;
+	if (alignment <= _newHeaderSize)
+	{
+		alignment = 0;
+		headerOffset = _newHeaderSize;
+		pBase = static_cast<u8*>(LayerMemory::Allocate(headerOffset + size));
+	}
+	else
+	{
+		headerOffset = alignment;
+		pBase = static_cast<u8*>(LayerMemory::AlignedMalloc(headerOffset + size, alignment));
+	}
+
+	if (pBase == nullptr) [[unlikely]] { throw std::bad_alloc(); }
+
+	u8* pMemory = pBase + headerOffset;
+	*reinterpret_cast<_NewAllocationHeader*>(pMemory - _newHeaderSize) = { size, tag, static_cast<u32>(alignment) };
+	AllocatedHostMemory(tag, size);
+
+	return pMemory;
+}
+
+void MemoryTracker::_TrackedDelete(void* memory)
+{
+	if (memory == nullptr) { return; }
+
+	u8* pMemory = static_cast<u8*>(memory);
+	const _NewAllocationHeader header = *reinterpret_cast<_NewAllocationHeader*>(pMemory - _newHeaderSize);
+	DeallocatedHostMemory(header.tag, header.size);
+
+	if (header.alignment == 0)
+	{
+		LayerMemory::Free(pMemory - _newHeaderSize);
+	}
+	else
+	{
+		LayerMemory::AlignedFree(pMemory - header.alignment);
+	}
+}
+#endif
+
+void MemoryTracker::_GatherHostMemoryUsage()
+{
+	for (u32 i = 0; i < MT_MAX_VALUE; i++)
+	{
+		_hostMemoryUsage[i] = GetHostMemoryUsage(static_cast<MemoryTrackerTag>(i));
+	}
 }
 
 void MemoryTracker::_DrawMemoryTrackerUI()
 {
+	_GatherHostMemoryUsage();
+
 	ImGui::Begin("Memory");
 
 	ImGui::SeparatorText("Host Memory Usage");
 
+#ifndef LAYER_USE_MEMORY_TRACKING
+	// Nothing to show, keep the section so other Memory window sections still line up
+	ImGui::TextDisabled("Host memory tracking is compiled out (LAYER_MEMORY_TRACKING=OFF)");
+	ImGui::End();
+	return;
+#endif
+
 	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
 
 	if (ImGui::BeginTable("HostMemoryUsageTable", 3, flags))
@@ -124,6 +340,58 @@ void MemoryTracker::_DrawMemoryTrackerUI()
 	ImGui::End();
 }
 
+void MemoryTracker::_DrawLayerHeapUI()
+{
+	ImGui::Begin("Memory");
+
+	ImGui::SeparatorText("Layer Heap");
+
+#ifndef LAYER_USE_CUSTOM_HEAP
+	ImGui::TextDisabled("Layer heap is compiled out (LAYER_CUSTOM_HEAP=OFF), allocations go straight to malloc");
+	ImGui::End();
+	return;
+#endif
+
+	const LayerMemory::HeapStats heapStats = LayerMemory::GetHeapStats();
+
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+	if (ImGui::BeginTable("LayerHeapTable", 2, flags))
+	{
+		const auto row = [](const char* label, const T_string& value)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::TextUnformatted(label);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::TextUnformatted(value.c_str());
+		};
+
+		row("Pools", T_string(std::to_string(heapStats.numPools), " (", _FormatBytes(heapStats.reservedBytes), " reserved)"));
+		row("Used", _FormatBytes(heapStats.usedBytes));
+		row("Free", T_string(_FormatBytes(heapStats.freeBytes), " in ", std::to_string(heapStats.numFreeBlocks), " blocks"));
+		row("Largest Free Block", _FormatBytes(heapStats.largestFreeBlock));
+		row("Fragmentation", T_string(std::to_string(heapStats.fragmentation * 100.0f), "%"));
+		row("Large Blocks", T_string(std::to_string(heapStats.numLargeBlocks), " (", _FormatBytes(heapStats.largeBlockBytes), ")"));
+		row("Thread Cache Refills/Releases", T_string(std::to_string(heapStats.cacheRefills), " / ", std::to_string(heapStats.cacheReleases)));
+
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+T_string MemoryTracker::_FormatBytes(u64 bytes)
+{
+	MemoryUsageInfo usageInfo = {};
+	usageInfo.size = bytes;
+	usageInfo.SetDisplayLabel();
+
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%.3f%s", usageInfo.displaySize, usageInfo.sizeLabel);
+	return buffer;
+}
+
 const char* MemoryTracker::_GetMemoryTrackerTagName(u32 tag)
 {
 	switch (tag)
@@ -0,0 +1,233 @@
+#include "OffscreenTarget.h"
+#include "VkTypes.h"
+#include "VkBuffersAndImages.h"
+#include "Logger.h"
+#include "Profiler.h"
+
+
+void OffscreenTarget::CreateOffscreenTarget(const VkRef& vkRef, VkExtent2D extent)
+{
+	LOG_DEBUG("Creating Vulkan Offscreen Target...")
+
+	m_Format = vkRef.phyDevice.preferred32BitPackColorAttachmentFormat;
+	m_Extent = extent;
+
+	// Single color attachment, cleared on load and left ready to be copied out
+	VkAttachmentDescription colorAttachment = {};
+	colorAttachment.format = m_Format;
+	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;	// What PRESENT_SRC would be with a swap chain
+
+	VkAttachmentReference colorAttachmentReference = {};
+	colorAttachmentReference.attachment = 0;
+	colorAttachmentReference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass = {};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 1;
+	subpass.pColorAttachments = &colorAttachmentReference;
+
+	// Previous use of the image (a readback copy) must finish before it gets cleared, and the writes must land before the next copy reads them
+	std::array<VkSubpassDependency, 2> dependencies = {};
+	dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[0].dstSubpass = 0;
+	dependencies[0].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[0].srcAccessMask = 0;
+	dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	dependencies[1].srcSubpass = 0;
+	dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassCreateInfo = {};
+	renderPassCreateInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassCreateInfo.attachmentCount = 1;
+	renderPassCreateInfo.pAttachments = &colorAttachment;
+	renderPassCreateInfo.subpassCount = 1;
+	renderPassCreateInfo.pSubpasses = &subpass;
+	renderPassCreateInfo.dependencyCount = static_cast<u32>(dependencies.size());
+	renderPassCreateInfo.pDependencies = dependencies.data();
+
+	LOG_VKRESULT(vkCreateRenderPass(vkRef.logDevice, &renderPassCreateInfo, &vkRef.hostAllocator, &m_RenderPass))
+
+	// One image + framebuffer per frame in flight
+	m_Images.resize(vkRef.numInFlightFrames);
+	m_FrameBuffers.resize(vkRef.numInFlightFrames);
+
+	for (size_t i = 0; i < m_Images.size(); i++)
+	{
+		m_Images[i] = VkImageHelpers::Create2DImage(
+			vkRef,
+			m_Extent,
+			m_Format,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			GPU_USAGE_ATTACHMENT_IMAGE
+		);
+
+		VkFramebufferCreateInfo framebufferCreateInfo = {};
+		framebufferCreateInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferCreateInfo.renderPass = m_RenderPass;
+		framebufferCreateInfo.attachmentCount = 1;
+		framebufferCreateInfo.pAttachments = &m_Images[i].imageView;
+		framebufferCreateInfo.width = m_Extent.width;
+		framebufferCreateInfo.height = m_Extent.height;
+		framebufferCreateInfo.layers = 1;
+
+		LOG_VKRESULT(vkCreateFramebuffer(vkRef.logDevice, &framebufferCreateInfo, &vkRef.hostAllocator, &m_FrameBuffers[i]))
+	}
+
+	LOG_INFO(T_string("Created Vulkan Offscreen Target | ", std::to_string(m_Extent.width), "x", std::to_string(m_Extent.height),
+		" | Images: ", std::to_string(m_Images.size())))
+}
+
+void OffscreenTarget::DestroyOffscreenTarget(const VkRef& vkRef)
+{
+	if (m_ReadbackBuffer != VK_NULL_HANDLE)
+	{
+		vkDestroyFence(vkRef.logDevice, m_ReadbackFence, &vkRef.hostAllocator);
+		vkFreeCommandBuffers(vkRef.logDevice, vkRef.graphicsCommandPool, 1, &m_ReadbackCmdBuffer);
+
+		// Report to GpuMemoryTracker for accurate GPU memory usage
+		VmaAllocationInfo allocationInfo = {};
+		vmaGetAllocationInfo(vkRef.vmaAllocator, m_ReadbackAllocation, &allocationInfo);
+		GpuMemoryTracker::DeallocatedGpuMemory(GPU_USAGE_READBACK_BUFFER, allocationInfo.size);
+
+		vmaDestroyBuffer(vkRef.vmaAllocator, m_ReadbackBuffer, m_ReadbackAllocation);
+		m_ReadbackBuffer = VK_NULL_HANDLE;
+		m_pReadbackData = nullptr;
+	}
+
+	for (VkFramebuffer frameBuffer : m_FrameBuffers)
+		vkDestroyFramebuffer(vkRef.logDevice, frameBuffer, &vkRef.hostAllocator);
+	m_FrameBuffers.clear();
+
+	for (GpuImage& image : m_Images)
+		VkImageHelpers::DestroyImage(vkRef, image);
+	m_Images.clear();
+
+	vkDestroyRenderPass(vkRef.logDevice, m_RenderPass, &vkRef.hostAllocator);
+	m_RenderPass = VK_NULL_HANDLE;
+}
+
+void OffscreenTarget::BeginRenderPass(VkCommandBuffer cmdBuffer, u32 imageIndex, VkSubpassContents contents) const
+{
+	VkClearValue clearValue = {};
+	clearValue.color = m_ClearColor;
+
+	VkRenderPassBeginInfo renderPassBeginInfo = {};
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.renderPass = m_RenderPass;
+	renderPassBeginInfo.framebuffer = m_FrameBuffers[imageIndex];
+	renderPassBeginInfo.renderArea.extent = m_Extent;
+	renderPassBeginInfo.clearValueCount = 1;
+	renderPassBeginInfo.pClearValues = &clearValue;
+	vkCmdBeginRenderPass(cmdBuffer, &renderPassBeginInfo, contents);
+}
+
+void OffscreenTarget::EndRenderPass(VkCommandBuffer cmdBuffer) const
+{
+	vkCmdEndRenderPass(cmdBuffer);
+}
+
+void OffscreenTarget::ReadbackImage(const VkRef& vkRef, u32 imageIndex, T_vector<u8, MT_GRAPHICS>& outPixels)
+{
+	PROFILE_ZONE("OffscreenTarget::ReadbackImage")
+
+	if (m_ReadbackBuffer == VK_NULL_HANDLE)
+	{
+		CreateReadbackBuffer(vkRef);
+	}
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	LOG_VKRESULT(vkBeginCommandBuffer(m_ReadbackCmdBuffer, &beginInfo))
+
+	// Tightly packed copy of the whole image, the render pass already left it in TRANSFER_SRC layout
+	VkBufferImageCopy region = {};
+	region.bufferOffset = 0;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { m_Extent.width, m_Extent.height, 1 };
+	vkCmdCopyImageToBuffer(m_ReadbackCmdBuffer, m_Images[imageIndex].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ReadbackBuffer, 1, &region);
+
+	// Make the copy visible to the host
+	VkBufferMemoryBarrier bufferBarrier = {};
+	bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	bufferBarrier.buffer = m_ReadbackBuffer;
+	bufferBarrier.offset = 0;
+	bufferBarrier.size = VK_WHOLE_SIZE;
+	vkCmdPipelineBarrier(m_ReadbackCmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &bufferBarrier, 0, nullptr);
+
+	LOG_VKRESULT(vkEndCommandBuffer(m_ReadbackCmdBuffer))
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &m_ReadbackCmdBuffer;
+
+	LOG_VKRESULT(vkResetFences(vkRef.logDevice, 1, &m_ReadbackFence))
+	LOG_VKRESULT(vkQueueSubmit(vkRef.queues.graphics, 1, &submitInfo, m_ReadbackFence))
+	{
+		PROFILE_WAIT_ZONE("Wait For Readback")
+		LOG_VKRESULT(vkWaitForFences(vkRef.logDevice, 1, &m_ReadbackFence, VK_TRUE, U64_MAX))
+	}
+
+	// No-op on host coherent memory, which is what most drivers hand out for readback
+	const u64 sizeInBytes = static_cast<u64>(m_Extent.width) * m_Extent.height * bytesPerPixel;
+	LOG_VKRESULT(vmaInvalidateAllocation(vkRef.vmaAllocator, m_ReadbackAllocation, 0, sizeInBytes))
+
+	outPixels.resize(sizeInBytes);
+	memcpy(outPixels.data(), m_pReadbackData, sizeInBytes);
+}
+
+void OffscreenTarget::CreateReadbackBuffer(const VkRef& vkRef)
+{
+	VkBufferCreateInfo bufferCreateInfo = {};
+	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferCreateInfo.size = static_cast<VkDeviceSize>(m_Extent.width) * m_Extent.height * bytesPerPixel;
+	bufferCreateInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+	// Persistently mapped and cached for the CPU reads
+	VmaAllocationCreateInfo allocationCreateInfo = {};
+	allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
+	allocationCreateInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+	VmaAllocationInfo allocationInfo = {};
+	LOG_VKRESULT(vmaCreateBuffer(vkRef.vmaAllocator, &bufferCreateInfo, &allocationCreateInfo, &m_ReadbackBuffer, &m_ReadbackAllocation, &allocationInfo))
+	m_pReadbackData = allocationInfo.pMappedData;
+
+	// Report to GpuMemoryTracker for accurate GPU memory usage
+	GpuMemoryTracker::AllocatedGpuMemory(GPU_USAGE_READBACK_BUFFER, allocationInfo.size);
+
+	VkCommandBufferAllocateInfo cmdBufferAllocateInfo = {};
+	cmdBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	cmdBufferAllocateInfo.commandPool = vkRef.graphicsCommandPool;
+	cmdBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	cmdBufferAllocateInfo.commandBufferCount = 1;
+	LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &cmdBufferAllocateInfo, &m_ReadbackCmdBuffer))
+
+	VkFenceCreateInfo fenceCreateInfo = {};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	LOG_VKRESULT(vkCreateFence(vkRef.logDevice, &fenceCreateInfo, &vkRef.hostAllocator, &m_ReadbackFence))
+}
@@ -0,0 +1,199 @@
+#include "ParallelRecorder.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "MemoryTracker.h"
+
+
+namespace ParallelRecorder
+{
+	// What one RecordDraws() call hands the workers
+	struct _Job
+	{
+		const FrameContext* pFrame = nullptr;
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		std::span<const DrawItem> draws = {};
+		u32 numSlices = 0;
+		u64 generation = 0;		// Bumped for every job, how a worker tells a new job from the one it already did
+	};
+
+	u32 _requestedThreads = 0;
+	u32 _numThreads = 1;
+	T_small_vector<std::thread, VkConfig::inlineRecordingThreads, MT_GRAPHICS> _workers = {};
+
+	// Worker state, guarded by _mutex
+	std::mutex _mutex;
+	std::condition_variable _jobReady;
+	std::condition_variable _jobDone;
+	_Job _job = {};
+	u32 _remainingSlices = 0;
+	bool _bShuttingDown = false;
+
+	// Records slice of job's draws into the slice's secondary buffer
+	void _RecordSlice(const _Job& job, u32 slice);
+
+	// Worker loop, records slice threadIndex of every job that has one for it until shutdown
+	void _WorkerMain(u32 threadIndex);
+}
+
+void ParallelRecorder::SetThreadCount(u32 numThreads)
+{
+	_requestedThreads = numThreads;
+}
+
+void ParallelRecorder::InitializeParallelRecorder(VkRef& vkRef)
+{
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+	LOG_DEBUG("Initializing Parallel Recorder...")
+
+	const u32 numCores = std::max(std::thread::hardware_concurrency(), 1u);
+	_numThreads = std::clamp(_requestedThreads != 0 ? _requestedThreads : numCores, 1u, maxRecordingThreads);
+
+	// Each thread only ever records from its own pool, so no pool is touched by two threads at once
+	VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+	commandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.graphicsQueueIndex;
+
+	VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+	commandBufferAllocateInfo.commandBufferCount = 1;
+
+	for (FrameContext& frame : vkRef.frames)
+	{
+		frame.secondaryCommandPools.resize(_numThreads);
+		frame.secondaryCommandBuffers.resize(_numThreads);
+		for (u32 i = 0; i < _numThreads; i++)
+		{
+			LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &commandPoolCreateInfo, &vkRef.hostAllocator, &frame.secondaryCommandPools[i]))
+			commandBufferAllocateInfo.commandPool = frame.secondaryCommandPools[i];
+			LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &commandBufferAllocateInfo, &frame.secondaryCommandBuffers[i]))
+		}
+	}
+
+	// Thread 0 is whoever calls RecordDraws()
+	_bShuttingDown = false;
+	for (u32 i = 1; i < _numThreads; i++)
+	{
+		_workers.emplace_back(_WorkerMain, i);
+	}
+
+	LOG_INFO_FMT("Parallel Recorder Initialized | Recording Threads: {}", _numThreads)
+}
+
+void ParallelRecorder::ShutdownParallelRecorder(VkRef& vkRef)
+{
+	{
+		std::lock_guard lock(_mutex);
+		_bShuttingDown = true;
+	}
+	_jobReady.notify_all();
+	for (std::thread& worker : _workers)
+	{
+		worker.join();
+	}
+	_workers.clear();
+
+	// Destroying a pool frees its command buffers
+	for (FrameContext& frame : vkRef.frames)
+	{
+		for (VkCommandPool pool : frame.secondaryCommandPools)
+		{
+			vkDestroyCommandPool(vkRef.logDevice, pool, &vkRef.hostAllocator);
+		}
+		frame.secondaryCommandPools.clear();
+		frame.secondaryCommandBuffers.clear();
+	}
+}
+
+u32 ParallelRecorder::GetThreadCount()
+{
+	return _numThreads;
+}
+
+std::span<const VkCommandBuffer> ParallelRecorder::RecordDraws(const FrameContext& frame, VkRenderPass renderPass, VkFramebuffer frameBuffer, std::span<const DrawItem> draws)
+{
+	if (draws.empty()) { return {}; }
+	PROFILE_ZONE("ParallelRecorder::RecordDraws")
+
+	_Job job = {};
+	job.pFrame = &frame;
+	job.inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	job.inheritanceInfo.renderPass = renderPass;
+	job.inheritanceInfo.subpass = 0;
+	job.inheritanceInfo.framebuffer = frameBuffer;
+	job.draws = draws;
+	job.numSlices = std::clamp(static_cast<u32>(draws.size() / minDrawsPerSlice), 1u, static_cast<u32>(frame.secondaryCommandBuffers.size()));
+
+	if (job.numSlices > 1)
+	{
+		{
+			std::lock_guard lock(_mutex);
+			job.generation = _job.generation + 1;
+			_job = job;
+			_remainingSlices = job.numSlices - 1;
+		}
+		_jobReady.notify_all();
+	}
+
+	_RecordSlice(job, 0);
+
+	if (job.numSlices > 1)
+	{
+		PROFILE_WAIT_ZONE("Wait For Render Workers")
+		std::unique_lock lock(_mutex);
+		_jobDone.wait(lock, []() { return _remainingSlices == 0; });
+	}
+
+	return { frame.secondaryCommandBuffers.data(), job.numSlices };
+}
+
+void ParallelRecorder::_RecordSlice(const _Job& job, u32 slice)
+{
+	PROFILE_ZONE("Record Draw Slice")
+
+	const VkCommandBuffer cmdBuffer = job.pFrame->secondaryCommandBuffers[slice];
+
+	// Continues the primary's render pass, inheritance says which one
+	VkCommandBufferBeginInfo beginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+	beginInfo.pInheritanceInfo = &job.inheritanceInfo;
+	LOG_VKRESULT(vkBeginCommandBuffer(cmdBuffer, &beginInfo))
+
+	// Even split, slices differ by at most one draw
+	const u64 begin = job.draws.size() * slice / job.numSlices;
+	const u64 end = job.draws.size() * (slice + 1) / job.numSlices;
+	for (u64 i = begin; i < end; i++)
+	{
+		job.draws[i].pRecord(cmdBuffer, job.draws[i].pUserData);
+	}
+
+	LOG_VKRESULT(vkEndCommandBuffer(cmdBuffer))
+}
+
+void ParallelRecorder::_WorkerMain(u32 threadIndex)
+{
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+	Profiler::SetThreadName("Render Worker");
+
+	u64 lastGeneration = 0;
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		_jobReady.wait(lock, [&lastGeneration]() { return _bShuttingDown || _job.generation != lastGeneration; });
+		if (_bShuttingDown) { return; }
+
+		lastGeneration = _job.generation;
+		if (threadIndex >= _job.numSlices) { continue; }
+
+		const _Job job = _job;
+		lock.unlock();
+		_RecordSlice(job, threadIndex);
+		lock.lock();
+
+		if (--_remainingSlices == 0)
+		{
+			_jobDone.notify_one();
+		}
+	}
+}
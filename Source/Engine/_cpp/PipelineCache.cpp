@@ -0,0 +1,227 @@
+#include "PipelineCache.h"
+#include "VkTypes.h"
+#include "FileHelper.h"
+#include "Logger.h"
+#include "LayerContainers.h"
+#include <span>
+
+
+namespace PipelineCache
+{
+	// Path relative to the current working directory, in FileHelper::cacheFolderPath
+	constexpr const char* _cacheFilePath = "Cache\\PipelineCache.bin";
+
+	constexpr u32 _fileVersion = 1;
+
+	// Written ahead of the driver's cache data. Vulkan's own header has no driver version, and not every driver changes its
+	// pipelineCacheUUID on update.
+	struct _FileHeader
+	{
+		std::array<char, 4> magic = { 'L', 'P', 'C', 'F' };
+		u32 version = _fileVersion;
+		u32 vendorID = 0;
+		u32 deviceID = 0;
+		u32 driverVersion = 0;
+		std::array<u8, VK_UUID_SIZE> pipelineCacheUUID = {};
+		u64 dataSize = 0;
+		u64 dataHash = 0;
+	};
+
+	// File contents between LoadPipelineCacheFile() and CreatePipelineCache()
+	T_vector<u8, MT_GRAPHICS> _fileData = {};
+	u64 _loadedDataHash = 0;
+	bool _bWarm = false;
+
+	// Header describing data saved from this device
+	_FileHeader _MakeHeader(const VkPhysicalDeviceProperties& properties);
+
+	// The driver's cache data inside a cache file, empty if the file wasn't written on this device/driver or is corrupt.
+	// outReason says why it was rejected.
+	std::span<const u8> _GetValidCacheData(const T_vector<u8, MT_GRAPHICS>& file, const VkPhysicalDeviceProperties& properties, const char*& outReason);
+
+	// FNV-1a
+	u64 _HashData(const u8* pData, u64 size);
+}
+
+void PipelineCache::LoadPipelineCacheFile()
+{
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+
+	if (!FileHelper::ReadBinaryFile(_cacheFilePath, _fileData))
+	{
+		_fileData.clear();
+	}
+}
+
+void PipelineCache::CreatePipelineCache(VkRef& vkRef)
+{
+	LOG_DEBUG("Creating Vulkan Pipeline Cache...")
+
+	const char* pReason = "No cache file";
+	const std::span<const u8> cacheData = _fileData.empty() ? std::span<const u8>() : _GetValidCacheData(_fileData, vkRef.phyDevice.properties, pReason);
+
+	VkPipelineCacheCreateInfo createInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+	createInfo.initialDataSize = cacheData.size();
+	createInfo.pInitialData = cacheData.data();
+
+	// A driver can still refuse data that passed our checks, start cold rather than without a cache
+	VkResult result = vkCreatePipelineCache(vkRef.logDevice, &createInfo, &vkRef.hostAllocator, &vkRef.pipelineCache);
+	if (result != VK_SUCCESS && !cacheData.empty())
+	{
+		pReason = "Driver rejected the cache data";
+		createInfo.initialDataSize = 0;
+		createInfo.pInitialData = nullptr;
+		result = vkCreatePipelineCache(vkRef.logDevice, &createInfo, &vkRef.hostAllocator, &vkRef.pipelineCache);
+	}
+	LOG_VKRESULT(result)
+
+	_bWarm = result == VK_SUCCESS && createInfo.initialDataSize != 0;
+	if (_bWarm)
+	{
+		_loadedDataHash = _HashData(cacheData.data(), cacheData.size());
+		LOG_INFO_FMT("Pipeline cache hit | Loaded {} bytes from {}", cacheData.size(), _cacheFilePath)
+	}
+	else
+	{
+		LOG_INFO_FMT("Pipeline cache miss | {}, pipelines will compile from scratch", pReason)
+	}
+
+	_fileData.clear();
+	_fileData.shrink_to_fit();
+}
+
+void PipelineCache::SaveAndDestroyPipelineCache(VkRef& vkRef)
+{
+	if (vkRef.pipelineCache == VK_NULL_HANDLE) { return; }
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+	LOG_DEBUG("Saving Vulkan Pipeline Cache...")
+
+	const VkPhysicalDeviceProperties& properties = vkRef.phyDevice.properties;
+
+	// Another instance (a second editor, LayerBench) may have saved since we loaded. Merge its pipelines in instead of dropping them.
+	T_vector<u8, MT_GRAPHICS> diskFile;
+	if (FileHelper::ReadBinaryFile(_cacheFilePath, diskFile))
+	{
+		const char* pReason = nullptr;
+		const std::span<const u8> diskData = _GetValidCacheData(diskFile, properties, pReason);
+		if (!diskData.empty() && _HashData(diskData.data(), diskData.size()) != _loadedDataHash)
+		{
+			VkPipelineCacheCreateInfo createInfo = { VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO };
+			createInfo.initialDataSize = diskData.size();
+			createInfo.pInitialData = diskData.data();
+
+			VkPipelineCache diskCache = VK_NULL_HANDLE;
+			if (vkCreatePipelineCache(vkRef.logDevice, &createInfo, &vkRef.hostAllocator, &diskCache) == VK_SUCCESS)
+			{
+				LOG_VKRESULT(vkMergePipelineCaches(vkRef.logDevice, vkRef.pipelineCache, 1, &diskCache))
+				vkDestroyPipelineCache(vkRef.logDevice, diskCache, &vkRef.hostAllocator);
+			}
+		}
+	}
+
+	size_t dataSize = 0;
+	LOG_VKRESULT(vkGetPipelineCacheData(vkRef.logDevice, vkRef.pipelineCache, &dataSize, nullptr))
+
+	T_vector<u8, MT_GRAPHICS> file(sizeof(_FileHeader) + dataSize);
+	const VkResult result = vkGetPipelineCacheData(vkRef.logDevice, vkRef.pipelineCache, &dataSize, file.data() + sizeof(_FileHeader));
+	file.resize(sizeof(_FileHeader) + dataSize);
+
+	vkDestroyPipelineCache(vkRef.logDevice, vkRef.pipelineCache, &vkRef.hostAllocator);
+	vkRef.pipelineCache = VK_NULL_HANDLE;
+
+	if (result != VK_SUCCESS || dataSize == 0)
+	{
+		LOG_WARNING("Couldn't get the pipeline cache's data, it wasn't saved")
+		return;
+	}
+
+	_FileHeader header = _MakeHeader(properties);
+	header.dataSize = dataSize;
+	header.dataHash = _HashData(file.data() + sizeof(_FileHeader), dataSize);
+	memcpy(file.data(), &header, sizeof(header));
+
+	FileHelper::CreateFolderIfAbsent(FileHelper::cacheFolderPath);
+	if (!FileHelper::WriteBinaryFileAtomic(file.data(), file.size(), _cacheFilePath))
+	{
+		LOG_WARNING(T_string("Couldn't write the pipeline cache to ", _cacheFilePath))
+		return;
+	}
+
+	LOG_INFO_FMT("Saved {} bytes of pipeline cache", dataSize)
+}
+
+bool PipelineCache::IsWarm()
+{
+	return _bWarm;
+}
+
+PipelineCache::_FileHeader PipelineCache::_MakeHeader(const VkPhysicalDeviceProperties& properties)
+{
+	_FileHeader header = {};
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.pipelineCacheUUID.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+	return header;
+}
+
+std::span<const u8> PipelineCache::_GetValidCacheData(const T_vector<u8, MT_GRAPHICS>& file, const VkPhysicalDeviceProperties& properties, const char*& outReason)
+{
+	_FileHeader header = {};
+	if (file.size() < sizeof(header))
+	{
+		outReason = "Cache file is truncated";
+		return {};
+	}
+	memcpy(&header, file.data(), sizeof(header));
+
+	const _FileHeader expected = _MakeHeader(properties);
+	if (header.magic != expected.magic || header.version != _fileVersion)
+	{
+		outReason = "Cache file is from an older engine version";
+		return {};
+	}
+	if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID || header.pipelineCacheUUID != expected.pipelineCacheUUID)
+	{
+		outReason = "Cache file was written on a different GPU";
+		return {};
+	}
+	if (header.driverVersion != expected.driverVersion)
+	{
+		outReason = "GPU driver changed since the cache was written";
+		return {};
+	}
+	if (header.dataSize != file.size() - sizeof(header) || header.dataHash != _HashData(file.data() + sizeof(header), header.dataSize))
+	{
+		outReason = "Cache file is corrupt";
+		return {};
+	}
+
+	// The driver's own header has to agree too, it's what the driver checks before trusting the rest
+	VkPipelineCacheHeaderVersionOne driverHeader = {};
+	if (header.dataSize < sizeof(driverHeader))
+	{
+		outReason = "Cache file is corrupt";
+		return {};
+	}
+	memcpy(&driverHeader, file.data() + sizeof(header), sizeof(driverHeader));
+	if (driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || driverHeader.vendorID != properties.vendorID ||
+		driverHeader.deviceID != properties.deviceID || memcmp(driverHeader.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+	{
+		outReason = "Driver cache header doesn't match this device";
+		return {};
+	}
+
+	return { file.data() + sizeof(header), header.dataSize };
+}
+
+u64 PipelineCache::_HashData(const u8* pData, u64 size)
+{
+	u64 hash = 14695981039346656037ull;
+	for (u64 i = 0; i < size; i++)
+	{
+		hash ^= pData[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
@@ -0,0 +1,515 @@
+#include "Profiler.h"
+
+#ifdef LAYER_USE_PROFILER
+#include "MemoryTracker.h"
+#include "FileHelper.h"
+#include "Logger.h"
+#include "ImGuiManager.h"
+
+
+namespace Profiler
+{
+	// Single producer (the owning thread) single consumer (EndFrame on the main thread) ring of finished zones
+	struct _ThreadBuffer
+	{
+		std::array<Zone, threadZoneCapacity> zones = {};
+		alignas(64) std::atomic<u64> head = 0;				// Next zone the owner writes
+		alignas(64) std::atomic<u64> tail = 0;				// Next zone EndFrame reads
+		std::atomic<u64> droppedZones = 0;
+		u16 threadIndex = 0;
+		T_string name = {};									// Guarded by _threadsMutex
+	};
+
+	// Main thread frame, CPU and blocked time in ms, for the Performance window
+	struct _FrameTiming
+	{
+		f32 frameTime = 0.0f;
+		f32 cpuTime = 0.0f;			// frameTime - blockedTime
+		f32 blockedTime = 0.0f;
+	};
+
+	struct _TimingStats
+	{
+		f32 average = 0.0f;
+		f32 p50 = 0.0f;
+		f32 p95 = 0.0f;
+		f32 p99 = 0.0f;
+		f32 max = 0.0f;
+	};
+
+	// Paths relative to the current working directory, next to the session log
+	constexpr const char* _chromeTracePath = "Logs\\CpuProfile.json";
+	constexpr const char* _spikeTracePath = "Logs\\CpuSpike.json";
+
+	// Frames between refreshes of the spike threshold when the Performance window isn't updating it
+	constexpr u64 _spikeThresholdRefreshInterval = 64;
+
+	// Every thread that has recorded a zone. Buffers live until exit so a thread's zones can be drained after it's gone.
+	std::mutex _threadsMutex;
+	T_vector<std::unique_ptr<_ThreadBuffer>, MT_ENGINE> _threadBuffers = {};
+	thread_local _ThreadBuffer* _pThreadBuffer = nullptr;
+
+	// Copy of the thread names EndFrame() takes for the main thread, so GetThreadName() doesn't need the lock
+	T_vector<T_string, MT_ENGINE> _threadNames = {};
+
+	std::array<FrameCapture, frameHistoryLength> _frames = {};
+	u64 _numCapturedFrames = 0;
+	u64 _lastFrameEnd = 0;
+	u16 _mainThreadIndex = 0;
+
+	std::array<_FrameTiming, frameTimeHistoryLength> _frameTimings = {};
+	u64 _numFrameTimings = 0;
+	T_vector<f32, MT_ENGINE> _statsScratch = {};
+
+	// Last frames the stats/graphs cover, set in the Performance window
+	i32 _statsWindow = 600;
+
+	// A frame slower than _spikeMultiplier * p50 gets its zones copied to _spikeFrame and written to _spikeTracePath, once per arming
+	f32 _spikeMultiplier = 2.0f;
+	f32 _spikeThreshold = 0.0f;		// ms, 0 until there are enough frames for a p50
+	bool _bSpikeArmed = true;
+	bool _bHasSpike = false;
+	FrameCapture _spikeFrame = {};
+
+	// Trace timestamps are relative to this
+	u64 _startTime = Now();
+
+	// --Internal helpers--
+
+	// Calling thread's ring, registered on first use
+	_ThreadBuffer& _GetThreadBuffer();
+
+	// Adds a ring to _threadBuffers, _threadsMutex must be held
+	_ThreadBuffer& _AddThreadBuffer();
+
+	// Pushes a zone into a ring from its one producer, counts it as dropped if the ring is full
+	void _PushZone(_ThreadBuffer& buffer, const char* name, u64 begin, u64 end, u16 depth, bool bBlocking);
+
+	// Number of frame timings currently held in the ring
+	u32 _NumFrameTimings();
+
+	// i-th oldest frame timing still in the ring
+	const _FrameTiming& _GetFrameTiming(u32 i);
+
+	// Average/percentiles/max of one _FrameTiming member over the newest numFrames frames
+	_TimingStats _ComputeStats(u32 numFrames, f32 _FrameTiming::* member);
+
+	// Chrome trace pieces shared by the full and spike exports
+	void _AppendThreadNameEvents(T_string& trace, bool& bFirstEvent);
+	void _AppendZoneEvents(T_string& trace, const FrameCapture& frame, bool& bFirstEvent);
+
+	// Keeps the frame if it's a spike and one is armed
+	void _CheckForSpike(const FrameCapture& frame);
+
+	// Register function ImGui manager uses to draw the Performance window
+	void _DrawPerformanceUI();
+}
+
+void Profiler::InitializeProfiler()
+{
+	_startTime = Now();
+	_lastFrameEnd = _startTime;
+	SetThreadName("Main");
+	_mainThreadIndex = _GetThreadBuffer().threadIndex;
+
+	REGISTER_EDITOR_UI_WINDOW(nullptr, Profiler::_DrawPerformanceUI)
+}
+
+void Profiler::ShutdownProfiler()
+{
+	if (_numCapturedFrames == 0) { return; }
+
+	ExportChromeTrace(_chromeTracePath);
+
+	const u64 droppedZones = NumDroppedZones();
+	LOG_WARNING_IF(droppedZones != 0, T_string("Profiler dropped ", std::to_string(droppedZones), " zones, a thread recorded more than ", std::to_string(threadZoneCapacity), " zones in one frame"))
+}
+
+void Profiler::EndFrame()
+{
+	FrameCapture& frame = _frames[_numCapturedFrames % frameHistoryLength];
+	frame.frameNumber = _numCapturedFrames;
+	frame.begin = _lastFrameEnd;
+	frame.end = Now();
+	frame.blockedTime = 0;
+	frame.zones.clear();
+
+	{
+		std::lock_guard lock(_threadsMutex);
+		for (const std::unique_ptr<_ThreadBuffer>& pBuffer : _threadBuffers)
+		{
+			const u64 tail = pBuffer->tail.load(std::memory_order_relaxed);
+			const u64 head = pBuffer->head.load(std::memory_order_acquire);
+			for (u64 i = tail; i < head; i++)
+			{
+				const Zone& zone = pBuffer->zones[i % threadZoneCapacity];
+				frame.zones.push_back(zone);
+				if (zone.bBlocking && zone.threadIndex == _mainThreadIndex)
+				{
+					frame.blockedTime += zone.end - zone.begin;
+				}
+			}
+			pBuffer->tail.store(head, std::memory_order_release);
+		}
+
+		_threadNames.resize(_threadBuffers.size());
+		for (u64 i = 0; i < _threadBuffers.size(); i++)
+		{
+			_threadNames[i] = _threadBuffers[i]->name;
+		}
+	}
+
+	// The first frame also covers startup, keep it out of the frame times
+	if (_numCapturedFrames != 0)
+	{
+		_FrameTiming& timing = _frameTimings[_numFrameTimings % frameTimeHistoryLength];
+		timing.frameTime = static_cast<f32>(frame.end - frame.begin) / 1e6f;
+		timing.blockedTime = static_cast<f32>(frame.blockedTime) / 1e6f;
+		timing.cpuTime = timing.frameTime - timing.blockedTime;
+		_numFrameTimings++;
+
+		if (_numFrameTimings % _spikeThresholdRefreshInterval == 0)
+		{
+			_spikeThreshold = _ComputeStats(std::min<u32>(static_cast<u32>(_statsWindow), _NumFrameTimings()), &_FrameTiming::frameTime).p50 * _spikeMultiplier;
+		}
+		_CheckForSpike(frame);
+	}
+
+	_lastFrameEnd = frame.end;
+	_numCapturedFrames++;
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	_ThreadBuffer& buffer = _GetThreadBuffer();
+	std::lock_guard lock(_threadsMutex);
+	buffer.name = name;
+}
+
+const T_string& Profiler::GetThreadName(u16 threadIndex)
+{
+	static const T_string unknownThread("Unknown");
+	return threadIndex < _threadNames.size() ? _threadNames[threadIndex] : unknownThread;
+}
+
+u32 Profiler::NumFrames()
+{
+	return static_cast<u32>(std::min<u64>(_numCapturedFrames, frameHistoryLength));
+}
+
+const Profiler::FrameCapture& Profiler::GetFrame(u32 i)
+{
+	const u64 oldestFrame = _numCapturedFrames - NumFrames();
+	return _frames[(oldestFrame + i) % frameHistoryLength];
+}
+
+u64 Profiler::NumDroppedZones()
+{
+	std::lock_guard lock(_threadsMutex);
+	u64 droppedZones = 0;
+	for (const std::unique_ptr<_ThreadBuffer>& pBuffer : _threadBuffers)
+	{
+		droppedZones += pBuffer->droppedZones.load(std::memory_order_relaxed);
+	}
+	return droppedZones;
+}
+
+void Profiler::ExportChromeTrace(const char* filePath)
+{
+	T_string trace("{\"traceEvents\":[\n");
+	bool bFirstEvent = true;
+
+	_AppendThreadNameEvents(trace, bFirstEvent);
+	for (u32 i = 0; i < NumFrames(); i++)
+	{
+		_AppendZoneEvents(trace, GetFrame(i), bFirstEvent);
+	}
+
+	trace.append("\n]}\n");
+	FileHelper::WriteStringToFile(trace, filePath);
+}
+
+u16 Profiler::CreateTrack(const char* name)
+{
+	MEMORY_TAG_SCOPE(MT_ENGINE)
+	std::lock_guard lock(_threadsMutex);
+	_ThreadBuffer& buffer = _AddThreadBuffer();
+	buffer.name = name;
+	return buffer.threadIndex;
+}
+
+void Profiler::RecordTrackZone(u16 trackIndex, const char* name, u64 begin, u64 end, u16 depth)
+{
+	// _threadBuffers can grow under a new thread, tracks aren't hot enough to need more than the lock
+	std::lock_guard lock(_threadsMutex);
+	if (trackIndex >= _threadBuffers.size()) { return; }
+	_PushZone(*_threadBuffers[trackIndex], name, begin, end, depth, false);
+}
+
+void Profiler::RecordZone(const char* name, u64 begin, u64 end, u16 depth, bool bBlocking)
+{
+	_PushZone(_GetThreadBuffer(), name, begin, end, depth, bBlocking);
+}
+
+void Profiler::_PushZone(_ThreadBuffer& buffer, const char* name, u64 begin, u64 end, u16 depth, bool bBlocking)
+{
+	// Only the producer moves head, EndFrame only moves tail
+	const u64 head = buffer.head.load(std::memory_order_relaxed);
+	if (head - buffer.tail.load(std::memory_order_acquire) >= threadZoneCapacity)
+	{
+		buffer.droppedZones.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Zone& zone = buffer.zones[head % threadZoneCapacity];
+	zone.name = name;
+	zone.begin = begin;
+	zone.end = end;
+	zone.depth = depth;
+	zone.threadIndex = buffer.threadIndex;
+	zone.bBlocking = bBlocking;
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+Profiler::_ThreadBuffer& Profiler::_GetThreadBuffer()
+{
+	if (_pThreadBuffer != nullptr) { return *_pThreadBuffer; }
+
+	MEMORY_TAG_SCOPE(MT_ENGINE)
+	std::lock_guard lock(_threadsMutex);
+	_pThreadBuffer = &_AddThreadBuffer();
+	return *_pThreadBuffer;
+}
+
+Profiler::_ThreadBuffer& Profiler::_AddThreadBuffer()
+{
+	std::unique_ptr<_ThreadBuffer>& pBuffer = _threadBuffers.emplace_back(std::make_unique<_ThreadBuffer>());
+	pBuffer->threadIndex = static_cast<u16>(_threadBuffers.size() - 1);
+	pBuffer->name = T_string("Thread ", std::to_string(pBuffer->threadIndex));
+	return *pBuffer;
+}
+
+u32 Profiler::_NumFrameTimings()
+{
+	return static_cast<u32>(std::min<u64>(_numFrameTimings, frameTimeHistoryLength));
+}
+
+const Profiler::_FrameTiming& Profiler::_GetFrameTiming(u32 i)
+{
+	const u64 oldestTiming = _numFrameTimings - _NumFrameTimings();
+	return _frameTimings[(oldestTiming + i) % frameTimeHistoryLength];
+}
+
+Profiler::_TimingStats Profiler::_ComputeStats(u32 numFrames, f32 _FrameTiming::* member)
+{
+	_TimingStats stats = {};
+	if (numFrames == 0) { return stats; }
+
+	const u32 firstFrame = _NumFrameTimings() - numFrames;
+	_statsScratch.resize(numFrames);
+	for (u32 i = 0; i < numFrames; i++)
+	{
+		_statsScratch[i] = _GetFrameTiming(firstFrame + i).*member;
+		stats.average += _statsScratch[i];
+	}
+	stats.average /= static_cast<f32>(numFrames);
+
+	// Nearest rank percentiles. Each nth_element only has to partition what's past the previous rank, read each one before the next moves it.
+	const auto rank = [numFrames](f32 percentile) { return std::max(static_cast<u32>(std::ceil(percentile * static_cast<f32>(numFrames))), 1u) - 1; };
+	u32 prevRank = 0;
+	const auto percentile = [&prevRank, rank](f32 p)
+	{
+		const u32 r = std::max(rank(p), prevRank);
+		std::nth_element(_statsScratch.begin() + prevRank, _statsScratch.begin() + r, _statsScratch.end());
+		prevRank = r;
+		return _statsScratch[r];
+	};
+	stats.p50 = percentile(0.50f);
+	stats.p95 = percentile(0.95f);
+	stats.p99 = percentile(0.99f);
+	stats.max = *std::max_element(_statsScratch.begin() + prevRank, _statsScratch.end());
+
+	return stats;
+}
+
+void Profiler::_AppendThreadNameEvents(T_string& trace, bool& bFirstEvent)
+{
+	// Track names first so every viewer labels the threads
+	for (u64 i = 0; i < _threadNames.size(); i++)
+	{
+		trace.AppendMany(bFirstEvent ? "" : ",\n",
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":", std::to_string(i), ",\"args\":{\"name\":\"", _threadNames[i], "\"}}");
+		bFirstEvent = false;
+	}
+}
+
+void Profiler::_AppendZoneEvents(T_string& trace, const FrameCapture& frame, bool& bFirstEvent)
+{
+	const auto toMicroseconds = [](u64 ns) { return std::to_string(static_cast<f64>(ns) / 1000.0); };
+
+	for (const Zone& zone : frame.zones)
+	{
+		// Complete events, viewers nest them by time on each thread's track
+		trace.AppendMany(bFirstEvent ? "" : ",\n",
+			"{\"name\":\"", zone.name, "\",\"ph\":\"X\",\"ts\":", toMicroseconds(zone.begin - std::min(zone.begin, _startTime)),
+			",\"dur\":", toMicroseconds(zone.end - zone.begin), ",\"pid\":0,\"tid\":", std::to_string(zone.threadIndex), "}");
+		bFirstEvent = false;
+	}
+}
+
+void Profiler::_CheckForSpike(const FrameCapture& frame)
+{
+	const f32 frameTime = static_cast<f32>(frame.end - frame.begin) / 1e6f;
+	if (!_bSpikeArmed || _spikeThreshold <= 0.0f || frameTime < _spikeThreshold) { return; }
+
+	// Thread by thread, parents before their children
+	_spikeFrame = frame;
+	std::sort(_spikeFrame.zones.begin(), _spikeFrame.zones.end(), [](const Zone& a, const Zone& b)
+	{
+		return std::tie(a.threadIndex, a.begin, a.depth) < std::tie(b.threadIndex, b.begin, b.depth);
+	});
+	_bHasSpike = true;
+	_bSpikeArmed = false;
+
+	T_string trace("{\"traceEvents\":[\n");
+	bool bFirstEvent = true;
+	_AppendThreadNameEvents(trace, bFirstEvent);
+	_AppendZoneEvents(trace, _spikeFrame, bFirstEvent);
+	trace.append("\n]}\n");
+	FileHelper::WriteStringToFile(trace, _spikeTracePath);
+
+	LOG_INFO_FMT("Frame spike captured | Frame: {} | Time: {} ms | Threshold: {} ms | Zones: {}", frame.frameNumber, frameTime, _spikeThreshold, _spikeFrame.zones.size())
+}
+
+void Profiler::_DrawPerformanceUI()
+{
+	ImGui::Begin("Performance");
+
+	const u32 numTimings = _NumFrameTimings();
+	if (numTimings == 0)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::SliderInt("Stats Window (frames)", &_statsWindow, 16, frameTimeHistoryLength, "%d", ImGuiSliderFlags_AlwaysClamp);
+	const u32 numFrames = std::min<u32>(static_cast<u32>(_statsWindow), numTimings);
+
+	const _TimingStats frameStats = _ComputeStats(numFrames, &_FrameTiming::frameTime);
+	const _TimingStats cpuStats = _ComputeStats(numFrames, &_FrameTiming::cpuTime);
+	const _TimingStats blockedStats = _ComputeStats(numFrames, &_FrameTiming::blockedTime);
+	_spikeThreshold = frameStats.p50 * _spikeMultiplier;
+
+	// Newest numFrames frames, oldest on the left. The getters can't capture so the first plotted frame rides in the data pointer.
+	u32 firstPlotted = numTimings - numFrames;
+	const auto frameTimeGetter = [](void* pFirst, i32 i) { return _GetFrameTiming(*static_cast<u32*>(pFirst) + i).frameTime; };
+	const auto cpuTimeGetter = [](void* pFirst, i32 i) { return _GetFrameTiming(*static_cast<u32*>(pFirst) + i).cpuTime; };
+	const auto blockedTimeGetter = [](void* pFirst, i32 i) { return _GetFrameTiming(*static_cast<u32*>(pFirst) + i).blockedTime; };
+
+	const _FrameTiming& latest = _GetFrameTiming(numTimings - 1);
+	const T_string frameOverlay(std::to_string(latest.frameTime), " ms");
+	const T_string cpuOverlay(std::to_string(latest.cpuTime), " ms");
+	const T_string blockedOverlay(std::to_string(latest.blockedTime), " ms");
+	const f32 plotMax = frameStats.max * 1.1f;	// Same scale for all three so they compare at a glance
+	ImGui::PlotLines("Frame (ms)", frameTimeGetter, &firstPlotted, static_cast<i32>(numFrames), 0, frameOverlay.c_str(), 0.0f, plotMax, ImVec2(0.0f, 80.0f));
+	ImGui::PlotLines("CPU (ms)", cpuTimeGetter, &firstPlotted, static_cast<i32>(numFrames), 0, cpuOverlay.c_str(), 0.0f, plotMax, ImVec2(0.0f, 60.0f));
+	ImGui::PlotLines("Blocked (ms)", blockedTimeGetter, &firstPlotted, static_cast<i32>(numFrames), 0, blockedOverlay.c_str(), 0.0f, plotMax, ImVec2(0.0f, 60.0f));
+	ImGui::TextDisabled("Blocked: main thread time in vkWaitForFences/vkAcquireNextImageKHR (PROFILE_WAIT_ZONE), CPU: the rest of the frame");
+
+	constexpr ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+
+	ImGui::SeparatorText("Percentiles (ms)");
+	if (ImGui::BeginTable("FrameTimeTable", 6, flags))
+	{
+		ImGui::TableSetupColumn("");
+		ImGui::TableSetupColumn("Avg");
+		ImGui::TableSetupColumn("p50");
+		ImGui::TableSetupColumn("p95");
+		ImGui::TableSetupColumn("p99");
+		ImGui::TableSetupColumn("Max");
+		ImGui::TableHeadersRow();
+
+		const auto statsRow = [](const char* label, const _TimingStats& stats)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableSetColumnIndex(0);
+			ImGui::TextUnformatted(label);
+			ImGui::TableSetColumnIndex(1);
+			ImGui::Text("%.2f", stats.average);
+			ImGui::TableSetColumnIndex(2);
+			ImGui::Text("%.2f", stats.p50);
+			ImGui::TableSetColumnIndex(3);
+			ImGui::Text("%.2f", stats.p95);
+			ImGui::TableSetColumnIndex(4);
+			ImGui::Text("%.2f", stats.p99);
+			ImGui::TableSetColumnIndex(5);
+			ImGui::Text("%.2f", stats.max);
+		};
+		statsRow("Frame", frameStats);
+		statsRow("CPU", cpuStats);
+		statsRow("Blocked", blockedStats);
+		ImGui::EndTable();
+	}
+
+	ImGui::SeparatorText("Spike Capture");
+
+	ImGui::SliderFloat("Threshold (x p50)", &_spikeMultiplier, 1.25f, 10.0f, "%.2fx", ImGuiSliderFlags_AlwaysClamp);
+	if (_bSpikeArmed)
+	{
+		ImGui::Text("Armed, waiting for a frame over %.2f ms", _spikeThreshold);
+		ImGui::SameLine();
+		if (ImGui::Button("Disarm")) { _bSpikeArmed = false; }
+	}
+	else if (ImGui::Button("Arm"))
+	{
+		_bSpikeArmed = true;
+	}
+
+	if (!_bHasSpike)
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("Frame %llu: %.2f ms, %.2f ms blocked, zones written to %s", static_cast<unsigned long long>(_spikeFrame.frameNumber),
+		static_cast<f64>(_spikeFrame.end - _spikeFrame.begin) / 1e6, static_cast<f64>(_spikeFrame.blockedTime) / 1e6, _spikeTracePath);
+
+	if (ImGui::BeginTable("SpikeZoneTable", 4, flags | ImGuiTableFlags_ScrollY, ImVec2(0.0f, 300.0f)))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Thread");
+		ImGui::TableSetupColumn("Zone");
+		ImGui::TableSetupColumn("Start (ms)");
+		ImGui::TableSetupColumn("Duration (ms)");
+		ImGui::TableHeadersRow();
+
+		ImGuiListClipper clipper;
+		clipper.Begin(static_cast<i32>(_spikeFrame.zones.size()));
+		while (clipper.Step())
+		{
+			for (i32 i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+			{
+				const Zone& zone = _spikeFrame.zones[i];
+
+				ImGui::TableNextRow();
+				// Thread Name
+				ImGui::TableSetColumnIndex(0);
+				ImGui::TextUnformatted(GetThreadName(zone.threadIndex).c_str());
+				// Zone name indented by nesting depth
+				ImGui::TableSetColumnIndex(1);
+				ImGui::Text("%*s%s", zone.depth * 2, "", zone.name);
+				// Start relative to the frame's start, zones from before it (other threads) go negative
+				ImGui::TableSetColumnIndex(2);
+				ImGui::Text("%.3f", static_cast<f64>(static_cast<i64>(zone.begin - _spikeFrame.begin)) / 1e6);
+				// Duration
+				ImGui::TableSetColumnIndex(3);
+				ImGui::Text("%.3f", static_cast<f64>(zone.end - zone.begin) / 1e6);
+			}
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::End();
+}
+
+#endif // LAYER_USE_PROFILER
@@ -3,11 +3,18 @@
 #include "Viewport.h"
 #include "RenderPass.h"
 #include "SwapChain.h"
+#include "OffscreenTarget.h"
 #include "Logger.h"
 #include "ImGuiManager.h"
 #include "VkTypes.h"
 #include "LoggingCallbacks.h"
 #include "LayerContainers.h"
+#include "FrameArena.h"
+#include "Profiler.h"
+#include "GpuProfiler.h"
+#include "StartupGraph.h"
+#include "PipelineCache.h"
+#include "ParallelRecorder.h"
 
 namespace RenderManager
 {
@@ -21,45 +28,117 @@ namespace RenderManager
 
 	RenderPass m_RenderPass = {};
 
-	// Semaphores (GPU sync) and Fences (GPU->CPU sync)
-	T_vector<VkSemaphore, MT_GRAPHICS> _ImageAvailable = {};
-	T_vector<VkSemaphore, MT_GRAPHICS> _RenderFinished = {};
-	T_vector<VkFence, MT_GRAPHICS> _DrawFence = {};
+	// Headless mode renders here instead of the swap chain
+	OffscreenTarget _OffscreenTarget = {};
+	u32 _LastDrawnFrame = U32_MAX;
+	bool _bCloseRequested = false;
+
+	// Draws submitted for the next frame, and the ones the frame being recorded took over
+	T_vector<ParallelRecorder::DrawItem, MT_GRAPHICS> _PendingDraws = {};
+	T_vector<ParallelRecorder::DrawItem, MT_GRAPHICS> _FrameDraws = {};
+
+	// One per swap chain image rather than per frame, presentation holds it until that image is acquired again
+	T_small_vector<VkSemaphore, VkConfig::inlineSwapChainImages, MT_GRAPHICS> _RenderFinished = {};
 
 	// -- Internal Helpers --
 
+	// Waits on the frame's fence, then recycles its command pools and arena block. Returns the frame's context.
+	FrameContext& _BeginFrameContext();
+
 	// Start cmd buffer, write to it, and end it
-	void _RecordCommands(u32 currentImage);
+	void _RecordCommands(const FrameContext& frame, u32 currentImage);
+
+	// Records _FrameDraws in parallel into secondary buffers, then begins the pass in cmdBuffer and executes them. beginPass begins
+	// renderPass on cmdBuffer with the given contents. Without draws the pass is begun inline and left empty.
+	void _RecordPass(const FrameContext& frame, VkCommandBuffer cmdBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+		const std::function<void(VkSubpassContents)>& beginPass);
+
+	// Creates render finished semaphores up to the swap chain's image count, which can grow when it's rebuilt
+	void _CreateRenderFinishedSemaphores(u64 imageCount);
 
-	// Creates vulkan GPU sync Semaphores and GPU->CPU sync Fences
-	void _CreateSemaphoresAndFences();
+	// DrawFrame without a swap chain, no acquire/present and nothing to wait on but the frame's fence
+	void _DrawHeadlessFrame();
+
+	// Caps the window at the largest frame buffer the physical device supports
+	void _SetWindowSizeLimits();
 }
 
 
-void RenderManager::Initialize(const char* appName, u32 winWidth, u32 winHeight)
+void RenderManager::Initialize(const char* appName, u32 winWidth, u32 winHeight, bool bHeadless)
 {
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
 	LOG_DEBUG("Initializing Render Manager...")
 
-	_Viewport.CreateViewport(appName, winWidth, winHeight);
+	_VkRef.bHeadless = bHeadless;
+
+	// Each stage waits only on what it reads from _VkRef. GLFW window/callback calls have to stay on the main thread.
+	StartupGraph::StageHandle window = StartupGraph::noStage;
+	StartupGraph::StageHandle surface = StartupGraph::noStage;
+	if (!_VkRef.bHeadless)
+	{
+		window = StartupGraph::AddMainThreadStage("Create Window", [appName, winWidth, winHeight]()
+		{
+			_Viewport.CreateViewport(appName, winWidth, winHeight);
+			_VkRef.pWindow = _Viewport.GetWindow();
+		});
+	}
 
-	_VkRef.pWindow = _Viewport.GetWindow();
+	const StartupGraph::StageHandle pipelineCacheFile = StartupGraph::AddStage("Load Pipeline Cache File", []() { PipelineCache::LoadPipelineCacheFile(); });
 
-	VkSetup::CreateInstance(appName, _VkRef);
-	ValidationLayers::SetupDebugMessenger(_VkRef.instance);
-	VkSetup::CreateSurface(_VkRef);
-	VkSetup::CapturePhysicalDevice(_VkRef);
-	VkSetup::CreateLogicalDevice(_VkRef);
-	VkSetup::CreateVmaAllocator(_VkRef);
-	VkSetup::CreateCommandPools(_VkRef);
-	VkSetup::AllocateCommandBuffers(_VkRef);
+	const StartupGraph::StageHandle instance = StartupGraph::AddStage("Create Vulkan Instance", [appName]()
+	{
+		VkSetup::CreateInstance(appName, _VkRef);
+		ValidationLayers::SetupDebugMessenger(_VkRef.instance);
+	});
+	if (!_VkRef.bHeadless)
+	{
+		surface = StartupGraph::AddStage("Create Surface", []() { VkSetup::CreateSurface(_VkRef); }, { window, instance });
+	}
+
+	const StartupGraph::StageHandle physicalDevice = StartupGraph::AddStage("Capture Physical Device", []() { VkSetup::CapturePhysicalDevice(_VkRef); }, { instance, surface });
+	if (!_VkRef.bHeadless)
+	{
+		StartupGraph::AddMainThreadStage("Window Size Limits", []() { _SetWindowSizeLimits(); }, { window, physicalDevice });
+	}
+
+	const StartupGraph::StageHandle logicalDevice = StartupGraph::AddStage("Create Logical Device", []() { VkSetup::CreateLogicalDevice(_VkRef); }, { physicalDevice });
+	const StartupGraph::StageHandle pipelineCache = StartupGraph::AddStage("Create Pipeline Cache", []() { PipelineCache::CreatePipelineCache(_VkRef); },
+		{ pipelineCacheFile, logicalDevice });
+	const StartupGraph::StageHandle vmaAllocator = StartupGraph::AddStage("Create VMA Allocator", []() { VkSetup::CreateVmaAllocator(_VkRef); }, { logicalDevice });
+	const StartupGraph::StageHandle commandBuffers = StartupGraph::AddStage("Create Frame Contexts", []()
+	{
+		VkSetup::CreateCommandPools(_VkRef);
+		VkSetup::CreateFrameContexts(_VkRef);
+	}, { logicalDevice });
+
+	StartupGraph::AddStage("Frame Arena", []() { FrameArena::InitializeFrameArena(_VkRef.numInFlightFrames); });
+
+	StartupGraph::AddStage("Parallel Recorder", []() { ParallelRecorder::InitializeParallelRecorder(_VkRef); }, { commandBuffers });
+
+	// Calibrates on the graphics pool/queue, which aren't thread safe, so the ImGui font upload waits for it
+	const StartupGraph::StageHandle gpuProfiler = StartupGraph::AddStage("GPU Profiler", []() { GpuProfiler::InitializeGpuProfiler(_VkRef); }, { commandBuffers });
  
-	ImGuiManager::SetupImgui(_VkRef);
-    
-    
-    _SwapChain.CreateInitialSwapChain(_VkRef);
-	m_RenderPass.CreateRenderPass(_VkRef, _SwapChain);
+	if (_VkRef.bHeadless)
+	{
+		StartupGraph::AddStage("Create Offscreen Target", [winWidth, winHeight]() { _OffscreenTarget.CreateOffscreenTarget(_VkRef, { winWidth, winHeight }); }, { vmaAllocator });
+	}
+	else
+	{
+		const StartupGraph::StageHandle imguiContext = StartupGraph::AddStage("Create ImGui Context", []() { ImGuiManager::CreateImguiContext(); });
+		const StartupGraph::StageHandle imgui = StartupGraph::AddMainThreadStage("Setup ImGui", []() { ImGuiManager::SetupImgui(_VkRef); },
+			{ imguiContext, window, gpuProfiler, pipelineCache });
+
+		// The swap chain creates ImGui's frame buffers and reads the window's frame buffer size
+		StartupGraph::AddMainThreadStage("Create Swap Chain", []()
+		{
+			_SwapChain.CreateInitialSwapChain(_VkRef);
+			_CreateRenderFinishedSemaphores(_SwapChain.Size());
+			m_RenderPass.CreateRenderPass(_VkRef, _SwapChain);
+		}, { imgui, vmaAllocator });
+	}
 
-	_CreateSemaphoresAndFences();
+	// Also runs any stages the host added before starting the engine
+	StartupGraph::Run();
 
 	LOG_INFO("Render Manager Initialized")
 }
@@ -72,41 +151,60 @@ void RenderManager::Shutdown()
 	LOG_VKRESULT(vkDeviceWaitIdle(_VkRef.logDevice))
 
 	// Clean up in reverse order of initialization 
-	for (u32 i = 0; i < _VkRef.phyDevice.numInFlightFrames; i++)
+	for (VkSemaphore semaphore : _RenderFinished)
 	{
-		vkDestroyFence(_VkRef.logDevice, _DrawFence[i], &_VkRef.hostAllocator);
-		vkDestroySemaphore(_VkRef.logDevice, _RenderFinished[i], &_VkRef.hostAllocator);
-		vkDestroySemaphore(_VkRef.logDevice, _ImageAvailable[i], &_VkRef.hostAllocator);
+		vkDestroySemaphore(_VkRef.logDevice, semaphore, &_VkRef.hostAllocator);
 	}
+	_RenderFinished.clear();
 
-	ImGuiManager::ShutdownImgui(_VkRef);
+	if (!_VkRef.bHeadless)
+	{
+		ImGuiManager::ShutdownImgui(_VkRef);
+	}
 
-	m_RenderPass.DestroyRenderPass(_VkRef);
-	_SwapChain.DestroySwapChain(_VkRef);
+	FrameArena::ShutdownFrameArena();
+	GpuProfiler::ShutdownGpuProfiler(_VkRef);
 
-	if (_VkRef.bHasTransferCommandBuffer)
+	if (_VkRef.bHeadless)
+	{
+		_OffscreenTarget.DestroyOffscreenTarget(_VkRef);
+	}
+	else
 	{
-		vkFreeCommandBuffers(_VkRef.logDevice, _VkRef.transferCommandPool, (u32)_VkRef.transferCommandBuffers.size(), _VkRef.transferCommandBuffers.data());
-		vkDestroyCommandPool(_VkRef.logDevice, _VkRef.transferCommandPool, &_VkRef.hostAllocator);
+		m_RenderPass.DestroyRenderPass(_VkRef);
+		_SwapChain.DestroySwapChain(_VkRef);
 	}
-	vkFreeCommandBuffers(_VkRef.logDevice, _VkRef.computeCommandPool, (u32)_VkRef.computeCommandBuffers.size(), _VkRef.computeCommandBuffers.data());
-	vkDestroyCommandPool(_VkRef.logDevice, _VkRef.computeCommandPool, &_VkRef.hostAllocator);
-	vkFreeCommandBuffers(_VkRef.logDevice, _VkRef.graphicsCommandPool, (u32)_VkRef.graphicsCommandBuffers.size(), _VkRef.graphicsCommandBuffers.data());
+
+	ParallelRecorder::ShutdownParallelRecorder(_VkRef);
+	VkSetup::DestroyFrameContexts(_VkRef);
 	vkDestroyCommandPool(_VkRef.logDevice, _VkRef.graphicsCommandPool, &_VkRef.hostAllocator);
 
+	PipelineCache::SaveAndDestroyPipelineCache(_VkRef);
+
 	vmaDestroyAllocator(_VkRef.vmaAllocator);
 	vkDestroyDevice(_VkRef.logDevice, &_VkRef.hostAllocator);
-	vkDestroySurfaceKHR(_VkRef.instance, _VkRef.surface, &_VkRef.hostAllocator);
+	if (!_VkRef.bHeadless)
+	{
+		vkDestroySurfaceKHR(_VkRef.instance, _VkRef.surface, &_VkRef.hostAllocator);
+	}
 	ValidationLayers::DestroyDebugUtilsMessengerEXT(_VkRef.instance, &_VkRef.hostAllocator);
 	vkDestroyInstance(_VkRef.instance, &_VkRef.hostAllocator);
 
-	_Viewport.DestroyViewport();
+	if (!_VkRef.bHeadless)
+	{
+		_Viewport.DestroyViewport();
+	}
 
 	LOG_INFO("Render Manager Shut Down")
 }
 
 bool RenderManager::WindowsShouldClose()
 {
+	if (_bCloseRequested || _VkRef.bHeadless)
+	{
+		return _bCloseRequested;
+	}
+
     #if LAYER_PLATFORM_ANDROID
 		// TODO: Android implementation
 		return false;
@@ -115,11 +213,79 @@ bool RenderManager::WindowsShouldClose()
     #endif
 }
 
+void RenderManager::RequestClose()
+{
+	_bCloseRequested = true;
+}
+
+void RenderManager::SetFramesInFlight(u32 numFrames)
+{
+	if (_VkRef.logDevice != VK_NULL_HANDLE)
+	{
+		LOG_WARNING("RenderManager::SetFramesInFlight() has to be called before the render manager initializes, ignoring")
+		return;
+	}
+
+	_VkRef.numInFlightFrames = std::clamp(numFrames, 1u, VkConfig::maxFramesInFlight);
+	LOG_WARNING_IF(_VkRef.numInFlightFrames != numFrames, T_string("Frames in flight clamped to ", std::to_string(_VkRef.numInFlightFrames)))
+}
+
+u32 RenderManager::GetFramesInFlight()
+{
+	return _VkRef.numInFlightFrames;
+}
+
+bool RenderManager::IsHeadless()
+{
+	return _VkRef.bHeadless;
+}
+
+bool RenderManager::ReadbackFrame(T_vector<u8, MT_GRAPHICS>& outPixels)
+{
+	if (!_VkRef.bHeadless || _LastDrawnFrame == U32_MAX)
+	{
+		LOG_WARNING("RenderManager::ReadbackFrame() needs a headless render manager that has drawn a frame")
+		return false;
+	}
+
+	// The frame's image stays untouched until DrawFrame comes back around to its slot, so waiting on its fence is enough
+	{
+		PROFILE_WAIT_ZONE("vkWaitForFences")
+		LOG_VKRESULT(vkWaitForFences(_VkRef.logDevice, 1, &_VkRef.frames[_LastDrawnFrame].drawFence, VK_TRUE, U64_MAX))
+	}
+	_OffscreenTarget.ReadbackImage(_VkRef, _LastDrawnFrame, outPixels);
+	return true;
+}
+
+VkExtent2D RenderManager::GetRenderExtent()
+{
+	return _VkRef.bHeadless ? _OffscreenTarget.Extent() : _SwapChain.Extent();
+}
+
+VkFormat RenderManager::GetRenderFormat()
+{
+	return _VkRef.bHeadless ? _OffscreenTarget.Format() : _VkRef.phyDevice.preferredSurfaceFormat.format;
+}
+
 void RenderManager::DrawFrame()
 {
+	MEMORY_TAG_SCOPE(MT_GRAPHICS)
+	PROFILE_ZONE("RenderManager::DrawFrame")
+
+	// This frame records what was submitted since the last one, even frames that end up skipped drop their draws
+	_FrameDraws.swap(_PendingDraws);
+	_PendingDraws.clear();
+
+	if (_VkRef.bHeadless)
+	{
+		_DrawHeadlessFrame();
+		return;
+	}
+
 	// Rebuild swap chain if needed.
 	if (_bSwapChainNeedsRebuild)
 	{
+		PROFILE_ZONE("Rebuild SwapChain")
 		LOG_VKRESULT(vkDeviceWaitIdle(_VkRef.logDevice))
 		_SwapChain.CreateSwapChain(_VkRef);
 		_bSwapChainNeedsRebuild = false;
@@ -136,47 +302,61 @@ void RenderManager::DrawFrame()
 		return;
 	}
 
-	// Wait for given fence to signal (open) from last draw before continuing. 
-	vkWaitForFences(_VkRef.logDevice, 1, &_DrawFence[_CurrentFrame], VK_TRUE, U64_MAX);
-	// TODO: Add CPU synchronize code here to to run while waiting for GPU.
-	// Manually reset (close) fences.
-	vkResetFences(_VkRef.logDevice, 1, &_DrawFence[_CurrentFrame]);
+	// Wait until the GPU is done with this frame's context from its last time around
+	const FrameContext& frame = _BeginFrameContext();
 
-	// Get index to the next image that mSwapChainImages, mSwapChainFramebuffers, and mCommandBuffers can all sync with.
+	// Get index to the next image that mSwapChainImages and mSwapChainFramebuffers can sync with.
 	// This also tells the semaphore we provide when the next image is ready to be drawn to.
 	u32 nextImage;
-	VkResult result = vkAcquireNextImageKHR(_VkRef.logDevice, _SwapChain.GetHandle(), U64_MAX, _ImageAvailable[_CurrentFrame], VK_NULL_HANDLE, &nextImage);
+	VkResult result;
+	{
+		PROFILE_WAIT_ZONE("vkAcquireNextImageKHR")
+		result = vkAcquireNextImageKHR(_VkRef.logDevice, _SwapChain.GetHandle(), U64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &nextImage);
+	}
 	// If the window has been resized then vkAcquireNextImageKHR will return VK_ERROR_OUT_OF_DATE_KHR or VK_SUBOPTIMAL_KHR in which case the swap chain needs to be rebuilt.
-	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+	// A suboptimal image was still acquired (and will signal imageAvailable), so it's drawn and presented before the rebuild.
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
+		// Nothing gets submitted, so signal the fence again or the next wait on this frame never returns
+		const VkSubmitInfo emptySubmit = { VK_STRUCTURE_TYPE_SUBMIT_INFO };
+		LOG_VKRESULT(vkQueueSubmit(_VkRef.queues.graphics, 1, &emptySubmit, frame.drawFence))
 		_bSwapChainNeedsRebuild = true;
 		ImGuiManager::EndImguiFrame();
 		return;
 	}
+	else if (result == VK_SUBOPTIMAL_KHR)
+	{
+		_bSwapChainNeedsRebuild = true;
+	}
 	else
 	{
 		LOG_VKRESULT(result)
 	}
 
+	// A rebuilt swap chain can come back with more images
+	_CreateRenderFinishedSemaphores(_SwapChain.Size());
 
-	_RecordCommands(nextImage);
+	_RecordCommands(frame, nextImage);
 	//UpdateUniformBuffers(nextImage);		//Dynamic Buffer
 
 	// Submit command buffer to render. We specify what semaphores the render pass should wait on and where, and what semaphores should be signaled when finished.
 	VkSubmitInfo submitInfo = {};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.waitSemaphoreCount = 1;											// Number of semaphores to wait on
-	submitInfo.pWaitSemaphores = &_ImageAvailable[_CurrentFrame];				// List of semaphores to wait on
+	submitInfo.pWaitSemaphores = &frame.imageAvailable;						// List of semaphores to wait on
 	VkPipelineStageFlags waitStages[] = {										// List of stages (points in the render pass) where the render pass can freely run up to
 		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT							// before waiting on the provided wait semaphores to be changed.
 	};																			// To clarify: Render pass starts without next image being ready -> Stops at bit provided
 	submitInfo.pWaitDstStageMask = waitStages;									// in 'waitStages' -> Waits till wait semaphore in the same index changes -> repeats with next wait stage(s)/semaphore(s) until all are finished.
 	submitInfo.commandBufferCount = 1;											// Number of command buffers
-	submitInfo.pCommandBuffers = &_VkRef.graphicsCommandBuffers[nextImage];	// List of command buffers to submit
+	submitInfo.pCommandBuffers = &frame.graphicsCommandBuffer;					// List of command buffers to submit
 	submitInfo.signalSemaphoreCount = 1;										// Number of semaphores to signal when command buffer finishes.
-	submitInfo.pSignalSemaphores = &_RenderFinished[_CurrentFrame];			// List of semaphores to signal when command buffer finishes.
+	submitInfo.pSignalSemaphores = &_RenderFinished[nextImage];				// List of semaphores to signal when command buffer finishes.
 
-	LOG_VKRESULT(vkQueueSubmit(_VkRef.queues.graphics, 1, &submitInfo, _DrawFence[_CurrentFrame]))
+	{
+		PROFILE_ZONE("vkQueueSubmit")
+		LOG_VKRESULT(vkQueueSubmit(_VkRef.queues.graphics, 1, &submitInfo, frame.drawFence))
+	}
 
 	// End imgui frame updating all the windows
 	ImGuiManager::EndImguiFrame();
@@ -185,16 +365,18 @@ void RenderManager::DrawFrame()
 	VkPresentInfoKHR presentInfo = {};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 	presentInfo.waitSemaphoreCount = 1;									// Number of semaphores to wait on before presenting image to swap chain/surface
-	presentInfo.pWaitSemaphores = &_RenderFinished[_CurrentFrame];	// List of semaphores to wait on before presenting image to swap chain/surface
+	presentInfo.pWaitSemaphores = &_RenderFinished[nextImage];		// List of semaphores to wait on before presenting image to swap chain/surface
 	presentInfo.swapchainCount = 1;										// Number of swap chains/surfaces to present to 
 	presentInfo.pSwapchains = _SwapChain.GetPtr();						// List of swap chain(s)/surface(s) to present to
 	presentInfo.pImageIndices = &nextImage;								// Index(s) of image(s) in swap chain to present to surface
 
-	result = vkQueuePresentKHR(_VkRef.queues.graphics, &presentInfo);
+	{
+		PROFILE_ZONE("vkQueuePresentKHR")
+		result = vkQueuePresentKHR(_VkRef.queues.graphics, &presentInfo);
+	}
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 	{
 		_bSwapChainNeedsRebuild = true;
-		return;
 	}
 	else
 	{
@@ -202,54 +384,142 @@ void RenderManager::DrawFrame()
 	}
 
 	// Get next frame (use % numInFlightFrames to keep value below numInFlightFrames)
-	_CurrentFrame = (_CurrentFrame + 1) % _VkRef.phyDevice.numInFlightFrames;
+	_CurrentFrame = (_CurrentFrame + 1) % _VkRef.numInFlightFrames;
+}
+
+void RenderManager::_DrawHeadlessFrame()
+{
+	const FrameContext& frame = _BeginFrameContext();
+
+	// Each frame in flight owns one offscreen image, so the frame index doubles as the image index
+	_RecordCommands(frame, _CurrentFrame);
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &frame.graphicsCommandBuffer;
+
+	{
+		PROFILE_ZONE("vkQueueSubmit")
+		LOG_VKRESULT(vkQueueSubmit(_VkRef.queues.graphics, 1, &submitInfo, frame.drawFence))
+	}
+
+	_LastDrawnFrame = _CurrentFrame;
+	_CurrentFrame = (_CurrentFrame + 1) % _VkRef.numInFlightFrames;
 }
 
-void RenderManager::_RecordCommands(u32 currentImage)
+void RenderManager::SubmitDraw(ParallelRecorder::RecordDrawFn pRecord, const void* pUserData)
 {
-	// Reset The command pool
-	// vkResetCommandPool(_VkRef.logDevice, _VkRef.graphicsCommandPool, 0);
+	_PendingDraws.emplace_back(ParallelRecorder::DrawItem{ pRecord, pUserData });
+}
+
+FrameContext& RenderManager::_BeginFrameContext()
+{
+	FrameContext& frame = _VkRef.frames[_CurrentFrame];
+
+	// Wait for given fence to signal (open) from last draw before continuing.
+	{
+		PROFILE_WAIT_ZONE("vkWaitForFences")
+		vkWaitForFences(_VkRef.logDevice, 1, &frame.drawFence, VK_TRUE, U64_MAX);
+	}
+	// Manually reset (close) fences.
+	vkResetFences(_VkRef.logDevice, 1, &frame.drawFence);
+
+	// GPU is done with everything this frame used last time around, so its pools and arena block can be reused whole
+	LOG_VKRESULT(vkResetCommandPool(_VkRef.logDevice, frame.graphicsCommandPool, 0))
+	LOG_VKRESULT(vkResetCommandPool(_VkRef.logDevice, frame.computeCommandPool, 0))
+	if (frame.transferCommandPool != VK_NULL_HANDLE)
+	{
+		LOG_VKRESULT(vkResetCommandPool(_VkRef.logDevice, frame.transferCommandPool, 0))
+	}
+	for (VkCommandPool pool : frame.secondaryCommandPools)
+	{
+		LOG_VKRESULT(vkResetCommandPool(_VkRef.logDevice, pool, 0))
+	}
+	FrameArena::BeginFrame(_CurrentFrame);
+
+	return frame;
+}
+
+void RenderManager::_RecordCommands(const FrameContext& frame, u32 currentImage)
+{
+	PROFILE_ZONE("RenderManager::_RecordCommands")
+
+	const VkCommandBuffer cmdBuffer = frame.graphicsCommandBuffer;
 
 	// Info about how to begin each command buffer
 	VkCommandBufferBeginInfo commandBufferBeginInfo = { VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
 	commandBufferBeginInfo.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
 	// Start recording commands to command buffer
-	vkBeginCommandBuffer(_VkRef.graphicsCommandBuffers[currentImage], &commandBufferBeginInfo);
+	vkBeginCommandBuffer(cmdBuffer, &commandBufferBeginInfo);
 
-	// Allow imgui to submit any commands it needs to
-	ImGuiManager::SubmitImGuiVulkanCommands(_VkRef.graphicsCommandBuffers[currentImage], currentImage);
+	// Read back this frame slot's GPU timestamps from its last use and reset its queries
+	GpuProfiler::BeginFrame(cmdBuffer, _CurrentFrame);
+	{
+		GPU_PROFILE_ZONE(cmdBuffer, "GPU Frame")
+
+		if (_VkRef.bHeadless)
+		{
+			GPU_PROFILE_ZONE(cmdBuffer, "Offscreen Pass")
+			_RecordPass(frame, cmdBuffer, _OffscreenTarget.GetRenderPass(), _OffscreenTarget.GetFrameBuffer(currentImage),
+				[cmdBuffer, currentImage](VkSubpassContents contents) { _OffscreenTarget.BeginRenderPass(cmdBuffer, currentImage, contents); });
+		}
+		else if (_FrameDraws.empty() || ImGuiManager::GetImGuiRenderPass() == VK_NULL_HANDLE)
+		{
+			// Allow imgui to submit any commands it needs to
+			GPU_PROFILE_ZONE(cmdBuffer, "ImGui Pass")
+			ImGuiManager::SubmitImGuiVulkanCommands(cmdBuffer, currentImage);
+		}
+		else
+		{
+			// A pass can't mix inline and secondary contents, so ImGui goes last in the draw list to stay on top
+			GPU_PROFILE_ZONE(cmdBuffer, "ImGui Pass")
+			_FrameDraws.emplace_back(ParallelRecorder::DrawItem{ [](VkCommandBuffer drawCmdBuffer, const void*) { ImGuiManager::RecordImGuiDrawData(drawCmdBuffer); } });
+			_RecordPass(frame, cmdBuffer, ImGuiManager::GetImGuiRenderPass(), ImGuiManager::GetImGuiFrameBuffer(currentImage),
+				[cmdBuffer, currentImage](VkSubpassContents contents) { ImGuiManager::BeginImGuiRenderPass(cmdBuffer, currentImage, contents); });
+		}
+	}
 
 	// Stop recording commands to command buffer
-	vkEndCommandBuffer(_VkRef.graphicsCommandBuffers[currentImage]);
+	vkEndCommandBuffer(cmdBuffer);
 }
 
-void RenderManager::_CreateSemaphoresAndFences()
+void RenderManager::_RecordPass(const FrameContext& frame, VkCommandBuffer cmdBuffer, VkRenderPass renderPass, VkFramebuffer frameBuffer,
+	const std::function<void(VkSubpassContents)>& beginPass)
 {
-	LOG_DEBUG("Creating Semaphores And Fences...")
+	if (_FrameDraws.empty())
+	{
+		beginPass(VK_SUBPASS_CONTENTS_INLINE);
+		vkCmdEndRenderPass(cmdBuffer);
+		return;
+	}
+
+	const std::span<const VkCommandBuffer> secondaryCmdBuffers = ParallelRecorder::RecordDraws(frame, renderPass, frameBuffer, _FrameDraws);
 
-	//Allocate semaphore and fence vector sizes
-	_ImageAvailable.resize(_VkRef.phyDevice.numInFlightFrames);
-	_RenderFinished.resize(_VkRef.phyDevice.numInFlightFrames);
-	_DrawFence.resize(_VkRef.phyDevice.numInFlightFrames);
+	beginPass(VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+	vkCmdExecuteCommands(cmdBuffer, static_cast<u32>(secondaryCmdBuffers.size()), secondaryCmdBuffers.data());
+	vkCmdEndRenderPass(cmdBuffer);
+}
 
-	// Semaphore Creation info
+void RenderManager::_CreateRenderFinishedSemaphores(u64 imageCount)
+{
 	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
 	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	// Fence Creation info
-	VkFenceCreateInfo fenceCreateInfo = {};
-	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;			// Default fence to be opened to avoid start of app hang.
-
-	for (u32 i = 0; i < _VkRef.phyDevice.numInFlightFrames; i++)
+	while (_RenderFinished.size() < imageCount)
 	{
-		LOG_VKRESULT(vkCreateSemaphore(_VkRef.logDevice, &semaphoreCreateInfo, &_VkRef.hostAllocator, &_ImageAvailable[i]))
-		LOG_VKRESULT(vkCreateSemaphore(_VkRef.logDevice, &semaphoreCreateInfo, &_VkRef.hostAllocator, &_RenderFinished[i]))
-		LOG_VKRESULT(vkCreateFence(_VkRef.logDevice, &fenceCreateInfo, &_VkRef.hostAllocator, &_DrawFence[i]))
+		LOG_VKRESULT(vkCreateSemaphore(_VkRef.logDevice, &semaphoreCreateInfo, &_VkRef.hostAllocator, &_RenderFinished.emplace_back()))
 	}
-
-	LOG_INFO("Semaphores And Fences Created")
 }
 
-
+void RenderManager::_SetWindowSizeLimits()
+{
+    #if LAYER_PLATFORM_ANDROID
+        // TODO: Create Android implementation
+    #else // GLFW
+		const int maxWidth = static_cast<int>(_VkRef.phyDevice.properties.limits.maxFramebufferWidth);
+		const int maxHeight = static_cast<int>(_VkRef.phyDevice.properties.limits.maxFramebufferHeight);
+		glfwSetWindowSizeLimits(_VkRef.pWindow, Viewport::minWindowWidth, Viewport::minWindowHeight, maxWidth, maxHeight);
+    #endif
+}
@@ -233,12 +233,13 @@ void RenderPass::CreateFrameBuffers(const VkRef& vkRef, const SwapChain& swapCha
 	// Create framebuffer for each swap chain image and each render pass attachment 
 
 	const VkExtent2D swapChainExtent = swapChain.Extent();
+	const SwapChainImageList& swapChainImages = swapChain.GetImages();
 
 	for (size_t i = 0; i < m_FrameBuffers.size(); i++)
 	{
 		// Add attachments made in the render pass in the same order
 		std::array<VkImageView, 3> attachments = {
-			swapChain.GetImages()[i].imageView,
+			swapChainImages[i].imageView,
 			m_ColorImages[i].imageView,
 			m_DepthImages[i].imageView
 		};
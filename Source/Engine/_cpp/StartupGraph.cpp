@@ -0,0 +1,241 @@
+#include "StartupGraph.h"
+#include "Logger.h"
+#include "MemoryTracker.h"
+
+
+namespace StartupGraph
+{
+	struct _Stage
+	{
+		const char* name = "";
+		std::function<void()> work = {};
+		T_small_vector<StageHandle, 4, MT_ENGINE> dependents = {};
+		u32 remainingDependencies = 0;
+		MemoryTrackerTag tag = MT_UNKNOWN;
+		bool bMainThread = false;
+	};
+
+	struct _StageRecord
+	{
+		const char* name = "";
+		u64 begin = 0;
+		u64 end = 0;
+		u32 thread = 0;			// 0 is the main thread, then workers from 1
+	};
+
+	// Stages waiting for the next Run(), only touched from the main thread outside of Run()
+	T_vector<_Stage, MT_ENGINE> _stages = {};
+
+	// Run() state, guarded by _mutex
+	std::mutex _mutex;
+	std::condition_variable _stageReady;
+	T_vector<StageHandle, MT_ENGINE> _readyMainStages = {};
+	T_vector<StageHandle, MT_ENGINE> _readyWorkerStages = {};
+	u64 _numFinishedStages = 0;
+
+	// Timed stages since the last LogBreakdown(), guarded by _recordsMutex
+	std::mutex _recordsMutex;
+	T_vector<_StageRecord, MT_ENGINE> _records = {};
+
+	// Index of the calling thread in the breakdown, set by each worker
+	thread_local u32 _threadIndex = 0;
+
+	StageHandle _AddStage(const char* name, std::function<void()>&& work, std::initializer_list<StageHandle> dependencies, bool bMainThread);
+
+	// Times and runs a stage on the calling thread
+	void _RunStage(StageHandle handle);
+
+	// Marks a stage done and queues the dependents it was the last dependency of, _mutex must be held
+	void _FinishStage(StageHandle handle);
+
+	// Worker thread loop, exits once every stage has finished
+	void _WorkerMain(u32 threadIndex);
+}
+
+StartupGraph::StageHandle StartupGraph::AddStage(const char* name, std::function<void()> work, std::initializer_list<StageHandle> dependencies)
+{
+	return _AddStage(name, std::move(work), dependencies, false);
+}
+
+StartupGraph::StageHandle StartupGraph::AddMainThreadStage(const char* name, std::function<void()> work, std::initializer_list<StageHandle> dependencies)
+{
+	return _AddStage(name, std::move(work), dependencies, true);
+}
+
+StartupGraph::StageHandle StartupGraph::_AddStage(const char* name, std::function<void()>&& work, std::initializer_list<StageHandle> dependencies, bool bMainThread)
+{
+	const StageHandle handle = static_cast<StageHandle>(_stages.size());
+
+	_Stage& stage = _stages.emplace_back();
+	stage.name = name;
+	stage.work = std::move(work);
+	stage.bMainThread = bMainThread;
+	#ifdef LAYER_USE_MEMORY_TRACKING
+		stage.tag = MemoryTracker::currentThreadTag;
+	#endif
+
+	// Dependencies can only be stages that already exist, so the graph can't have cycles
+	for (StageHandle dependency : dependencies)
+	{
+		if (dependency == noStage) { continue; }
+		if (dependency >= handle)
+		{
+			LOG_ERROR(T_string("Startup stage \"", name, "\" depends on a stage that doesn't exist, ignoring the dependency"))
+			continue;
+		}
+		_stages[dependency].dependents.emplace_back(handle);
+		stage.remainingDependencies++;
+	}
+
+	return handle;
+}
+
+void StartupGraph::Run()
+{
+	if (_stages.empty()) { return; }
+	PROFILE_ZONE("StartupGraph::Run")
+
+	u32 numWorkerStages = 0;
+	for (StageHandle i = 0; i < _stages.size(); i++)
+	{
+		numWorkerStages += _stages[i].bMainThread ? 0 : 1;
+		if (_stages[i].remainingDependencies == 0)
+		{
+			(_stages[i].bMainThread ? _readyMainStages : _readyWorkerStages).emplace_back(i);
+		}
+	}
+	_numFinishedStages = 0;
+
+	// No spare cores (or no worker stages) and the main thread runs everything itself
+	const u32 spareCores = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	const u32 numWorkers = std::min({ numWorkerStages, spareCores, maxWorkerThreads });
+
+	T_small_vector<std::thread, maxWorkerThreads, MT_ENGINE> workers;
+	for (u32 i = 0; i < numWorkers; i++)
+	{
+		workers.emplace_back(_WorkerMain, i + 1);
+	}
+
+	{
+		std::unique_lock lock(_mutex);
+		while (true)
+		{
+			_stageReady.wait(lock, [numWorkers]()
+			{
+				return !_readyMainStages.empty() || (numWorkers == 0 && !_readyWorkerStages.empty()) || _numFinishedStages == _stages.size();
+			});
+			if (_numFinishedStages == _stages.size()) { break; }
+
+			T_vector<StageHandle, MT_ENGINE>& readyStages = _readyMainStages.empty() ? _readyWorkerStages : _readyMainStages;
+			const StageHandle handle = readyStages.back();
+			readyStages.pop_back();
+
+			lock.unlock();
+			_RunStage(handle);
+			lock.lock();
+			_FinishStage(handle);
+		}
+	}
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+	_stages.clear();
+}
+
+void StartupGraph::RecordStage(const char* name, u64 begin, u64 end)
+{
+	std::lock_guard lock(_recordsMutex);
+	_records.emplace_back(_StageRecord{ name, begin, end, _threadIndex });
+}
+
+void StartupGraph::LogBreakdown()
+{
+	std::lock_guard lock(_recordsMutex);
+	if (_records.empty()) { return; }
+
+	std::sort(_records.begin(), _records.end(), [](const _StageRecord& a, const _StageRecord& b) { return a.begin < b.begin; });
+
+	u64 startupBegin = U64_MAX;
+	u64 startupEnd = 0;
+	u64 stageTime = 0;
+	for (const _StageRecord& record : _records)
+	{
+		startupBegin = std::min(startupBegin, record.begin);
+		startupEnd = std::max(startupEnd, record.end);
+		stageTime += record.end - record.begin;
+	}
+
+	constexpr f64 nsToMs = 1.0 / 1'000'000.0;
+	const f64 wallTime = static_cast<f64>(startupEnd - startupBegin) * nsToMs;
+
+	Logger::AddToSessionLogFile("------- STARTUP STAGES (Start | Duration | Thread) -------");
+	for (const _StageRecord& record : _records)
+	{
+		char thread[16] = "Main";
+		if (record.thread != 0)
+		{
+			snprintf(thread, sizeof(thread), "Worker %u", record.thread);
+		}
+
+		char line[160];
+		snprintf(line, sizeof(line), "%-32s %9.2f ms | %9.2f ms | %s", record.name, static_cast<f64>(record.begin - startupBegin) * nsToMs,
+			static_cast<f64>(record.end - record.begin) * nsToMs, thread);
+		Logger::AddToSessionLogFile(line);
+	}
+
+	// Stage time over wall time is how much of startup ran in parallel
+	LOG_BENCHMARK_FMT("Startup took {} ms | {} ms of stages, {}x overlap", wallTime, static_cast<f64>(stageTime) * nsToMs,
+		wallTime > 0.0 ? static_cast<f64>(stageTime) * nsToMs / wallTime : 1.0)
+
+	_records.clear();
+}
+
+void StartupGraph::_RunStage(StageHandle handle)
+{
+	const _Stage& stage = _stages[handle];
+	MEMORY_TAG_SCOPE(stage.tag)
+
+	const u64 begin = Profiler::Now();
+	{
+		PROFILE_ZONE(stage.name)
+		stage.work();
+	}
+	RecordStage(stage.name, begin, Profiler::Now());
+}
+
+void StartupGraph::_FinishStage(StageHandle handle)
+{
+	_numFinishedStages++;
+	for (StageHandle dependent : _stages[handle].dependents)
+	{
+		_Stage& stage = _stages[dependent];
+		if (--stage.remainingDependencies == 0)
+		{
+			(stage.bMainThread ? _readyMainStages : _readyWorkerStages).emplace_back(dependent);
+		}
+	}
+	_stageReady.notify_all();
+}
+
+void StartupGraph::_WorkerMain(u32 threadIndex)
+{
+	_threadIndex = threadIndex;
+	Profiler::SetThreadName("Startup Worker");
+
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		_stageReady.wait(lock, []() { return !_readyWorkerStages.empty() || _numFinishedStages == _stages.size(); });
+		if (_numFinishedStages == _stages.size()) { return; }
+
+		const StageHandle handle = _readyWorkerStages.back();
+		_readyWorkerStages.pop_back();
+
+		lock.unlock();
+		_RunStage(handle);
+		lock.lock();
+		_FinishStage(handle);
+	}
+}
@@ -3,6 +3,7 @@
 #include "VkBuffersAndImages.h"
 #include "Logger.h"
 #include "ImGuiManager.h"
+#include "Profiler.h"
 
 
 void SwapChain::CreateInitialSwapChain(VkRef& vkRef)
@@ -23,6 +24,8 @@ void SwapChain::CreateInitialSwapChain(VkRef& vkRef)
 
 void SwapChain::CreateSwapChain(VkRef& vkRef)
 {
+	PROFILE_ZONE("SwapChain::CreateSwapChain")
+
 	// Set the new extent based on the window
 	m_SwapChainExtent = ChooseImageExtent(vkRef);
 	//LOG_DEBUG(T_string("New SwapChain Extent- X: ", std::to_string(m_SwapChainExtent.width), " | Y: ", std::to_string(m_SwapChainExtent.height)));
@@ -85,7 +88,7 @@ void SwapChain::CreateSwapChain(VkRef& vkRef)
 	// Get swap chain images and copy over to our local class.
 	uint32_t swapChainImageCount;
 	vkGetSwapchainImagesKHR(vkRef.logDevice, m_SwapChain, &swapChainImageCount, nullptr);
-	T_vector<VkImage> images(swapChainImageCount);
+	T_small_vector<VkImage, VkConfig::inlineSwapChainImages> images(swapChainImageCount);
 	vkGetSwapchainImagesKHR(vkRef.logDevice, m_SwapChain, &swapChainImageCount, images.data());
 
 	if (oldSwapchain != VK_NULL_HANDLE)
@@ -148,11 +151,6 @@ u64 SwapChain::Size() const
     return m_SwapChainImages.size();
 }
 
-T_vector<SwapChainImage, MT_GRAPHICS> SwapChain::GetImages() const
-{
-    return m_SwapChainImages;
-}
-
 VkExtent2D SwapChain::ChooseImageExtent(VkRef& vkRef)
 {
 	// Make it more readable
@@ -10,10 +10,6 @@ LayerTimer::LayerTimer(const char* label)
 
 LayerTimer::~LayerTimer()
 {
-	char msgBuffer[U8_MAX];
 	const std::chrono::duration<float, std::milli> duration = std::chrono::steady_clock::now() - m_Begin;
-
-	snprintf(msgBuffer, U8_MAX - 1, "Duration Of Timer \"%s\": %f ms", m_Label, duration.count());
-
-	LOG_BENCHMARK(msgBuffer)
+	LOG_BENCHMARK_FMT("Duration Of Timer \"{}\": {} ms", m_Label, duration.count())
 }
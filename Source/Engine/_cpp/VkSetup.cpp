@@ -1,10 +1,10 @@
  #include "VkSetup.h"
 #include "LayerContainers.h"
 #include "VkConfig.h"
-#include "Viewport.h"
 #include "VkTypes.h"
 #include "Logger.h"
 #include "LoggingCallbacks.h"
+#include "FileHelper.h"
 #include "vk_enum_string_helper.h"
 
 
@@ -16,16 +16,82 @@ namespace VkSetup
 	// INITIALIZE HELPERS
 
 	// -CreateInstance Helpers
-	T_vector<const char*> _GetRequiredInstanceExtensions();
-	bool _CheckInstanceExtensionSupport(const T_vector<const char*>& checkExtensions);
+	T_small_vector<const char*, 8> _GetRequiredInstanceExtensions(bool bHeadless);
+	bool _CheckInstanceExtensionSupport(const T_small_vector<const char*, 8>& checkExtensions);
 
 	// -CapturePhysicalDevice Helpers
+	// A VK_NULL_HANDLE surface means headless, present support and swap chain details aren't checked
 	bool _CheckPhysicalDeviceIsSuitableAndBuildReference(VkPhysicalDevice phyDevice, VkSurfaceKHR surface, PhysicalDevice& phyDeviceReference);
 	bool _CheckPhysicalDeviceSupportsDesiredFeatures(PhysicalDevice& phyDeviceReference);
-	bool _CheckPhysicalDeviceSupportsDesiredExtensions(PhysicalDevice& phyDeviceReference);
+	bool _CheckPhysicalDeviceSupportsDesiredExtensions(PhysicalDevice& phyDeviceReference, bool bHeadless);
 	bool _CheckQueueFamiliesAreSuitableAndSetRef(PhysicalDevice& phyDeviceReference, VkSurfaceKHR surface);
 	bool _CheckAndSetSwapChainDetails(PhysicalDevice& phyDeviceReference, VkSurfaceKHR surface);
 	bool _CheckAndSetAttachmentFormats(PhysicalDevice& phyDeviceReference);
+
+	// Device extensions to check for/enable, the swap chain ones are left out when headless
+	T_small_vector<const char*, 8> _GetDesiredDeviceExtensions(bool bHeadless);
+
+	// -Physical Device Cache
+	// Path relative to the current working directory
+	constexpr const char* _physicalDeviceCachePath = "Cache\\PhysicalDevice.bin";
+	constexpr u32 _physicalDeviceCacheVersion = 2;
+
+	// What the full probe found for the chosen device, followed by numSurfaceFormats VkSurfaceFormatKHRs and numPresentModes
+	// VkPresentModeKHRs. Properties/features aren't stored, they come back from the driver in one call each.
+	struct _PhysicalDeviceCache
+	{
+		std::array<char, 4> magic = { 'L', 'P', 'D', 'C' };
+		u32 version = _physicalDeviceCacheVersion;
+
+		// Key, any change and the probe runs again
+		u64 configHash = 0;									// VkConfig's desired features/extensions/formats
+		u64 deviceSetHash = 0;								// Every enumerated device's UUID/driver, a new GPU could change the pick
+		std::array<u8, VK_UUID_SIZE> deviceUUID = {};
+		u32 driverVersion = 0;
+		u32 bHeadless = 0;
+
+		i32 presentQueueIndex = -1;
+		i32 graphicsQueueIndex = -1;
+		i32 computeQueueIndex = -1;
+		i32 transferQueueIndex = -1;
+		u32 bHasTransferQueue = 0;
+
+		VkSurfaceFormatKHR preferredSurfaceFormat = {};
+		VkPresentModeKHR preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR;
+		u32 swapChainBufferCount = 0;
+		u32 bSupportsMailboxMode = 0;
+
+		VkFormat preferred32BitPackColorAttachmentFormat = VK_FORMAT_UNDEFINED;
+		VkFormat preferredDepthStencilAttachmentFormat = VK_FORMAT_UNDEFINED;
+		u32 bSupports16BitPackColorAttachment = 0;
+		VkFormat preferred16BitPackColorAttachmentFormat = VK_FORMAT_UNDEFINED;
+		u32 bSupports10BitColorAttachment = 0;
+		VkFormat preferred10BitColorAttachmentFormat = VK_FORMAT_UNDEFINED;
+
+		u32 numSurfaceFormats = 0;
+		u32 numPresentModes = 0;
+	};
+
+	// Cache key parts that don't depend on the chosen device
+	struct _PhysicalDeviceCacheKey
+	{
+		u64 configHash = 0;
+		u64 deviceSetHash = 0;
+		T_small_vector<std::array<u8, VK_UUID_SIZE>, 4, MT_GRAPHICS> deviceUUIDs = {};		// Same order as the enumerated devices
+	};
+
+	_PhysicalDeviceCacheKey _BuildPhysicalDeviceCacheKey(const T_small_vector<VkPhysicalDevice, 4>& physicalDevices, bool bHeadless);
+
+	// Fills vkRef.phyDevice from the cache if its key still matches, re-querying only the surface capabilities/present support.
+	// False means a full probe is needed.
+	bool _LoadCachedPhysicalDevice(VkRef& vkRef, const T_small_vector<VkPhysicalDevice, 4>& physicalDevices, const _PhysicalDeviceCacheKey& key);
+	void _SavePhysicalDeviceCache(const PhysicalDevice& phyDevice, const _PhysicalDeviceCacheKey& key, u32 deviceIndex, bool bHeadless);
+
+	// VkPhysicalDeviceIDProperties::deviceUUID, or the pipeline cache UUID on a Vulkan 1.0 device
+	std::array<u8, VK_UUID_SIZE> _GetDeviceUUID(VkPhysicalDevice phyDevice);
+
+	// FNV-1a, seeded with the previous hash to chain several buffers
+	u64 _HashBytes(const void* pData, u64 size, u64 hash = 14695981039346656037ull);
  
 	template<size_t S>
 	VkFormat _ChooseSupportedAttachmentFormat([[maybe_unused]] const PhysicalDevice& phyDeviceReference, [[maybe_unused]] const std::array<VkFormat, S>& formats, [[maybe_unused]] VkImageTiling tiling, [[maybe_unused]] VkFormatFeatureFlags featureFlags);
@@ -67,7 +133,7 @@ void VkSetup::CreateInstance(const char* appName, VkRef& vkRef)
 	instanceCreateInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 	instanceCreateInfo.pApplicationInfo = &appInfo;
 
-	T_vector<const char*> extensions = _GetRequiredInstanceExtensions();
+	T_small_vector<const char*, 8> extensions = _GetRequiredInstanceExtensions(vkRef.bHeadless);
 
 	LOG_FATAL_IF(!_CheckInstanceExtensionSupport(extensions),
                  "Required Vulkan Instance Extensions Are Not Available!")
@@ -119,9 +185,17 @@ void VkSetup::CapturePhysicalDevice(VkRef& vkRef)
 		"No Vulkan Compatible Physical Device Found!")
 
 	// Create an Array with the correct size then populate it with the available devices.
-	T_vector<VkPhysicalDevice> physicalDevicesAvailable(physicalDeviceCount);
+	T_small_vector<VkPhysicalDevice, 4> physicalDevicesAvailable(physicalDeviceCount);
 	LOG_VKRESULT(vkEnumeratePhysicalDevices(vkRef.instance, &physicalDeviceCount, physicalDevicesAvailable.data()))
 
+	// Skip the probe when this machine's devices, drivers and our requirements haven't changed since it last ran
+	const _PhysicalDeviceCacheKey cacheKey = _BuildPhysicalDeviceCacheKey(physicalDevicesAvailable, vkRef.bHeadless);
+	if (_LoadCachedPhysicalDevice(vkRef, physicalDevicesAvailable, cacheKey))
+	{
+		LOG_INFO_FMT("Captured Vulkan Physical Device: {} (cached probe)", vkRef.phyDevice.properties.deviceName)
+		return;
+	}
+
 	// Capture Suitable Devices and create references to them
 	for (const auto& physicalDevice : physicalDevicesAvailable)
 	{
@@ -129,7 +203,7 @@ void VkSetup::CapturePhysicalDevice(VkRef& vkRef)
 
 		if (_CheckPhysicalDeviceIsSuitableAndBuildReference(physicalDevice, vkRef.surface, physicalDeviceRef))
 		{
-			LOG_INFO(T_string("Suitable Vulkan Physical Device Available: ", physicalDeviceRef.properties.deviceName))
+			LOG_INFO_FMT("Suitable Vulkan Physical Device Available: {}", physicalDeviceRef.properties.deviceName)
 			_availablePhysicalDevices.emplace_back(physicalDeviceRef);
 		}
 	}
@@ -149,17 +223,17 @@ void VkSetup::CapturePhysicalDevice(VkRef& vkRef)
 	}
 
 	vkRef.phyDevice = _availablePhysicalDevices[suitableDevice];
-    
-    #if LAYER_PLATFORM_ANDROID
-        // TODO: Create Android implementation
-    #else // GLFW
-        // Set window limits based off what the hardware can support
-        const int maxWidth = static_cast<int>(vkRef.phyDevice.properties.limits.maxFramebufferWidth);
-        const int maxHeight = static_cast<int>(vkRef.phyDevice.properties.limits.maxFramebufferHeight);
-        glfwSetWindowSizeLimits(vkRef.pWindow, Viewport::minWindowWidth, Viewport::minWindowHeight, maxWidth, maxHeight);
-    #endif
 
-	LOG_INFO(T_string("Captured Vulkan Physical Device: ", vkRef.phyDevice.properties.deviceName))
+	for (u32 i = 0; i < physicalDevicesAvailable.size(); i++)
+	{
+		if (physicalDevicesAvailable[i] == vkRef.phyDevice.handle)
+		{
+			_SavePhysicalDeviceCache(vkRef.phyDevice, cacheKey, i, vkRef.bHeadless);
+			break;
+		}
+	}
+    
+	LOG_INFO_FMT("Captured Vulkan Physical Device: {}", vkRef.phyDevice.properties.deviceName)
 }
 
 void VkSetup::CreateLogicalDevice(VkRef& vkRef)
@@ -176,7 +250,7 @@ void VkSetup::CreateLogicalDevice(VkRef& vkRef)
 	{
 		queueFamilyIndices.emplace(vkRef.phyDevice.transferQueueIndex);
 	}
-	T_vector<VkDeviceQueueCreateInfo> queueCreateInfos;
+	T_small_vector<VkDeviceQueueCreateInfo, 4> queueCreateInfos;
 
 	// List of queues the logical device needs to create and the info to do so, pushed into a vector to be used by deviceCreateInfo
 	for (i32 queueFamilyIndex : queueFamilyIndices)
@@ -191,13 +265,15 @@ void VkSetup::CreateLogicalDevice(VkRef& vkRef)
 		queueCreateInfos.emplace_back(queueCreateInfo);
 	}
 
+	const T_small_vector<const char*, 8> deviceExtensions = _GetDesiredDeviceExtensions(vkRef.bHeadless);
+
 	// Info to create logical device (also called "device")
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.queueCreateInfoCount = static_cast<u32>(queueCreateInfos.size());						// Number of Queue create infos
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();											// List of queue create infos
-	deviceCreateInfo.enabledExtensionCount = static_cast<u32>(VkConfig::desiredDeviceExtensions.size());	// Number of logical device extensions (different from Instance extensions)
-	deviceCreateInfo.ppEnabledExtensionNames = VkConfig::desiredDeviceExtensions.data();					// List of enabled logical device extensions (if any)
+	deviceCreateInfo.enabledExtensionCount = static_cast<u32>(deviceExtensions.size());						// Number of logical device extensions (different from Instance extensions)
+	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();										// List of enabled logical device extensions (if any)
 	deviceCreateInfo.pEnabledFeatures = &VkConfig::desiredDeviceFeatures;									// Features That Should Be Enabled
 
 	// Create the logical device for the given physical device
@@ -246,7 +322,7 @@ void VkSetup::CreateCommandPools(VkRef& vkRef)
 {
 	LOG_DEBUG("Creating Command Pools...")
 
-	// Graphics Command Pool
+	// Graphics Command Pool for one off/long lived buffers, per frame pools are made by CreateFrameContexts()
 	VkCommandPoolCreateInfo graphicsCommandPoolCreateInfo = {};
 	graphicsCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	graphicsCommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// Sets command buffers to implicitly reset whenever vkBeginCommandBuffer is called on that buffer
@@ -254,86 +330,100 @@ void VkSetup::CreateCommandPools(VkRef& vkRef)
 
 	LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &graphicsCommandPoolCreateInfo, &vkRef.hostAllocator, &vkRef.graphicsCommandPool))
 
-	// Compute Command Pool
-	VkCommandPoolCreateInfo computeCommandPoolCreateInfo = {};
-	computeCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-	computeCommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// Sets command buffers to implicitly reset whenever vkBeginCommandBuffer is called on that buffer
-	computeCommandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.computeQueueIndex;
-
-	LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &computeCommandPoolCreateInfo, &vkRef.hostAllocator, &vkRef.computeCommandPool))
-
-	// Transfer Command Pool
-	if (vkRef.phyDevice.bHasTransferQueue)
-	{
-		VkCommandPoolCreateInfo transferCommandPoolCreateInfo = {};
-		transferCommandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		transferCommandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;	// Sets command buffers to implicitly reset whenever vkBeginCommandBuffer is called on that buffer
-		transferCommandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.transferQueueIndex;
-
-		vkRef.bHasTransferCommandBuffer = true;
-
-		LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &transferCommandPoolCreateInfo, &vkRef.hostAllocator, &vkRef.transferCommandPool))
-	}
+	vkRef.bHasTransferCommandBuffer = vkRef.phyDevice.bHasTransferQueue;
 
 	LOG_INFO("Command Pools Created")
 }
 
-void VkSetup::AllocateCommandBuffers(VkRef& vkRef)
+void VkSetup::CreateFrameContexts(VkRef& vkRef)
 {
-	LOG_DEBUG("Allocating Command Buffers...")
+	LOG_DEBUG("Creating Frame Contexts...")
 
-	// Set sizes
-	vkRef.graphicsCommandBuffers.resize(vkRef.phyDevice.swapChainBufferCount);
-	vkRef.computeCommandBuffers.resize(vkRef.phyDevice.swapChainBufferCount);
-	if(vkRef.bHasTransferCommandBuffer)
-		vkRef.transferCommandBuffers.resize(vkRef.phyDevice.swapChainBufferCount);
+	vkRef.frames.resize(vkRef.numInFlightFrames);
 
-	// Graphics Command Buffers
-	VkCommandBufferAllocateInfo graphicsCommandBufferAllocateInfo = {};
-	graphicsCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	graphicsCommandBufferAllocateInfo.commandPool = vkRef.graphicsCommandPool;
-	graphicsCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;	// VK_COMMAND_BUFFER_LEVEL_PRIMARY	:	Buffer you submit directly from the queue. Can't be called by other buffers.
-																				// VK_COMMAND_BUFFER_LEVEL_SECONDARY	:	Buffer can't be called directly. Can be called from other buffers via "vkCmdExecuteCommands" when recording commands in primary buffer.
-	graphicsCommandBufferAllocateInfo.commandBufferCount = static_cast<u32>(vkRef.graphicsCommandBuffers.size());
+	// Per frame pools are only ever reset whole with vkResetCommandPool, so no per buffer reset flag
+	VkCommandPoolCreateInfo commandPoolCreateInfo = {};
+	commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;		// Buffers are re-recorded every time the frame comes around
 
-	LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &graphicsCommandBufferAllocateInfo, vkRef.graphicsCommandBuffers.data()))
+	VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+	commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;	// VK_COMMAND_BUFFER_LEVEL_PRIMARY	:	Buffer you submit directly from the queue. Can't be called by other buffers.
+																		// VK_COMMAND_BUFFER_LEVEL_SECONDARY	:	Buffer can't be called directly. Can be called from other buffers via "vkCmdExecuteCommands" when recording commands in primary buffer.
+	commandBufferAllocateInfo.commandBufferCount = 1;
 
-	// Compute Command Buffers
-	VkCommandBufferAllocateInfo computeCommandBufferAllocateInfo = {};
-	computeCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-	computeCommandBufferAllocateInfo.commandPool = vkRef.computeCommandPool;
-	computeCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	computeCommandBufferAllocateInfo.commandBufferCount = static_cast<u32>(vkRef.computeCommandBuffers.size());
+	// Semaphore Creation info
+	VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+	semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &computeCommandBufferAllocateInfo, vkRef.computeCommandBuffers.data()))
+	// Fence Creation info
+	VkFenceCreateInfo fenceCreateInfo = {};
+	fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;			// Default fence to be opened to avoid start of app hang.
 
-	// Transfer Command Buffers
-	if (vkRef.bHasTransferCommandBuffer)
+	for (FrameContext& frame : vkRef.frames)
 	{
-		VkCommandBufferAllocateInfo transferCommandBufferAllocateInfo = {};
-		transferCommandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		transferCommandBufferAllocateInfo.commandPool = vkRef.transferCommandPool;
-		transferCommandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		transferCommandBufferAllocateInfo.commandBufferCount = static_cast<u32>(vkRef.transferCommandBuffers.size());
+		// Graphics
+		commandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.graphicsQueueIndex;
+		LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &commandPoolCreateInfo, &vkRef.hostAllocator, &frame.graphicsCommandPool))
+		commandBufferAllocateInfo.commandPool = frame.graphicsCommandPool;
+		LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &commandBufferAllocateInfo, &frame.graphicsCommandBuffer))
+
+		// Compute
+		commandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.computeQueueIndex;
+		LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &commandPoolCreateInfo, &vkRef.hostAllocator, &frame.computeCommandPool))
+		commandBufferAllocateInfo.commandPool = frame.computeCommandPool;
+		LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &commandBufferAllocateInfo, &frame.computeCommandBuffer))
+
+		// Transfer
+		if (vkRef.bHasTransferCommandBuffer)
+		{
+			commandPoolCreateInfo.queueFamilyIndex = vkRef.phyDevice.transferQueueIndex;
+			LOG_VKRESULT(vkCreateCommandPool(vkRef.logDevice, &commandPoolCreateInfo, &vkRef.hostAllocator, &frame.transferCommandPool))
+			commandBufferAllocateInfo.commandPool = frame.transferCommandPool;
+			LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &commandBufferAllocateInfo, &frame.transferCommandBuffer))
+		}
 
-		LOG_VKRESULT(vkAllocateCommandBuffers(vkRef.logDevice, &transferCommandBufferAllocateInfo, vkRef.transferCommandBuffers.data()))
+		LOG_VKRESULT(vkCreateSemaphore(vkRef.logDevice, &semaphoreCreateInfo, &vkRef.hostAllocator, &frame.imageAvailable))
+		LOG_VKRESULT(vkCreateFence(vkRef.logDevice, &fenceCreateInfo, &vkRef.hostAllocator, &frame.drawFence))
 	}
 
-	LOG_INFO("Command Buffers Allocated")
+	LOG_INFO_FMT("Frame Contexts Created | Frames In Flight: {}", vkRef.numInFlightFrames)
 }
 
-T_vector<const char*> VkSetup::_GetRequiredInstanceExtensions()
+void VkSetup::DestroyFrameContexts(VkRef& vkRef)
+{
+	// Destroying a pool frees its command buffers
+	for (FrameContext& frame : vkRef.frames)
+	{
+		vkDestroyFence(vkRef.logDevice, frame.drawFence, &vkRef.hostAllocator);
+		vkDestroySemaphore(vkRef.logDevice, frame.imageAvailable, &vkRef.hostAllocator);
+		if (frame.transferCommandPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(vkRef.logDevice, frame.transferCommandPool, &vkRef.hostAllocator);
+		}
+		vkDestroyCommandPool(vkRef.logDevice, frame.computeCommandPool, &vkRef.hostAllocator);
+		vkDestroyCommandPool(vkRef.logDevice, frame.graphicsCommandPool, &vkRef.hostAllocator);
+	}
+	vkRef.frames.clear();
+}
+
+T_small_vector<const char*, 8> VkSetup::_GetRequiredInstanceExtensions(bool bHeadless)
 {
 	u32 extensionCount = 0;
-	const char** extensions;
+	const char** extensions = nullptr;
     
     #if LAYER_PLATFORM_ANDROID
 		// TODO: Add a way to get required android extensions
     #else // GLFW
-		extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+		// Headless has no window surface to create, so it needs none of the WSI extensions (and GLFW may not be initialized)
+		if (!bHeadless)
+		{
+			extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+		}
     #endif
 
-	T_vector<const char*> requiredExtensions(extensions, extensions + extensionCount);
+	T_small_vector<const char*, 8> requiredExtensions(extensions, extensions + extensionCount);
     
     
     #if LAYER_USE_VALIDATION_LAYERS
@@ -343,7 +433,7 @@ T_vector<const char*> VkSetup::_GetRequiredInstanceExtensions()
 	return requiredExtensions;
 }
 
-bool VkSetup::_CheckInstanceExtensionSupport(const T_vector<const char*>& checkExtensions)
+bool VkSetup::_CheckInstanceExtensionSupport(const T_small_vector<const char*, 8>& checkExtensions)
 {
 	u32 extensionCount = 0;
 	LOG_VKRESULT(vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr))
@@ -388,9 +478,12 @@ bool VkSetup::_CheckPhysicalDeviceIsSuitableAndBuildReference(VkPhysicalDevice p
 
 	// Pass info along to get set and to check if it meets the given requirements
 	if (!_CheckPhysicalDeviceSupportsDesiredFeatures(phyDeviceReference))		return false;
-	if (!_CheckPhysicalDeviceSupportsDesiredExtensions(phyDeviceReference))		return false;
+	if (!_CheckPhysicalDeviceSupportsDesiredExtensions(phyDeviceReference, surface == VK_NULL_HANDLE))	return false;
 	if (!_CheckQueueFamiliesAreSuitableAndSetRef(phyDeviceReference, surface))	return false;
-	if (!_CheckAndSetSwapChainDetails(phyDeviceReference, surface))				return false;
+	if (surface != VK_NULL_HANDLE)
+	{
+		if (!_CheckAndSetSwapChainDetails(phyDeviceReference, surface))			return false;
+	}
 	if (!_CheckAndSetAttachmentFormats(phyDeviceReference))						return false;
 
 
@@ -424,7 +517,7 @@ bool VkSetup::_CheckPhysicalDeviceSupportsDesiredFeatures(PhysicalDevice& phyDev
 	return true;
 }
 
-bool VkSetup::_CheckPhysicalDeviceSupportsDesiredExtensions(PhysicalDevice& phyDeviceReference)
+bool VkSetup::_CheckPhysicalDeviceSupportsDesiredExtensions(PhysicalDevice& phyDeviceReference, bool bHeadless)
 {
 	u32 extensionAvailableCount = 0;
 	LOG_VKRESULT(vkEnumerateDeviceExtensionProperties(phyDeviceReference.handle, nullptr, &extensionAvailableCount, nullptr))
@@ -439,9 +532,9 @@ bool VkSetup::_CheckPhysicalDeviceSupportsDesiredExtensions(PhysicalDevice& phyD
 	T_vector<VkExtensionProperties> extensionsAvailable(extensionAvailableCount);
 	LOG_VKRESULT(vkEnumerateDeviceExtensionProperties(phyDeviceReference.handle, nullptr, &extensionAvailableCount, extensionsAvailable.data()))
 
-	// Check to see if your wanted extensions list ('deviceExtensions' in Utils.h) is in the extensions available list.
+	// Check to see if your wanted extensions list ('desiredDeviceExtensions' in VkConfig.h) is in the extensions available list.
 	bool bAllExtensionsSupported = true;
-	for (const auto& wantedExtension : VkConfig::desiredDeviceExtensions)
+	for (const auto& wantedExtension : _GetDesiredDeviceExtensions(bHeadless))
 	{
 		bool bExtensionSupported = false;
 		for (const auto& extensionAvailable : extensionsAvailable)
@@ -476,7 +569,7 @@ bool VkSetup::_CheckQueueFamiliesAreSuitableAndSetRef(PhysicalDevice& phyDeviceR
 		return false;
 	}
 
-	T_vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyPropertiesCount);
+	T_small_vector<VkQueueFamilyProperties, 8> queueFamilyProperties(queueFamilyPropertiesCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(phyDeviceReference.handle, &queueFamilyPropertiesCount, queueFamilyProperties.data());
 
 	// Go through each Queue Family and check if it has at least 1 of the required types of queue.
@@ -498,19 +591,27 @@ bool VkSetup::_CheckQueueFamiliesAreSuitableAndSetRef(PhysicalDevice& phyDeviceR
 	}
 
 	// -PRESENT QUEUE-
-	for (i32 i = 0; i < queueFamilyPropertiesCount; ++i)
+	// Headless never presents, so the graphics queue stands in for it
+	if (surface == VK_NULL_HANDLE)
 	{
-		// Check to see if queue family supports presentation queues, set first valid queue
-		VkBool32 presentationSupport = false;
-		LOG_VKRESULT(vkGetPhysicalDeviceSurfaceSupportKHR(phyDeviceReference.handle, i, surface, &presentationSupport))
-		if (queueFamilyProperties[i].queueCount > 0 && presentationSupport)
+		phyDeviceReference.presentQueueIndex = phyDeviceReference.graphicsQueueIndex;
+	}
+	else
+	{
+		for (i32 i = 0; i < queueFamilyPropertiesCount; ++i)
 		{
-			phyDeviceReference.presentQueueIndex = i;
-			break;
+			// Check to see if queue family supports presentation queues, set first valid queue
+			VkBool32 presentationSupport = false;
+			LOG_VKRESULT(vkGetPhysicalDeviceSurfaceSupportKHR(phyDeviceReference.handle, i, surface, &presentationSupport))
+			if (queueFamilyProperties[i].queueCount > 0 && presentationSupport)
+			{
+				phyDeviceReference.presentQueueIndex = i;
+				break;
+			}
 		}
 	}
 
-	if (phyDeviceReference.graphicsQueueIndex < 0)
+	if (phyDeviceReference.presentQueueIndex < 0)
 	{
 		LOG_WARNING_MIN(T_string("No Vulkan Queue Family That Supports Presenting Found For Device: ", phyDeviceReference.properties.deviceName))
 		return false;
@@ -518,7 +619,7 @@ bool VkSetup::_CheckQueueFamiliesAreSuitableAndSetRef(PhysicalDevice& phyDeviceR
 
 	// -COMPUTE QUEUE-
 	bool bHasDedicatedComputeQueue = false;
-	T_vector<std::pair<i32, VkQueueFamilyProperties>> computeQueues;
+	T_small_vector<std::pair<i32, VkQueueFamilyProperties>, 8> computeQueues;
 	for (i32 i = 0; i < queueFamilyPropertiesCount; ++i)
 	{
 		// Grab all the queue families that have the VK_QUEUE_COMPUTE_BIT flag
@@ -563,8 +664,8 @@ bool VkSetup::_CheckQueueFamiliesAreSuitableAndSetRef(PhysicalDevice& phyDeviceR
 
 	// -TRANSFER QUEUE-
 	bool bHasDedicatedTransferQueue = false;
-	T_vector<std::pair<i32, VkQueueFamilyProperties>> transferQueues;
-	T_vector<std::pair<i32, VkQueueFamilyProperties>> dedicatedTransferQueues;
+	T_small_vector<std::pair<i32, VkQueueFamilyProperties>, 8> transferQueues;
+	T_small_vector<std::pair<i32, VkQueueFamilyProperties>, 8> dedicatedTransferQueues;
 	for (i32 i = 0; i < queueFamilyPropertiesCount; ++i)
 	{
 		// Grab all the queue families that have the VK_QUEUE_TRANSFER_BIT flag
@@ -692,7 +793,6 @@ endloop:
 		{
 			phyDeviceReference.preferredPresentMode = VK_PRESENT_MODE_MAILBOX_KHR;
 			phyDeviceReference.swapChainBufferCount = 3;	// Triple Buffer
-			phyDeviceReference.numInFlightFrames = 2;		// Should be 1 less than total swap chain count
 			phyDeviceReference.bSupportsMailboxMode = true;
 			break;
 		}
@@ -702,7 +802,6 @@ endloop:
 	{
 		phyDeviceReference.preferredPresentMode = VK_PRESENT_MODE_FIFO_KHR;
 		phyDeviceReference.swapChainBufferCount = 2;	// Double Buffer
-		phyDeviceReference.numInFlightFrames = 1;		// Should be 1 less than total swap chain count
 	}
 
 	LOG_INFO(T_string(phyDeviceReference.properties.deviceName, " Preferred Surface Format: ",
@@ -781,6 +880,204 @@ bool VkSetup::_CheckAndSetAttachmentFormats(PhysicalDevice& phyDeviceReference)
 	return true;
 }
 
+T_small_vector<const char*, 8> VkSetup::_GetDesiredDeviceExtensions(bool bHeadless)
+{
+	T_small_vector<const char*, 8> extensions(VkConfig::desiredDeviceExtensions.begin(), VkConfig::desiredDeviceExtensions.end());
+
+	if (!bHeadless)
+	{
+		for (const char* extension : VkConfig::presentDeviceExtensions)
+		{
+			extensions.emplace_back(extension);
+		}
+	}
+
+	return extensions;
+}
+
+VkSetup::_PhysicalDeviceCacheKey VkSetup::_BuildPhysicalDeviceCacheKey(const T_small_vector<VkPhysicalDevice, 4>& physicalDevices, bool bHeadless)
+{
+	_PhysicalDeviceCacheKey key = {};
+
+	key.configHash = _HashBytes(&VkConfig::desiredDeviceFeatures, sizeof(VkConfig::desiredDeviceFeatures));
+	for (const char* extension : _GetDesiredDeviceExtensions(bHeadless))
+	{
+		key.configHash = _HashBytes(extension, strlen(extension), key.configHash);
+	}
+	key.configHash = _HashBytes(VkConfig::desiredSurfaceFormats.data(), sizeof(VkConfig::desiredSurfaceFormats), key.configHash);
+	key.configHash = _HashBytes(VkConfig::desiredSurface10bitFormats.data(), sizeof(VkConfig::desiredSurface10bitFormats), key.configHash);
+	key.configHash = _HashBytes(VkConfig::desiredColorAttachment32BitPackFormats.data(), sizeof(VkConfig::desiredColorAttachment32BitPackFormats), key.configHash);
+	key.configHash = _HashBytes(VkConfig::desiredColorAttachment16BitPackFormats.data(), sizeof(VkConfig::desiredColorAttachment16BitPackFormats), key.configHash);
+	key.configHash = _HashBytes(VkConfig::desiredColorAttachment10BitColorFormats.data(), sizeof(VkConfig::desiredColorAttachment10BitColorFormats), key.configHash);
+	key.configHash = _HashBytes(VkConfig::desiredDepthStencilAttachmentFormats.data(), sizeof(VkConfig::desiredDepthStencilAttachmentFormats), key.configHash);
+
+	key.deviceSetHash = _HashBytes(nullptr, 0);
+	for (VkPhysicalDevice phyDevice : physicalDevices)
+	{
+		VkPhysicalDeviceProperties properties = {};
+		vkGetPhysicalDeviceProperties(phyDevice, &properties);
+
+		const std::array<u8, VK_UUID_SIZE>& uuid = key.deviceUUIDs.emplace_back(_GetDeviceUUID(phyDevice));
+		key.deviceSetHash = _HashBytes(uuid.data(), uuid.size(), key.deviceSetHash);
+		key.deviceSetHash = _HashBytes(&properties.driverVersion, sizeof(properties.driverVersion), key.deviceSetHash);
+	}
+
+	return key;
+}
+
+bool VkSetup::_LoadCachedPhysicalDevice(VkRef& vkRef, const T_small_vector<VkPhysicalDevice, 4>& physicalDevices, const _PhysicalDeviceCacheKey& key)
+{
+	T_vector<u8, MT_GRAPHICS> file;
+	if (!FileHelper::ReadBinaryFile(_physicalDeviceCachePath, file)) { return false; }
+
+	_PhysicalDeviceCache cache = {};
+	if (file.size() < sizeof(cache)) { return false; }
+	memcpy(&cache, file.data(), sizeof(cache));
+
+	if (cache.magic != _PhysicalDeviceCache().magic || cache.version != _physicalDeviceCacheVersion ||
+		cache.configHash != key.configHash || cache.deviceSetHash != key.deviceSetHash || cache.bHeadless != static_cast<u32>(vkRef.bHeadless))
+	{
+		return false;
+	}
+
+	const u64 expectedSize = sizeof(cache) + cache.numSurfaceFormats * sizeof(VkSurfaceFormatKHR) + cache.numPresentModes * sizeof(VkPresentModeKHR);
+	if (file.size() != expectedSize) { return false; }
+
+	// The device set hash matched, so the cached device is still here
+	VkPhysicalDevice handle = VK_NULL_HANDLE;
+	for (u32 i = 0; i < physicalDevices.size(); i++)
+	{
+		if (key.deviceUUIDs[i] == cache.deviceUUID)
+		{
+			handle = physicalDevices[i];
+			break;
+		}
+	}
+	if (handle == VK_NULL_HANDLE) { return false; }
+
+	PhysicalDevice phyDevice = {};
+	phyDevice.handle = handle;
+	vkGetPhysicalDeviceProperties(handle, &phyDevice.properties);
+	vkGetPhysicalDeviceFeatures(handle, &phyDevice.features);
+	if (phyDevice.properties.driverVersion != cache.driverVersion) { return false; }
+
+	phyDevice.presentQueueIndex = cache.presentQueueIndex;
+	phyDevice.graphicsQueueIndex = cache.graphicsQueueIndex;
+	phyDevice.computeQueueIndex = cache.computeQueueIndex;
+	phyDevice.transferQueueIndex = cache.transferQueueIndex;
+	phyDevice.bHasTransferQueue = cache.bHasTransferQueue != 0;
+
+	phyDevice.preferredSurfaceFormat = cache.preferredSurfaceFormat;
+	phyDevice.preferredPresentMode = cache.preferredPresentMode;
+	phyDevice.swapChainBufferCount = cache.swapChainBufferCount;
+	phyDevice.bSupportsMailboxMode = cache.bSupportsMailboxMode != 0;
+
+	phyDevice.preferred32BitPackColorAttachmentFormat = cache.preferred32BitPackColorAttachmentFormat;
+	phyDevice.preferredDepthStencilAttachmentFormat = cache.preferredDepthStencilAttachmentFormat;
+	phyDevice.bSupports16BitPackColorAttachment = cache.bSupports16BitPackColorAttachment != 0;
+	phyDevice.preferred16BitPackColorAttachmentFormat = cache.preferred16BitPackColorAttachmentFormat;
+	phyDevice.bSupports10BitColorAttachment = cache.bSupports10BitColorAttachment != 0;
+	phyDevice.preferred10BitColorAttachmentFormat = cache.preferred10BitColorAttachmentFormat;
+
+	phyDevice.surfaceFormats.resize(cache.numSurfaceFormats);
+	phyDevice.presentationModes.resize(cache.numPresentModes);
+	memcpy(phyDevice.surfaceFormats.data(), file.data() + sizeof(cache), cache.numSurfaceFormats * sizeof(VkSurfaceFormatKHR));
+	memcpy(phyDevice.presentationModes.data(), file.data() + sizeof(cache) + cache.numSurfaceFormats * sizeof(VkSurfaceFormatKHR),
+		cache.numPresentModes * sizeof(VkPresentModeKHR));
+
+	phyDevice.minUniformBufferOffset = phyDevice.properties.limits.minUniformBufferOffsetAlignment;
+
+	// The surface is new every launch. Its capabilities hold the current extent, and the cached present queue has to still present to it.
+	if (vkRef.surface != VK_NULL_HANDLE)
+	{
+		VkBool32 bPresentSupport = VK_FALSE;
+		if (vkGetPhysicalDeviceSurfaceSupportKHR(handle, static_cast<u32>(cache.presentQueueIndex), vkRef.surface, &bPresentSupport) != VK_SUCCESS || !bPresentSupport)
+		{
+			return false;
+		}
+		if (vkGetPhysicalDeviceSurfaceCapabilitiesKHR(handle, vkRef.surface, &phyDevice.surfaceCapabilities) != VK_SUCCESS)
+		{
+			return false;
+		}
+	}
+
+	vkRef.phyDevice = phyDevice;
+	return true;
+}
+
+void VkSetup::_SavePhysicalDeviceCache(const PhysicalDevice& phyDevice, const _PhysicalDeviceCacheKey& key, u32 deviceIndex, bool bHeadless)
+{
+	_PhysicalDeviceCache cache = {};
+	cache.configHash = key.configHash;
+	cache.deviceSetHash = key.deviceSetHash;
+	cache.deviceUUID = key.deviceUUIDs[deviceIndex];
+	cache.driverVersion = phyDevice.properties.driverVersion;
+	cache.bHeadless = bHeadless ? 1 : 0;
+
+	cache.presentQueueIndex = phyDevice.presentQueueIndex;
+	cache.graphicsQueueIndex = phyDevice.graphicsQueueIndex;
+	cache.computeQueueIndex = phyDevice.computeQueueIndex;
+	cache.transferQueueIndex = phyDevice.transferQueueIndex;
+	cache.bHasTransferQueue = phyDevice.bHasTransferQueue ? 1 : 0;
+
+	cache.preferredSurfaceFormat = phyDevice.preferredSurfaceFormat;
+	cache.preferredPresentMode = phyDevice.preferredPresentMode;
+	cache.swapChainBufferCount = phyDevice.swapChainBufferCount;
+	cache.bSupportsMailboxMode = phyDevice.bSupportsMailboxMode ? 1 : 0;
+
+	cache.preferred32BitPackColorAttachmentFormat = phyDevice.preferred32BitPackColorAttachmentFormat;
+	cache.preferredDepthStencilAttachmentFormat = phyDevice.preferredDepthStencilAttachmentFormat;
+	cache.bSupports16BitPackColorAttachment = phyDevice.bSupports16BitPackColorAttachment ? 1 : 0;
+	cache.preferred16BitPackColorAttachmentFormat = phyDevice.preferred16BitPackColorAttachmentFormat;
+	cache.bSupports10BitColorAttachment = phyDevice.bSupports10BitColorAttachment ? 1 : 0;
+	cache.preferred10BitColorAttachmentFormat = phyDevice.preferred10BitColorAttachmentFormat;
+
+	cache.numSurfaceFormats = static_cast<u32>(phyDevice.surfaceFormats.size());
+	cache.numPresentModes = static_cast<u32>(phyDevice.presentationModes.size());
+
+	const u64 surfaceFormatsSize = cache.numSurfaceFormats * sizeof(VkSurfaceFormatKHR);
+	const u64 presentModesSize = cache.numPresentModes * sizeof(VkPresentModeKHR);
+	T_vector<u8, MT_GRAPHICS> file(sizeof(cache) + surfaceFormatsSize + presentModesSize);
+	memcpy(file.data(), &cache, sizeof(cache));
+	memcpy(file.data() + sizeof(cache), phyDevice.surfaceFormats.data(), surfaceFormatsSize);
+	memcpy(file.data() + sizeof(cache) + surfaceFormatsSize, phyDevice.presentationModes.data(), presentModesSize);
+
+	FileHelper::CreateFolderIfAbsent(FileHelper::cacheFolderPath);
+	LOG_WARNING_IF(!FileHelper::WriteBinaryFileAtomic(file.data(), file.size(), _physicalDeviceCachePath), "Couldn't write the physical device cache")
+}
+
+std::array<u8, VK_UUID_SIZE> VkSetup::_GetDeviceUUID(VkPhysicalDevice phyDevice)
+{
+	VkPhysicalDeviceProperties properties = {};
+	vkGetPhysicalDeviceProperties(phyDevice, &properties);
+
+	std::array<u8, VK_UUID_SIZE> uuid = {};
+	if (properties.apiVersion >= VK_API_VERSION_1_1)
+	{
+		VkPhysicalDeviceIDProperties idProperties = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES };
+		VkPhysicalDeviceProperties2 properties2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+		properties2.pNext = &idProperties;
+		vkGetPhysicalDeviceProperties2(phyDevice, &properties2);
+		memcpy(uuid.data(), idProperties.deviceUUID, VK_UUID_SIZE);
+	}
+	else
+	{
+		memcpy(uuid.data(), properties.pipelineCacheUUID, VK_UUID_SIZE);
+	}
+	return uuid;
+}
+
+u64 VkSetup::_HashBytes(const void* pData, u64 size, u64 hash)
+{
+	const u8* pBytes = static_cast<const u8*>(pData);
+	for (u64 i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
 template<size_t S>
 VkFormat VkSetup::_ChooseSupportedAttachmentFormat([[maybe_unused]] const PhysicalDevice& phyDeviceReference,
                                                    [[maybe_unused]] const std::array<VkFormat, S>& formats,
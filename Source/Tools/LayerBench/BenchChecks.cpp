@@ -0,0 +1,224 @@
+#include "BenchChecks.h"
+#include "LayerContainers.h"
+#include "Logger.h"
+#include "FileHelper.h"
+#include "FrameArena.h"
+#include "LoggingCallbacks.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include <fstream>
+#include <sstream>
+
+
+namespace LayerBench
+{
+	// Lines logged after Logger::ShutdownLogging() still reach SessionLog.txt (Editor logs its final memory report then)
+	bool _CheckLogAfterShutdown();
+
+	// Frame arena pointers honor every power of two alignment, from the block and when spilled to the heap
+	bool _CheckFrameArenaAlignment();
+
+	// Vulkan host allocation callbacks hammered from many threads keep block contents and alignment, and MT_VULKAN returns to where it started
+	bool _CheckVkHostCallbacks();
+
+	// Blocks each thread keeps live and alloc/realloc/free calls it makes in _CheckVkHostCallbacks()
+	constexpr u32 _vkStressBlocks = 256;
+	constexpr u32 _vkStressOps = 200000;
+
+	// Cheap per thread random numbers
+	u64 _NextRandom(u64& state);
+
+	constexpr std::array<Check, 3> _checks = {
+		Check{ "log-after-shutdown",	"A line logged after ShutdownLogging() is in SessionLog.txt",					_CheckLogAfterShutdown },
+		Check{ "frame-arena-align",		"Frame arena allocations are aligned up to 4 KiB, in the block and spilled",	_CheckFrameArenaAlignment },
+		Check{ "vk-host-callbacks",		"Vulkan host alloc/realloc/free from every core, tracked bytes return to zero",	_CheckVkHostCallbacks },
+	};
+}
+
+std::span<const LayerBench::Check> LayerBench::GetChecks()
+{
+	return _checks;
+}
+
+const LayerBench::Check* LayerBench::FindCheck(const char* name)
+{
+	for (const Check& check : _checks)
+	{
+		if (strcmp(check.name, name) == 0) { return &check; }
+	}
+	return nullptr;
+}
+
+u64 LayerBench::_NextRandom(u64& state)
+{
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return state;
+}
+
+bool LayerBench::_CheckLogAfterShutdown()
+{
+	constexpr const char* marker = "LayerBench check: logged after shutdown";
+
+	Logger::InitializeLogging();
+	LOG_INFO("LayerBench check: logged before shutdown")
+	Logger::ShutdownLogging();
+
+	// No writer thread left, the line has to be on disk by the time this returns
+	Logger::AddToSessionLogFile(marker);
+
+	std::ifstream sessionLog(T_string(FileHelper::currentWorkingDirectory, Logger::sessionLogPath).c_str());
+	std::stringstream contents;
+	contents << sessionLog.rdbuf();
+	if (contents.str().find(marker) == std::string::npos)
+	{
+		std::printf("    '%s' missing from %s\n", marker, Logger::sessionLogPath);
+		return false;
+	}
+	return true;
+}
+
+bool LayerBench::_CheckFrameArenaAlignment()
+{
+	// Over aligned element type, only AlignedMalloc can satisfy it once the block is full
+	struct alignas(256) OverAligned { u8 bytes[256]; };
+	const auto isAligned = [](const void* ptr, u64 alignment) { return (reinterpret_cast<uintptr_t>(ptr) & (alignment - 1)) == 0; };
+
+	constexpr u64 capacity = 64 * KiB;
+	FrameArena::InitializeFrameArena(1, capacity);
+	FrameArena::BeginFrame(0);
+
+	bool bPassed = true;
+	for (u64 alignment = 1; alignment <= 4 * KiB; alignment *= 2)
+	{
+		// Odd sizes first so the bump pointer is never already aligned
+		FrameArena::Allocate(3, 1);
+		const void* ptr = FrameArena::Allocate(24, alignment);
+		if (ptr == nullptr || !isAligned(ptr, alignment) || !FrameArena::Owns(ptr))
+		{
+			std::printf("    Block allocation aligned to %llu returned %p\n", static_cast<unsigned long long>(alignment), ptr);
+			bPassed = false;
+		}
+	}
+
+	// Fill the block so the vectors below spill to the heap
+	while (FrameArena::Allocate(1 * KiB, 1) != nullptr) {}
+	{
+		T_frame_vector<OverAligned> spilled(4);
+		T_frame_vector<u64> spilledSmall(4);
+		if (FrameArena::Owns(spilled.data()) || !isAligned(spilled.data(), alignof(OverAligned)) || !isAligned(spilledSmall.data(), alignof(u64)))
+		{
+			std::printf("    Spilled allocations misaligned: %p, %p\n", static_cast<void*>(spilled.data()), static_cast<void*>(spilledSmall.data()));
+			bPassed = false;
+		}
+	}
+
+	FrameArena::ShutdownFrameArena();
+	return bPassed;
+}
+
+bool LayerBench::_CheckVkHostCallbacks()
+{
+	struct Block
+	{
+		u8* pMemory = nullptr;
+		u64 size = 0;
+		u64 alignment = 0;
+		u8 fill = 0;
+	};
+
+	// Every byte of a live block holds its fill, so a realloc that loses contents or two threads sharing memory both show up
+	const auto isIntact = [](const Block& block, u64 size)
+	{
+		for (u64 i = 0; i < size; i++)
+		{
+			if (block.pMemory[i] != block.fill) { return false; }
+		}
+		return (reinterpret_cast<uintptr_t>(block.pMemory) & (block.alignment - 1)) == 0;
+	};
+
+	std::atomic<u64> numCorrupted = 0;
+	const auto stressThread = [&numCorrupted, &isIntact](u64 seed)
+	{
+		std::array<Block, _vkStressBlocks> blocks = {};
+		u64 random = seed;
+		for (u32 op = 0; op < _vkStressOps; op++)
+		{
+			Block& block = blocks[_NextRandom(random) % blocks.size()];
+			const u64 roll = _NextRandom(random);
+			const u64 size = 1 + (roll >> 8) % (4 * KiB);
+
+			if (block.pMemory == nullptr)
+			{
+				// 1 - 256 byte alignment, both sides of the callbacks' 16 byte header
+				block.alignment = u64(1) << (roll % 9);
+				block.pMemory = static_cast<u8*>(MemoryTackingCallbacks::vkAllocateHostMemory(nullptr, size, block.alignment, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+				block.size = size;
+				block.fill = static_cast<u8>(roll >> 32);
+				memset(block.pMemory, block.fill, size);
+				continue;
+			}
+
+			if (!isIntact(block, block.size)) { numCorrupted.fetch_add(1, std::memory_order_relaxed); }
+
+			if (roll % 3 == 0)
+			{
+				MemoryTackingCallbacks::vkFreeHostMemory(nullptr, block.pMemory);
+				block = {};
+				continue;
+			}
+
+			// Vulkan reallocs keep the original alignment, grow or shrink
+			const u64 keptSize = std::min(size, block.size);
+			block.pMemory = static_cast<u8*>(MemoryTackingCallbacks::vkReallocateHostMemory(nullptr, block.pMemory, size, block.alignment, VK_SYSTEM_ALLOCATION_SCOPE_OBJECT));
+			if (!isIntact(block, keptSize)) { numCorrupted.fetch_add(1, std::memory_order_relaxed); }
+			block.size = size;
+			memset(block.pMemory, block.fill, size);
+		}
+
+		for (Block& block : blocks)
+		{
+			MemoryTackingCallbacks::vkFreeHostMemory(nullptr, block.pMemory);
+		}
+	};
+
+	[[maybe_unused]] const MemoryUsageInfo usageBefore = MemoryTracker::GetHostMemoryUsage(MT_VULKAN);
+	const u32 numThreads = std::clamp(std::thread::hardware_concurrency(), 4u, 16u);
+
+	const u64 begin = Profiler::Now();
+	T_vector<std::thread, MT_OTHER> threads;
+	for (u32 i = 0; i < numThreads; i++)
+	{
+		threads.emplace_back(stressThread, 0x9E3779B97F4A7C15ull * (i + 1));
+	}
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+	const f64 seconds = static_cast<f64>(Profiler::Now() - begin) / 1'000'000'000.0;
+
+	[[maybe_unused]] const MemoryUsageInfo usageAfter = MemoryTracker::GetHostMemoryUsage(MT_VULKAN);
+	std::printf("    %u threads x %u ops in %.3fs (%.1f M ops/s)\n", numThreads, _vkStressOps, seconds, numThreads * _vkStressOps / seconds / 1'000'000.0);
+
+	bool bPassed = true;
+	if (numCorrupted.load() > 0)
+	{
+		std::printf("    %llu blocks lost their contents or alignment\n", static_cast<unsigned long long>(numCorrupted.load()));
+		bPassed = false;
+	}
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+	const u64 allocations = usageAfter.allocations - usageBefore.allocations;
+	const u64 frees = usageAfter.frees - usageBefore.frees;
+	std::printf("    MT_VULKAN: %llu allocations, %llu frees, %lld bytes left\n", static_cast<unsigned long long>(allocations),
+		static_cast<unsigned long long>(frees), static_cast<long long>(usageAfter.size - usageBefore.size));
+	if (usageAfter.size != usageBefore.size || allocations != frees)
+	{
+		bPassed = false;
+	}
+#else
+	std::printf("    Memory tracking compiled out, only contents/alignment checked\n");
+#endif
+	return bPassed;
+}
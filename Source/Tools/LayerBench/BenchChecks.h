@@ -0,0 +1,23 @@
+#pragma once
+#include "ThirdParty.h"
+#include <span>
+
+
+// --BENCH CHECKS--
+// Self checks and micro benchmarks LayerBench runs without starting the engine, so they need no Vulkan device. Each one drives a
+// single engine system directly, prints what it measured and fails if the system misbehaved.
+namespace LayerBench
+{
+	struct Check
+	{
+		const char* name = "";
+		const char* description = "";
+		bool (*pRun)() = nullptr;	// False on failure, prints its own numbers and failure reason
+	};
+
+	// Every check, run in this order
+	std::span<const Check> GetChecks();
+
+	// nullptr if there's no check with that name
+	const Check* FindCheck(const char* name);
+}
@@ -0,0 +1,378 @@
+#include "BenchResults.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+
+
+namespace LayerBench
+{
+	struct _Stats
+	{
+		f64 avg = 0.0;
+		f64 p50 = 0.0;
+		f64 p95 = 0.0;
+		f64 p99 = 0.0;
+		f64 max = 0.0;
+	};
+
+	// One leaf of a results file, keyed by its dotted path (e.g. "summary.frame_ms.p95")
+	struct _Entry
+	{
+		std::string key;
+		std::string text;		// Strings/bools
+		f64 number = 0.0;
+		bool bNumber = false;
+	};
+
+	// Nearest rank percentiles of samples
+	_Stats _ComputeStats(const T_vector<f64, MT_ENGINE>& samples);
+
+	// Tag name without the tabs/colons the trackers pad them with
+	std::string _CleanTagName(const char* tagName);
+
+	void _AppendNumber(std::string& json, f64 value);
+	void _AppendStats(std::string& json, const char* name, const T_vector<f64, MT_ENGINE>& samples, bool& bFirst);
+	void _AppendSamples(std::string& json, const char* name, const T_vector<f64, MT_ENGINE>& samples, bool& bFirst);
+
+	// Flattens every string/number/bool leaf of a results file, arrays (the raw samples) are skipped. False if it isn't valid JSON.
+	bool _LoadEntries(const char* filePath, std::vector<_Entry>& outEntries);
+
+	// Only the summary percentiles and peak memory are gated. Max is one frame, too noisy to fail a run on.
+	bool _IsGatedMetric(const std::string& key);
+
+	// Absolute change a metric has to exceed before its percentage counts, keeps tiny values from flagging on noise
+	f64 _NoiseFloor(const std::string& key);
+}
+
+bool LayerBench::WriteResults(const RunResults& results, const char* filePath)
+{
+	std::string json = "{\n";
+	json += "\"version\": " + std::to_string(resultsVersion) + ",\n";
+
+	// -Config-
+	const RunConfig& config = results.config;
+	json += "\"config\": {";
+	json += "\"workload\": \"" + std::string(config.workload) + "\"";
+	json += ", \"frames\": " + std::to_string(config.frames);
+	json += ", \"warmup_frames\": " + std::to_string(config.warmupFrames);
+	json += ", \"width\": " + std::to_string(config.width);
+	json += ", \"height\": " + std::to_string(config.height);
+	json += ", \"frames_in_flight\": " + std::to_string(config.framesInFlight);
+	json += ", \"record_threads\": " + std::to_string(config.recordThreads);
+	json += std::string(", \"readback\": ") + (config.bReadback ? "true" : "false");
+	#ifdef LAYER_USE_PROFILER
+		json += ", \"profiler\": true";
+	#else
+		json += ", \"profiler\": false";
+	#endif
+	#ifdef LAYER_USE_MEMORY_TRACKING
+		json += ", \"memory_tracking\": true";
+	#else
+		json += ", \"memory_tracking\": false";
+	#endif
+	#ifdef LAYER_USE_CUSTOM_HEAP
+		json += ", \"custom_heap\": true";
+	#else
+		json += ", \"custom_heap\": false";
+	#endif
+	#if LAYER_USE_VALIDATION_LAYERS
+		json += ", \"validation_layers\": true";
+	#else
+		json += ", \"validation_layers\": false";
+	#endif
+	json += "},\n";
+
+	// -Summary-
+	json += "\"summary\": {";
+	bool bFirst = true;
+	_AppendStats(json, "frame_ms", results.frameTimes, bFirst);
+	_AppendStats(json, "cpu_ms", results.cpuTimes, bFirst);
+	_AppendStats(json, "gpu_ms", results.gpuTimes, bFirst);
+	_AppendStats(json, "allocs_per_frame", results.allocsPerFrame, bFirst);
+	json += "\n},\n";
+
+	// -Peak memory, tags that were never used are left out-
+	json += "\"peak_host_bytes\": {";
+	bFirst = true;
+	for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+	{
+		if (results.peakHostBytes[tag] == 0) { continue; }
+		json += bFirst ? "" : ", ";
+		json += "\"" + _CleanTagName(MemoryTracker::GetHostMemoryUsage(static_cast<MemoryTrackerTag>(tag)).tagName) + "\": " + std::to_string(results.peakHostBytes[tag]);
+		bFirst = false;
+	}
+	json += "},\n";
+
+	json += "\"peak_gpu_bytes\": {";
+	bFirst = true;
+	for (u32 tag = 0; tag < GPU_USAGE_MAX; tag++)
+	{
+		if (results.peakGpuBytes[tag] == 0) { continue; }
+		json += bFirst ? "" : ", ";
+		json += "\"" + _CleanTagName(GpuMemoryTracker::GetGpuMemoryUsage(static_cast<GpuMemoryUsageTag>(tag)).tagName) + "\": " + std::to_string(results.peakGpuBytes[tag]);
+		bFirst = false;
+	}
+	json += "},\n";
+
+	// -Raw samples, for plotting the full distribution-
+	json += "\"samples\": {";
+	bFirst = true;
+	_AppendSamples(json, "frame_ms", results.frameTimes, bFirst);
+	_AppendSamples(json, "cpu_ms", results.cpuTimes, bFirst);
+	_AppendSamples(json, "gpu_ms", results.gpuTimes, bFirst);
+	_AppendSamples(json, "allocs_per_frame", results.allocsPerFrame, bFirst);
+	json += "\n}\n}\n";
+
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open()) { return false; }
+	file << json;
+	return file.good();
+}
+
+i32 LayerBench::CompareResults(const char* baselinePath, const char* candidatePath, f64 thresholdPercent)
+{
+	std::vector<_Entry> baseline;
+	std::vector<_Entry> candidate;
+	if (!_LoadEntries(baselinePath, baseline))
+	{
+		std::cerr << "Couldn't read bench results " << baselinePath << "\n";
+		return -1;
+	}
+	if (!_LoadEntries(candidatePath, candidate))
+	{
+		std::cerr << "Couldn't read bench results " << candidatePath << "\n";
+		return -1;
+	}
+
+	const auto find = [](const std::vector<_Entry>& entries, const std::string& key) -> const _Entry*
+	{
+		for (const _Entry& entry : entries)
+		{
+			if (entry.key == key) { return &entry; }
+		}
+		return nullptr;
+	};
+
+	// Different configs still get compared, but the numbers probably don't mean much
+	for (const _Entry& entry : baseline)
+	{
+		if (!entry.key.starts_with("config.")) { continue; }
+		const _Entry* pOther = find(candidate, entry.key);
+		if (pOther == nullptr || pOther->text != entry.text || pOther->number != entry.number)
+		{
+			std::cout << "Warning: " << entry.key << " differs between the runs\n";
+		}
+	}
+
+	std::printf("%-44s %14s %14s %9s\n", "Metric", "Baseline", "Candidate", "Change");
+
+	i32 regressions = 0;
+	for (const _Entry& entry : baseline)
+	{
+		if (!entry.bNumber || entry.key.starts_with("config.") || entry.key == "version") { continue; }
+
+		const _Entry* pOther = find(candidate, entry.key);
+		if (pOther == nullptr || !pOther->bNumber)
+		{
+			std::printf("%-44s %14.4f %14s\n", entry.key.c_str(), entry.number, "-");
+			continue;
+		}
+
+		const f64 difference = pOther->number - entry.number;
+		const f64 changePercent = entry.number != 0.0 ? difference / entry.number * 100.0 : (difference != 0.0 ? 100.0 : 0.0);
+		const bool bRegression = _IsGatedMetric(entry.key) && changePercent > thresholdPercent && difference > _NoiseFloor(entry.key);
+		regressions += bRegression ? 1 : 0;
+
+		std::printf("%-44s %14.4f %14.4f %+8.1f%%%s\n", entry.key.c_str(), entry.number, pOther->number, changePercent, bRegression ? "  REGRESSION" : "");
+	}
+
+	// Metrics only the candidate has (e.g. the baseline was built without the profiler)
+	for (const _Entry& entry : candidate)
+	{
+		if (entry.bNumber && !entry.key.starts_with("config.") && find(baseline, entry.key) == nullptr)
+		{
+			std::printf("%-44s %14s %14.4f\n", entry.key.c_str(), "-", entry.number);
+		}
+	}
+
+	std::cout << regressions << " regression(s) past " << thresholdPercent << "%\n";
+	return regressions;
+}
+
+LayerBench::_Stats LayerBench::_ComputeStats(const T_vector<f64, MT_ENGINE>& samples)
+{
+	_Stats stats = {};
+	if (samples.empty()) { return stats; }
+
+	T_vector<f64, MT_ENGINE> sorted(samples);
+	std::sort(sorted.begin(), sorted.end());
+
+	const auto percentile = [&sorted](f64 fraction)
+	{
+		const u64 rank = static_cast<u64>(std::ceil(fraction * static_cast<f64>(sorted.size())));
+		return sorted[std::clamp<u64>(rank, 1, sorted.size()) - 1];
+	};
+
+	f64 sum = 0.0;
+	for (f64 sample : sorted) { sum += sample; }
+
+	stats.avg = sum / static_cast<f64>(sorted.size());
+	stats.p50 = percentile(0.50);
+	stats.p95 = percentile(0.95);
+	stats.p99 = percentile(0.99);
+	stats.max = sorted.back();
+	return stats;
+}
+
+std::string LayerBench::_CleanTagName(const char* tagName)
+{
+	std::string name = tagName;
+	std::erase_if(name, [](char c) { return c == ':' || c == '\t'; });
+	while (!name.empty() && name.back() == ' ') { name.pop_back(); }
+	return name;
+}
+
+void LayerBench::_AppendNumber(std::string& json, f64 value)
+{
+	char buffer[32];
+	std::snprintf(buffer, sizeof(buffer), "%.4f", value);
+	json += buffer;
+}
+
+void LayerBench::_AppendStats(std::string& json, const char* name, const T_vector<f64, MT_ENGINE>& samples, bool& bFirst)
+{
+	if (samples.empty()) { return; }
+
+	const _Stats stats = _ComputeStats(samples);
+	json += bFirst ? "\n\t\"" : ",\n\t\"";
+	json += name;
+	json += "\": {\"avg\": ";	_AppendNumber(json, stats.avg);
+	json += ", \"p50\": ";		_AppendNumber(json, stats.p50);
+	json += ", \"p95\": ";		_AppendNumber(json, stats.p95);
+	json += ", \"p99\": ";		_AppendNumber(json, stats.p99);
+	json += ", \"max\": ";		_AppendNumber(json, stats.max);
+	json += "}";
+	bFirst = false;
+}
+
+void LayerBench::_AppendSamples(std::string& json, const char* name, const T_vector<f64, MT_ENGINE>& samples, bool& bFirst)
+{
+	if (samples.empty()) { return; }
+
+	json += bFirst ? "\n\t\"" : ",\n\t\"";
+	json += name;
+	json += "\": [";
+	for (u64 i = 0; i < samples.size(); i++)
+	{
+		if (i != 0) { json += ", "; }
+		_AppendNumber(json, samples[i]);
+	}
+	json += "]";
+	bFirst = false;
+}
+
+bool LayerBench::_LoadEntries(const char* filePath, std::vector<_Entry>& outEntries)
+{
+	std::ifstream file(filePath, std::ios::in | std::ios::binary);
+	if (!file.is_open()) { return false; }
+	const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	// Small recursive descent parser, just enough JSON for the files WriteResults() produces
+	u64 pos = 0;
+	const auto skipSpace = [&]() { while (pos < text.size() && std::isspace(static_cast<u8>(text[pos]))) { pos++; } };
+	const auto parseString = [&](std::string& out) -> bool
+	{
+		if (pos >= text.size() || text[pos] != '"') { return false; }
+		pos++;
+		while (pos < text.size() && text[pos] != '"')
+		{
+			if (text[pos] == '\\' && pos + 1 < text.size()) { pos++; }
+			out.push_back(text[pos++]);
+		}
+		return pos++ < text.size();
+	};
+
+	std::function<bool(const std::string&, bool)> parseValue = [&](const std::string& key, bool bStore) -> bool
+	{
+		skipSpace();
+		if (pos >= text.size()) { return false; }
+
+		_Entry entry = {};
+		entry.key = key;
+
+		if (text[pos] == '{')
+		{
+			pos++;
+			skipSpace();
+			if (pos < text.size() && text[pos] == '}') { pos++; return true; }
+			while (true)
+			{
+				skipSpace();
+				std::string name;
+				if (!parseString(name)) { return false; }
+				skipSpace();
+				if (pos >= text.size() || text[pos++] != ':') { return false; }
+				if (!parseValue(key.empty() ? name : key + "." + name, bStore)) { return false; }
+				skipSpace();
+				if (pos < text.size() && text[pos] == ',') { pos++; continue; }
+				if (pos < text.size() && text[pos] == '}') { pos++; return true; }
+				return false;
+			}
+		}
+		if (text[pos] == '[')
+		{
+			pos++;
+			skipSpace();
+			if (pos < text.size() && text[pos] == ']') { pos++; return true; }
+			while (true)
+			{
+				if (!parseValue(key, false)) { return false; }
+				skipSpace();
+				if (pos < text.size() && text[pos] == ',') { pos++; continue; }
+				if (pos < text.size() && text[pos] == ']') { pos++; return true; }
+				return false;
+			}
+		}
+		if (text[pos] == '"')
+		{
+			if (!parseString(entry.text)) { return false; }
+		}
+		else if (text.compare(pos, 4, "true") == 0 || text.compare(pos, 4, "null") == 0)
+		{
+			entry.text = text.substr(pos, 4);
+			pos += 4;
+		}
+		else if (text.compare(pos, 5, "false") == 0)
+		{
+			entry.text = "false";
+			pos += 5;
+		}
+		else
+		{
+			char* pEnd = nullptr;
+			entry.number = std::strtod(text.c_str() + pos, &pEnd);
+			if (pEnd == text.c_str() + pos) { return false; }
+			pos = static_cast<u64>(pEnd - text.c_str());
+			entry.bNumber = true;
+		}
+
+		if (bStore) { outEntries.emplace_back(std::move(entry)); }
+		return true;
+	};
+
+	return parseValue("", true);
+}
+
+bool LayerBench::_IsGatedMetric(const std::string& key)
+{
+	if (key.starts_with("peak_")) { return true; }
+	return key.starts_with("summary.") && !key.ends_with(".max");
+}
+
+f64 LayerBench::_NoiseFloor(const std::string& key)
+{
+	if (key.starts_with("peak_"))				{ return 64.0 * 1024.0; }	// Bytes
+	if (key.starts_with("summary.allocs"))		{ return 1.0; }				// Allocations
+	return 0.05;															// ms
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include "ThirdParty.h"
+#include "LayerContainers.h"
+#include "MemoryTracker.h"
+#include "GpuMemoryTracker.h"
+
+
+// --BENCH RESULTS--
+// Per frame samples of one LayerBench run, written as JSON (config, percentile summaries, peak memory per tag and the raw samples).
+// CompareResults() diffs two result files and flags every summary metric that got worse by more than a threshold.
+namespace LayerBench
+{
+	constexpr u32 resultsVersion = 1;
+
+	struct RunConfig
+	{
+		const char* workload = "";
+		u32 frames = 0;
+		u32 warmupFrames = 0;
+		u32 width = 0;
+		u32 height = 0;
+		u32 framesInFlight = 0;
+		u32 recordThreads = 0;		// Recording threads the engine ended up with, caller included
+		bool bReadback = false;
+	};
+
+	struct RunResults
+	{
+		RunConfig config = {};
+
+		// One entry per measured frame. cpu/gpu stay empty when the profiler is compiled out, allocs when memory tracking is.
+		T_vector<f64, MT_ENGINE> frameTimes = {};		// ms, workload + Engine::RunFrame()
+		T_vector<f64, MT_ENGINE> cpuTimes = {};			// ms, frame time minus the main thread's PROFILE_WAIT_ZONEs
+		T_vector<f64, MT_ENGINE> gpuTimes = {};			// ms, the "GPU Frame" GPU zone
+		T_vector<f64, MT_ENGINE> allocsPerFrame = {};	// Host allocations made during the frame, every tag
+
+		// Highest end of frame usage while measuring
+		std::array<u64, MT_MAX_VALUE> peakHostBytes = {};
+		std::array<u64, GPU_USAGE_MAX> peakGpuBytes = {};
+	};
+
+	// Returns false if the file couldn't be written
+	bool WriteResults(const RunResults& results, const char* filePath);
+
+	// Prints every summary metric of both files side by side. Returns the number of regressions, -1 if either file can't be read.
+	// A metric regresses when the candidate is more than thresholdPercent above the baseline and past a small absolute noise floor.
+	i32 CompareResults(const char* baselinePath, const char* candidatePath, f64 thresholdPercent);
+}
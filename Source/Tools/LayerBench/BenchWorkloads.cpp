@@ -0,0 +1,209 @@
+#include "BenchWorkloads.h"
+#include "LayerContainers.h"
+#include "LayerFlatMap.h"
+#include "Logger.h"
+#include "Profiler.h"
+#include "RenderManager.h"
+
+
+namespace LayerBench
+{
+	// Elements/allocations/zones per frame, sized to cost a few hundred microseconds to a couple of ms
+	constexpr u32 _containerElements = 4096;
+	constexpr u32 _heapAllocations = 4096;
+	constexpr u32 _logMessages = 256;
+	constexpr u32 _profileZones = 2048;
+	constexpr u32 _draws = 16384;
+
+	// Written with each frame's results so the work can't be optimized away
+	volatile u64 _sink = 0;
+
+	// Cheap deterministic sizes/orders, the same every run
+	u32 _Hash(u32 value);
+
+	// Nothing but the engine's own frame (headless clear pass, profiler, memory timeline)
+	void _EmptyFrame(u64 frameIndex);
+
+	// T_vector growth, T_small_vector inline/spill and T_flat_map insert/find/erase
+	void _ContainersFrame(u64 frameIndex);
+
+	// Mixed size new/delete churn through the Layer heap, freed out of order
+	void _HeapFrame(u64 frameIndex);
+
+	// Distinct structured logs plus a burst of one repeating message that the rate limiter has to absorb
+	void _LoggingFrame(u64 frameIndex);
+
+	// Nested PROFILE_ZONEs, the cost of instrumentation itself
+	void _ProfilerFrame(u64 frameIndex);
+
+	// Submits draws that only set dynamic state, so the frame's cost is command recording across the recording threads
+	void _DrawsFrame(u64 frameIndex);
+
+	// The draw _DrawsFrame() submits, pUserData is one of _drawViewports
+	void _RecordBenchDraw(VkCommandBuffer cmdBuffer, const void* pUserData);
+
+	// Read by every recording thread, never written after startup
+	const std::array<VkViewport, 64> _drawViewports = []()
+	{
+		std::array<VkViewport, 64> viewports = {};
+		for (u32 i = 0; i < viewports.size(); i++)
+		{
+			viewports[i] = { static_cast<f32>(i), static_cast<f32>(i), 256.0f, 256.0f, 0.0f, 1.0f };
+		}
+		return viewports;
+	}();
+
+	constexpr std::array<Workload, 6> _workloads = {
+		Workload{ "empty",		"Engine frame only, headless clear pass",											_EmptyFrame },
+		Workload{ "containers",	"T_vector/T_small_vector/T_flat_map churn, 4096 elements a frame",					_ContainersFrame },
+		Workload{ "heap",		"4096 mixed size (16 B - 4 KiB) new/delete a frame, freed out of order",			_HeapFrame },
+		Workload{ "logging",	"256 structured logs + a 256 message duplicate burst (rate limited) a frame",		_LoggingFrame },
+		Workload{ "profiler",	"2048 nested PROFILE_ZONEs a frame",												_ProfilerFrame },
+		Workload{ "draws",		"16384 state only draws a frame, recorded in parallel into secondary command buffers",	_DrawsFrame },
+	};
+}
+
+std::span<const LayerBench::Workload> LayerBench::GetWorkloads()
+{
+	return _workloads;
+}
+
+const LayerBench::Workload* LayerBench::FindWorkload(const char* name)
+{
+	for (const Workload& workload : _workloads)
+	{
+		if (strcmp(workload.name, name) == 0) { return &workload; }
+	}
+	return nullptr;
+}
+
+u32 LayerBench::_Hash(u32 value)
+{
+	value ^= value >> 16;
+	value *= 0x7feb352d;
+	value ^= value >> 15;
+	value *= 0x846ca68b;
+	value ^= value >> 16;
+	return value;
+}
+
+void LayerBench::_EmptyFrame([[maybe_unused]] u64 frameIndex)
+{
+}
+
+void LayerBench::_ContainersFrame(u64 frameIndex)
+{
+	MEMORY_TAG_SCOPE(MT_TEMPORARY)
+	PROFILE_ZONE("Bench Containers")
+
+	T_vector<u32, MT_TEMPORARY> values;
+	for (u32 i = 0; i < _containerElements; i++)
+	{
+		values.emplace_back(_Hash(i + static_cast<u32>(frameIndex)));
+	}
+
+	// Mostly inline, every 8th one spills to the heap
+	u64 checksum = 0;
+	for (u32 i = 0; i < _containerElements / 16; i++)
+	{
+		T_small_vector<u32, 8, MT_TEMPORARY> small;
+		const u32 count = (i % 8 == 0) ? 16 : 6;
+		for (u32 j = 0; j < count; j++)
+		{
+			small.emplace_back(values[(i * 16 + j) % _containerElements]);
+		}
+		checksum += small.back();
+	}
+
+	T_flat_map<u32, u32, MT_TEMPORARY> map;
+	for (u32 i = 0; i < _containerElements; i++)
+	{
+		map.try_emplace(values[i], i);
+	}
+	for (u32 i = 0; i < _containerElements; i++)
+	{
+		const auto found = map.find(values[_Hash(i) % _containerElements]);
+		if (found != map.end()) { checksum += found->second; }
+	}
+	for (u32 i = 0; i < _containerElements; i += 2)
+	{
+		map.erase(values[i]);
+	}
+
+	_sink = checksum + map.size();
+}
+
+void LayerBench::_HeapFrame(u64 frameIndex)
+{
+	MEMORY_TAG_SCOPE(MT_TEMPORARY)
+	PROFILE_ZONE("Bench Heap")
+
+	std::array<u8*, _heapAllocations> blocks = {};
+	for (u32 i = 0; i < _heapAllocations; i++)
+	{
+		const u32 size = 16u << (_Hash(i + static_cast<u32>(frameIndex)) % 9);	// 16 B - 4 KiB
+		blocks[i] = new u8[size];
+		blocks[i][0] = static_cast<u8>(i);
+	}
+
+	// Free in a scrambled order so the heap has to coalesce rather than just pop a stack. An odd stride visits every slot once.
+	for (u32 i = 0; i < _heapAllocations; i++)
+	{
+		delete[] blocks[(i * 2654435761u) % _heapAllocations];
+	}
+}
+
+void LayerBench::_LoggingFrame(u64 frameIndex)
+{
+	PROFILE_ZONE("Bench Logging")
+
+	for (u32 i = 0; i < _logMessages; i++)
+	{
+		LOG_INFO_FMT("Bench log | Frame: {} | Message: {} | Value: {}", frameIndex, i, _Hash(i))
+	}
+
+	// One call site repeating, nearly all of it should be dropped by the rate limiter before any formatting
+	for (u32 i = 0; i < _logMessages; i++)
+	{
+		LOG_WARNING_LIMITED("Bench duplicate warning")
+	}
+}
+
+void LayerBench::_ProfilerFrame([[maybe_unused]] u64 frameIndex)
+{
+	for (u32 i = 0; i < _profileZones / 4; i++)
+	{
+		PROFILE_ZONE("Bench Zone 0")
+		{
+			PROFILE_ZONE("Bench Zone 1")
+			{
+				PROFILE_ZONE("Bench Zone 2")
+				{
+					PROFILE_ZONE("Bench Zone 3")
+				}
+			}
+		}
+	}
+}
+
+void LayerBench::_DrawsFrame(u64 frameIndex)
+{
+	PROFILE_ZONE("Bench Draws")
+
+	for (u32 i = 0; i < _draws; i++)
+	{
+		RenderManager::SubmitDraw(_RecordBenchDraw, &_drawViewports[_Hash(i + static_cast<u32>(frameIndex)) % _drawViewports.size()]);
+	}
+}
+
+void LayerBench::_RecordBenchDraw(VkCommandBuffer cmdBuffer, const void* pUserData)
+{
+	const VkViewport& viewport = *static_cast<const VkViewport*>(pUserData);
+	const VkRect2D scissor = { { static_cast<i32>(viewport.x), static_cast<i32>(viewport.y) },
+		{ static_cast<u32>(viewport.width), static_cast<u32>(viewport.height) } };
+	const f32 blendConstants[4] = { viewport.x / 64.0f, viewport.y / 64.0f, 0.0f, 1.0f };
+
+	vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+	vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+	vkCmdSetBlendConstants(cmdBuffer, blendConstants);
+}
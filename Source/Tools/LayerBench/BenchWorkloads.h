@@ -0,0 +1,23 @@
+#pragma once
+#include "ThirdParty.h"
+#include <span>
+
+
+// --BENCH WORKLOADS--
+// CPU work LayerBench runs at the start of every frame, before the engine draws it. Each one leans on a single engine system so a
+// regression in the results points straight at it. The GPU side is the headless offscreen pass plus whatever draws a workload submits.
+namespace LayerBench
+{
+	struct Workload
+	{
+		const char* name = "";
+		const char* description = "";
+		void (*pRunFrame)(u64 frameIndex) = nullptr;
+	};
+
+	// Every workload, the first is the default
+	std::span<const Workload> GetWorkloads();
+
+	// nullptr if there's no workload with that name
+	const Workload* FindWorkload(const char* name);
+}
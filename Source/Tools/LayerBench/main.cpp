@@ -0,0 +1,293 @@
+// LayerBench: boots the engine headless, runs a workload for a fixed number of frames and writes the frame time/memory results as JSON.
+// Usage: LayerBench [run] [--workload <name>] [--frames <n>] [--warmup <n>] [--width <w>] [--height <h>] [--frames-in-flight <n>]
+//                       [--record-threads <n>] [--readback] [-o <results.json>]
+//        LayerBench compare <baseline.json> <candidate.json> [--threshold <percent>]
+//        LayerBench check [<name>...]
+//        LayerBench list
+// compare exits with 1 when any metric regressed past the threshold (5% by default), so CI can gate on it. check runs the engine self
+// checks and micro benchmarks (no GPU needed) and exits with 1 when any of them fails.
+#include "ThirdParty.h"
+#include "Engine.h"
+#include "EngUtils.h"
+#include "RenderManager.h"
+#include "VkConfig.h"
+#include "BenchWorkloads.h"
+#include "BenchResults.h"
+#include "BenchChecks.h"
+#include <string_view>
+
+
+namespace LayerBench
+{
+	constexpr u32 _defaultFrames = 600;
+	constexpr u32 _defaultWarmupFrames = 60;
+	constexpr u32 _defaultWidth = 1280;
+	constexpr u32 _defaultHeight = 720;
+	constexpr f64 _defaultThresholdPercent = 5.0;
+	constexpr const char* _defaultOutputPath = "BenchResults.json";
+
+	constexpr i32 _exitRegressed = 1;
+	constexpr i32 _exitError = 2;
+
+	void _PrintUsage();
+
+	// Parses a u32 option value, false if it's missing or not a number
+	bool _ParseU32(const char* pText, u32& outValue);
+
+	i32 _Run(i32 argc, char* argv[]);
+	i32 _Compare(i32 argc, char* argv[]);
+	i32 _Check(i32 argc, char* argv[]);
+	i32 _List();
+
+	// Samples the frame that Engine::RunFrame() just ended into results
+	void _CaptureFrame(RunResults& results, u64 frameTime, u64& lastAllocCount);
+}
+
+void LayerBench::_PrintUsage()
+{
+	std::cout << "Usage: LayerBench [run] [--workload <name>] [--frames <n>] [--warmup <n>] [--width <w>] [--height <h>] [--frames-in-flight <n>]\n"
+			  << "                       [--record-threads <n>] [--readback] [-o <results.json>]\n"
+			  << "       LayerBench compare <baseline.json> <candidate.json> [--threshold <percent>]\n"
+			  << "       LayerBench check [<name>...]\n"
+			  << "       LayerBench list\n";
+}
+
+bool LayerBench::_ParseU32(const char* pText, u32& outValue)
+{
+	if (pText == nullptr) { return false; }
+	char* pEnd = nullptr;
+	const unsigned long value = std::strtoul(pText, &pEnd, 10);
+	if (pEnd == pText || *pEnd != '\0') { return false; }
+	outValue = static_cast<u32>(value);
+	return true;
+}
+
+i32 LayerBench::_Run(i32 argc, char* argv[])
+{
+	RunConfig config = {};
+	config.workload = GetWorkloads().front().name;
+	config.frames = _defaultFrames;
+	config.warmupFrames = _defaultWarmupFrames;
+	config.width = _defaultWidth;
+	config.height = _defaultHeight;
+	config.framesInFlight = VkConfig::defaultFramesInFlight;
+	const char* outputPath = _defaultOutputPath;
+
+	for (i32 i = 0; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		const char* pValue = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+		bool bValid = true;
+		if (arg == "--workload" && pValue != nullptr)	{ config.workload = pValue; i++; }
+		else if (arg == "--frames")						{ bValid = _ParseU32(pValue, config.frames) && config.frames > 0; i++; }
+		else if (arg == "--warmup")						{ bValid = _ParseU32(pValue, config.warmupFrames); i++; }
+		else if (arg == "--width")						{ bValid = _ParseU32(pValue, config.width) && config.width > 0; i++; }
+		else if (arg == "--height")						{ bValid = _ParseU32(pValue, config.height) && config.height > 0; i++; }
+		else if (arg == "--frames-in-flight")			{ bValid = _ParseU32(pValue, config.framesInFlight) && config.framesInFlight > 0 && config.framesInFlight <= VkConfig::maxFramesInFlight; i++; }
+		else if (arg == "--record-threads")				{ bValid = _ParseU32(pValue, config.recordThreads) && config.recordThreads > 0; i++; }
+		else if (arg == "--readback")					{ config.bReadback = true; }
+		else if (arg == "-o" && pValue != nullptr)		{ outputPath = pValue; i++; }
+		else											{ bValid = false; }
+
+		if (!bValid)
+		{
+			std::cerr << "Bad argument: " << arg << "\n";
+			_PrintUsage();
+			return _exitError;
+		}
+	}
+
+	const Workload* pWorkload = FindWorkload(config.workload);
+	if (pWorkload == nullptr)
+	{
+		std::cerr << "Unknown workload: " << config.workload << " (see LayerBench list)\n";
+		return _exitError;
+	}
+
+	RenderManager::SetFramesInFlight(config.framesInFlight);
+	ParallelRecorder::SetThreadCount(config.recordThreads);
+	Engine::StartUp("Layer Bench", config.width, config.height, true);
+	config.recordThreads = ParallelRecorder::GetThreadCount();
+
+	RunResults results = {};
+	results.config = config;
+	results.frameTimes.reserve(config.frames);
+	results.cpuTimes.reserve(config.frames);
+	results.gpuTimes.reserve(config.frames);
+	results.allocsPerFrame.reserve(config.frames);
+
+	T_vector<u8, MT_GRAPHICS> pixels;
+	u64 lastAllocCount = 0;
+	for (u64 frame = 0; frame < config.warmupFrames + config.frames; frame++)
+	{
+		const u64 frameBegin = Profiler::Now();
+		pWorkload->pRunFrame(frame);
+		Engine::RunFrame();
+		if (config.bReadback && !RenderManager::ReadbackFrame(pixels))
+		{
+			std::cerr << "Frame readback failed, see the session log\n";
+			Engine::Shutdown();
+			return _exitError;
+		}
+		const u64 frameTime = Profiler::Now() - frameBegin;
+
+		// Warmup frames still move the alloc baseline so the first measured frame only counts its own
+		if (frame < config.warmupFrames)
+		{
+			RunResults discard = {};
+			_CaptureFrame(discard, frameTime, lastAllocCount);
+			continue;
+		}
+		_CaptureFrame(results, frameTime, lastAllocCount);
+	}
+
+	Engine::Shutdown();
+
+	if (!WriteResults(results, outputPath))
+	{
+		std::cerr << "Couldn't write " << outputPath << "\n";
+		return _exitError;
+	}
+	std::cout << "Wrote " << results.frameTimes.size() << " frames of '" << config.workload << "' to " << outputPath << "\n";
+	return EXIT_SUCCESS;
+}
+
+void LayerBench::_CaptureFrame(RunResults& results, u64 frameTime, [[maybe_unused]] u64& lastAllocCount)
+{
+	constexpr f64 nsToMs = 1.0 / 1'000'000.0;
+	results.frameTimes.emplace_back(static_cast<f64>(frameTime) * nsToMs);
+
+#ifdef LAYER_USE_PROFILER
+	if (Profiler::NumFrames() > 0)
+	{
+		// Main thread time minus what it spent waiting on fences/readback
+		const Profiler::FrameCapture& capture = Profiler::GetFrame(Profiler::NumFrames() - 1);
+		results.cpuTimes.emplace_back(static_cast<f64>(frameTime - std::min(capture.blockedTime, frameTime)) * nsToMs);
+
+		// GPU timestamps resolve a frame or two late, so this is an earlier frame's GPU time. Same distribution, just shifted.
+		for (const Profiler::Zone& zone : capture.zones)
+		{
+			if (zone.depth == 0 && strcmp(zone.name, "GPU Frame") == 0)
+			{
+				results.gpuTimes.emplace_back(static_cast<f64>(zone.end - zone.begin) * nsToMs);
+				break;
+			}
+		}
+	}
+#endif
+
+#ifdef LAYER_USE_MEMORY_TRACKING
+	u64 allocCount = 0;
+	for (u32 tag = 0; tag < MT_MAX_VALUE; tag++)
+	{
+		const MemoryUsageInfo usage = MemoryTracker::GetHostMemoryUsage(static_cast<MemoryTrackerTag>(tag));
+		allocCount += usage.allocations + usage.frees;
+		results.peakHostBytes[tag] = std::max(results.peakHostBytes[tag], usage.size);
+	}
+	if (lastAllocCount != 0)
+	{
+		results.allocsPerFrame.emplace_back(static_cast<f64>(allocCount - lastAllocCount));
+	}
+	lastAllocCount = allocCount;
+#endif
+
+	for (u32 tag = 0; tag < GPU_USAGE_MAX; tag++)
+	{
+		const MemoryUsageInfo& usage = GpuMemoryTracker::GetGpuMemoryUsage(static_cast<GpuMemoryUsageTag>(tag));
+		results.peakGpuBytes[tag] = std::max(results.peakGpuBytes[tag], usage.size);
+	}
+}
+
+i32 LayerBench::_Compare(i32 argc, char* argv[])
+{
+	if (argc < 2)
+	{
+		_PrintUsage();
+		return _exitError;
+	}
+
+	f64 thresholdPercent = _defaultThresholdPercent;
+	for (i32 i = 2; i < argc; i++)
+	{
+		const std::string_view arg = argv[i];
+		if (arg == "--threshold" && i + 1 < argc)
+		{
+			thresholdPercent = std::strtod(argv[++i], nullptr);
+			continue;
+		}
+		std::cerr << "Bad argument: " << arg << "\n";
+		_PrintUsage();
+		return _exitError;
+	}
+
+	const i32 regressions = CompareResults(argv[0], argv[1], thresholdPercent);
+	if (regressions < 0) { return _exitError; }
+	return regressions > 0 ? _exitRegressed : EXIT_SUCCESS;
+}
+
+i32 LayerBench::_Check(i32 argc, char* argv[])
+{
+	// Every check, or just the named ones
+	T_vector<const Check*, MT_ENGINE> checks;
+	for (i32 i = 0; i < argc; i++)
+	{
+		const Check* pCheck = FindCheck(argv[i]);
+		if (pCheck == nullptr)
+		{
+			std::cerr << "Unknown check: " << argv[i] << " (see LayerBench list)\n";
+			return _exitError;
+		}
+		checks.push_back(pCheck);
+	}
+	if (checks.empty())
+	{
+		for (const Check& check : GetChecks()) { checks.push_back(&check); }
+	}
+
+	u32 numFailed = 0;
+	for (const Check* pCheck : checks)
+	{
+		std::printf("%s\n", pCheck->name);
+		const bool bPassed = pCheck->pRun();
+		std::printf("    %s\n", bPassed ? "PASS" : "FAIL");
+		numFailed += bPassed ? 0 : 1;
+	}
+
+	std::printf("%u/%zu checks passed\n", static_cast<u32>(checks.size()) - numFailed, checks.size());
+	return numFailed > 0 ? _exitRegressed : EXIT_SUCCESS;
+}
+
+i32 LayerBench::_List()
+{
+	std::printf("Workloads:\n");
+	for (const Workload& workload : GetWorkloads())
+	{
+		std::printf("  %-20s %s\n", workload.name, workload.description);
+	}
+	std::printf("Checks:\n");
+	for (const Check& check : GetChecks())
+	{
+		std::printf("  %-20s %s\n", check.name, check.description);
+	}
+	return EXIT_SUCCESS;
+}
+
+
+int main(int argc, char* argv[])
+{
+	const std::string_view mode = (argc > 1) ? argv[1] : "run";
+
+	if (mode == "compare")	{ return LayerBench::_Compare(argc - 2, argv + 2); }
+	if (mode == "check")	{ return LayerBench::_Check(argc - 2, argv + 2); }
+	if (mode == "list")		{ return LayerBench::_List(); }
+	if (mode == "run")		{ return LayerBench::_Run(std::max(argc - 2, 0), argv + 2); }
+	if (mode == "--help" || mode == "-h")
+	{
+		LayerBench::_PrintUsage();
+		return EXIT_SUCCESS;
+	}
+
+	// Options without the explicit run mode
+	return LayerBench::_Run(argc - 1, argv + 1);
+}
@@ -0,0 +1,197 @@
+// LayerLogDecoder: turns binary session logs (Logs/SessionLog.bin, written with LAYER_BINARY_LOG) back into text.
+// Usage: LayerLogDecoder <SessionLog.bin>... [-o <output.txt>]
+// Several files (e.g. SessionLog.3.bin SessionLog.2.bin SessionLog.1.bin SessionLog.bin) are decoded one after another.
+#include "BinaryLogFormat.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+
+namespace LogDecoder
+{
+	// Matches LogSeverityLevel/the session log's prefixes
+	constexpr const char* _severityStrings[] = {
+		"[FATAL]: ",
+		"[ERROR]: ",
+		"[WARNING]: ",
+		"[INFO]: ",
+		"[BENCHMARK]: ",
+		"[DEBUG]: ",
+		"" // OTHER
+	};
+	constexpr u32 _severityWarning = 2;
+
+	// BLOG_RECORD_SITE read back out of the file
+	struct _Site
+	{
+		u32 severity = 0;
+		u32 line = 0;
+		std::vector<u8> argTypes;
+		std::string file;
+		std::string function;
+		std::string format;
+		bool bValid = false;
+	};
+
+	// Decodes one file into out, returns false if it isn't a binary log or ends in the middle of a record
+	bool _DecodeFile(const char* path, std::ostream& out);
+}
+
+bool LogDecoder::_DecodeFile(const char* path, std::ostream& out)
+{
+	std::ifstream file(path, std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cerr << "Couldn't open " << path << "\n";
+		return false;
+	}
+	const std::vector<u8> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	BinaryLogFileHeader fileHeader = {};
+	if (bytes.size() < sizeof(fileHeader))
+	{
+		std::cerr << path << " is too small to be a binary log\n";
+		return false;
+	}
+	memcpy(&fileHeader, bytes.data(), sizeof(fileHeader));
+	if (memcmp(fileHeader.magic, binaryLogMagic, sizeof(binaryLogMagic)) != 0 || fileHeader.version != binaryLogVersion)
+	{
+		std::cerr << path << " isn't a version " << binaryLogVersion << " binary log\n";
+		return false;
+	}
+
+	std::vector<_Site> sites;
+	std::string line;
+	const u8* pRead = bytes.data() + sizeof(fileHeader);
+	const u8* pEnd = bytes.data() + bytes.size();
+
+	const auto read = [&pRead, pEnd](auto& value)
+	{
+		if (pRead == nullptr || pEnd - pRead < static_cast<i64>(sizeof(value))) { pRead = nullptr; return; }
+		memcpy(&value, pRead, sizeof(value));
+		pRead += sizeof(value);
+	};
+	const auto readString = [&pRead, pEnd, &read](std::string& string)
+	{
+		u16 length = 0;
+		read(length);
+		if (pRead == nullptr || pEnd - pRead < length) { pRead = nullptr; return; }
+		string.assign(reinterpret_cast<const char*>(pRead), length);
+		pRead += length;
+	};
+
+	while (pRead != nullptr && pRead < pEnd)
+	{
+		u8 recordType = 0;
+		u32 siteId = 0;
+		read(recordType);
+		read(siteId);
+		if (pRead == nullptr) { break; }
+
+		if (recordType == BLOG_RECORD_SITE)
+		{
+			if (siteId >= sites.size()) { sites.resize(siteId + 1); }
+			_Site& site = sites[siteId];
+
+			u8 numArgs = 0;
+			read(site.severity);
+			read(site.line);
+			read(numArgs);
+			if (pRead == nullptr || pEnd - pRead < numArgs) { pRead = nullptr; break; }
+			site.argTypes.assign(pRead, pRead + numArgs);
+			pRead += numArgs;
+			readString(site.file);
+			readString(site.function);
+			readString(site.format);
+			site.bValid = true;
+		}
+		else if (recordType == BLOG_RECORD_MESSAGE)
+		{
+			u64 timestamp = 0;
+			read(timestamp);
+			if (pRead == nullptr) { break; }
+
+			if (siteId >= sites.size() || !sites[siteId].bValid)
+			{
+				// Can't know how long the arguments are without the site
+				std::cerr << path << ": message from undescribed site " << siteId << ", stopping\n";
+				return false;
+			}
+			const _Site& site = sites[siteId];
+
+			char time[32];
+			const f64 seconds = static_cast<f64>(static_cast<i64>(timestamp - fileHeader.startTimestamp)) / 1e9;
+			line.assign(time, snprintf(time, sizeof(time), "[%.6f] ", seconds));
+			line.append(site.severity < std::size(_severityStrings) ? _severityStrings[site.severity] : "");
+
+			pRead = AppendBinaryLogMessageText(line, site.format.c_str(), site.argTypes.data(), static_cast<u8>(site.argTypes.size()), pRead, pEnd);
+
+			// Same location info as the text session log
+			if (site.severity <= _severityWarning)
+			{
+				line.append(" >>> Line: ").append(std::to_string(site.line)).append(" | File: ").append(site.file).append(" | Function: ").append(site.function);
+			}
+			out << line << "\n";
+		}
+		else
+		{
+			std::cerr << path << ": unknown record type " << static_cast<u32>(recordType) << ", stopping\n";
+			return false;
+		}
+	}
+
+	if (pRead == nullptr)
+	{
+		std::cerr << path << " ends in the middle of a record\n";
+		return false;
+	}
+	return true;
+}
+
+
+int main(int argc, char* argv[])
+{
+	std::vector<const char*> inputPaths;
+	const char* outputPath = nullptr;
+
+	for (i32 i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+		{
+			outputPath = argv[++i];
+		}
+		else
+		{
+			inputPaths.push_back(argv[i]);
+		}
+	}
+
+	if (inputPaths.empty())
+	{
+		std::cerr << "Usage: LayerLogDecoder <SessionLog.bin>... [-o <output.txt>]\n";
+		return EXIT_FAILURE;
+	}
+
+	std::ofstream outputFile;
+	if (outputPath != nullptr)
+	{
+		outputFile.open(outputPath, std::ios::out | std::ios::trunc);
+		if (!outputFile.is_open())
+		{
+			std::cerr << "Couldn't open " << outputPath << " for writing\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::ostream& out = outputPath != nullptr ? outputFile : std::cout;
+
+	bool bDecodedAll = true;
+	for (const char* inputPath : inputPaths)
+	{
+		bDecodedAll &= LogDecoder::_DecodeFile(inputPath, out);
+	}
+
+	return bDecodedAll ? EXIT_SUCCESS : EXIT_FAILURE;
+}